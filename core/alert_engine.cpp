@@ -0,0 +1,467 @@
+#include "../include/alert_engine.h"
+#include "../include/disk_monitor.h"
+#include "../include/utils.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define RESET   "\033[0m"
+#define RED     "\033[31m"
+#define GREEN   "\033[32m"
+#define YELLOW  "\033[33m"
+#define CYAN    "\033[36m"
+
+extern char** environ;
+
+using namespace std;
+
+namespace {
+    string alertJson(const Alert& alert) {
+        ostringstream oss;
+        oss << "{\"rule\": \"" << Utils::jsonEscape(alert.rule) << "\", \"path\": \"" << Utils::jsonEscape(alert.path)
+            << "\", \"severity\": \"" << AlertEngine::severityName(alert.severity) << "\", \"value\": " << alert.value
+            << ", \"threshold\": " << alert.threshold << ", \"time\": " << alert.timestamp
+            << ", \"resolved\": " << (alert.resolved ? "true" : "false")
+            << ", \"message\": \"" << Utils::jsonEscape(alert.message) << "\"}";
+        return oss.str();
+    }
+
+    string formatTime(time_t t) {
+        char buf[32];
+        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime(&t));
+        return buf;
+    }
+
+    string expandHome(const string& path) {
+        if (!path.empty() && path[0] == '~') return Utils::getHomeDir() + path.substr(1);
+        return path;
+    }
+
+    string metricLabel(AlertMetric metric) {
+        switch (metric) {
+        case AlertMetric::FreeBytes:
+        case AlertMetric::FreePercent:       return "free space";
+        case AlertMetric::InodesFree:
+        case AlertMetric::InodesFreePercent: return "free inodes";
+        case AlertMetric::Growth:            return "growth";
+        case AlertMetric::TimeToFull:        return "time to full";
+        }
+        return "value";
+    }
+
+    bool parseMetric(const string& name, AlertMetric& metric) {
+        static const map<string, AlertMetric> names = {
+            {"free_bytes", AlertMetric::FreeBytes},
+            {"free_percent", AlertMetric::FreePercent},
+            {"inodes_free", AlertMetric::InodesFree},
+            {"inodes_free_percent", AlertMetric::InodesFreePercent},
+            {"growth", AlertMetric::Growth},
+            {"time_to_full", AlertMetric::TimeToFull},
+        };
+        auto it = names.find(name);
+        if (it == names.end()) return false;
+        metric = it->second;
+        return true;
+    }
+
+    // Threshold units follow the metric: sizes for free_bytes, "5G/h" for
+    // growth, durations for time_to_full, plain numbers otherwise
+    bool parseThreshold(AlertMetric metric, string text, double& value) {
+        if (metric == AlertMetric::FreeBytes) {
+            unsigned long long bytes;
+            if (!Utils::parseSize(text, bytes)) return false;
+            value = (double)bytes;
+            return true;
+        }
+        if (metric == AlertMetric::Growth) {
+            size_t slash = text.find('/');
+            string per = slash == string::npos ? "s" : text.substr(slash + 1);
+            if (!per.empty() && isalpha((unsigned char)per[0])) per = "1" + per;
+            unsigned long long bytes;
+            time_t seconds;
+            if (!Utils::parseSize(text.substr(0, slash), bytes) || !Utils::parseDuration(per, seconds) || seconds == 0) {
+                return false;
+            }
+            value = (double)bytes / seconds;
+            return true;
+        }
+        if (metric == AlertMetric::TimeToFull) {
+            time_t seconds;
+            if (!Utils::parseDuration(text, seconds)) return false;
+            value = (double)seconds;
+            return true;
+        }
+        if (!text.empty() && text.back() == '%') text.pop_back();
+        char* end = nullptr;
+        value = strtod(text.c_str(), &end);
+        return end != text.c_str() && *end == '\0';
+    }
+}
+
+// ===== Sinks =====
+void StdoutAlertSink::deliver(const Alert& alert) {
+    const char* color = alert.resolved ? GREEN : alert.severity == AlertSeverity::Critical ? RED : YELLOW;
+    cout << color << (alert.resolved ? "✅ [RESOLVED] " : "⚠️  [" + AlertEngine::severityName(alert.severity) + "] ")
+         << RESET << CYAN << alert.rule << RESET << " " << alert.path << ": " << alert.message << "\n" << flush;
+}
+
+LogFileAlertSink::LogFileAlertSink(const string& file) : logFile(expandHome(file)) {}
+
+void LogFileAlertSink::deliver(const Alert& alert) {
+    size_t slash = logFile.rfind('/');
+    if (slash != string::npos && slash > 0) {
+        string dir = logFile.substr(0, slash);
+        size_t parent = dir.rfind('/');
+        if (parent != string::npos && parent > 0) Utils::createDirectory(dir.substr(0, parent));
+        Utils::createDirectory(dir);
+    }
+
+    ofstream log(logFile, ios::app);
+    if (!log) return;
+    log << formatTime(alert.timestamp) << " | " << (alert.resolved ? "RESOLVED" : AlertEngine::severityName(alert.severity))
+        << " | " << alert.rule << " | " << alert.path << " | " << alert.message << "\n";
+}
+
+UnixSocketAlertSink::UnixSocketAlertSink(const string& path)
+    : socketPath(expandHome(path)), fd(socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0)) {}
+
+UnixSocketAlertSink::~UnixSocketAlertSink() {
+    if (fd >= 0) close(fd);
+}
+
+void UnixSocketAlertSink::deliver(const Alert& alert) {
+    if (fd < 0 || socketPath.size() >= sizeof(sockaddr_un::sun_path)) return;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    string payload = alertJson(alert);
+    sendto(fd, payload.data(), payload.size(), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+}
+
+ExecAlertSink::ExecAlertSink(const string& cmd) : command(cmd) {}
+
+void ExecAlertSink::deliver(const Alert& alert) {
+    // Everything the child needs is prepared before fork(); after it only
+    // async-signal-safe calls are made.
+    vector<string> env;
+    for (char** e = environ; e && *e; ++e) env.push_back(*e);
+    env.push_back("SPACEMATE_ALERT_RULE=" + alert.rule);
+    env.push_back("SPACEMATE_ALERT_PATH=" + alert.path);
+    env.push_back("SPACEMATE_ALERT_SEVERITY=" + AlertEngine::severityName(alert.severity));
+    env.push_back("SPACEMATE_ALERT_STATE=" + string(alert.resolved ? "resolved" : "firing"));
+    env.push_back("SPACEMATE_ALERT_VALUE=" + to_string(alert.value));
+    env.push_back("SPACEMATE_ALERT_THRESHOLD=" + to_string(alert.threshold));
+    env.push_back("SPACEMATE_ALERT_MESSAGE=" + alert.message);
+    vector<char*> envp;
+    for (auto& entry : env) envp.push_back(&entry[0]);
+    envp.push_back(nullptr);
+
+    // Double fork so the hook is reparented and never becomes a zombie
+    pid_t child = fork();
+    if (child == 0) {
+        if (fork() == 0) {
+            execle("/bin/sh", "sh", "-c", command.c_str(), (char*)nullptr, envp.data());
+            _exit(127);
+        }
+        _exit(0);
+    }
+    if (child > 0) waitpid(child, nullptr, 0);
+}
+
+// ===== Configuration =====
+string AlertEngine::defaultConfigFile() {
+    return Utils::getHomeDir() + "/.spacemate/alerts.conf";
+}
+
+bool AlertEngine::loadConfig(const string& file, string* error) {
+    ifstream in(file);
+    if (!in) {
+        if (error) *error = "cannot open " + file;
+        return false;
+    }
+
+    vector<AlertRule> parsedRules;
+    vector<shared_ptr<AlertSink>> parsedSinks;
+    string line;
+    int lineNo = 0;
+    auto fail = [&](const string& why) {
+        if (error) *error = file + ":" + to_string(lineNo) + ": " + why;
+        return false;
+    };
+
+    while (getline(in, line)) {
+        lineNo++;
+        size_t start = line.find_first_not_of(" \t");
+        if (start == string::npos || line[start] == '#') continue;
+
+        istringstream tokens(line.substr(start));
+        string kind;
+        tokens >> kind;
+
+        if (kind == "sink") {
+            string type, target;
+            tokens >> type;
+            getline(tokens >> ws, target);
+            if (type == "stdout") parsedSinks.push_back(make_shared<StdoutAlertSink>());
+            else if (type == "log" && !target.empty()) parsedSinks.push_back(make_shared<LogFileAlertSink>(target));
+            else if (type == "socket" && !target.empty()) parsedSinks.push_back(make_shared<UnixSocketAlertSink>(target));
+            else if (type == "exec" && !target.empty()) parsedSinks.push_back(make_shared<ExecAlertSink>(target));
+            else return fail("unknown sink '" + type + "'");
+            continue;
+        }
+        if (kind != "rule") return fail("expected 'rule' or 'sink'");
+
+        map<string, string> fields;
+        string token;
+        while (tokens >> token) {
+            size_t eq = token.find('=');
+            if (eq == string::npos) return fail("expected key=value, got '" + token + "'");
+            fields[token.substr(0, eq)] = token.substr(eq + 1);
+        }
+
+        AlertRule rule;
+        rule.name = fields.count("name") ? fields["name"] : "rule" + to_string(lineNo);
+        if (fields.count("path")) rule.path = fields["path"];
+        if (fields.count("metric") && !parseMetric(fields["metric"], rule.metric)) {
+            return fail("unknown metric '" + fields["metric"] + "'");
+        }
+
+        if (fields.count("below") == fields.count("above")) return fail("give exactly one of below= or above=");
+        rule.below = fields.count("below") > 0;
+        if (!parseThreshold(rule.metric, rule.below ? fields["below"] : fields["above"], rule.threshold)) {
+            return fail("bad threshold");
+        }
+        if (fields.count("clear")) {
+            if (!parseThreshold(rule.metric, fields["clear"], rule.clear)) return fail("bad clear value");
+        } else {
+            rule.clear = rule.threshold * (rule.below ? 1.05 : 0.95);
+        }
+        if (fields.count("window") && !Utils::parseDuration(fields["window"], rule.window)) return fail("bad window");
+        if (fields.count("cooldown") && !Utils::parseDuration(fields["cooldown"], rule.cooldown)) return fail("bad cooldown");
+        if (fields.count("severity")) {
+            const string& sev = fields["severity"];
+            if (sev == "info") rule.severity = AlertSeverity::Info;
+            else if (sev == "warning") rule.severity = AlertSeverity::Warning;
+            else if (sev == "critical") rule.severity = AlertSeverity::Critical;
+            else return fail("unknown severity '" + sev + "'");
+        }
+        parsedRules.push_back(rule);
+    }
+
+    clearRules();
+    for (const auto& rule : parsedRules) addRule(rule);
+    lock_guard<mutex> lock(engineMutex);
+    sinks = parsedSinks;
+    return true;
+}
+
+void AlertEngine::loadDefaults() {
+    clearRules();
+
+    AlertRule usage;
+    usage.name = "usage-high";
+    usage.threshold = 25;   // i.e. more than 75% used
+    usage.clear = 27;
+    addRule(usage);
+
+    AlertRule critical;
+    critical.name = "space-critical";
+    critical.threshold = 10;
+    critical.clear = 12;
+    critical.severity = AlertSeverity::Critical;
+    addRule(critical);
+
+    AlertRule filling;
+    filling.name = "filling-up";
+    filling.metric = AlertMetric::TimeToFull;
+    filling.threshold = 3 * 3600;
+    filling.clear = 4 * 3600;
+    filling.severity = AlertSeverity::Critical;
+    addRule(filling);
+
+    // Millions of tiny files exhaust the inode table long before the bytes
+    AlertRule inodes;
+    inodes.name = "inodes-low";
+    inodes.metric = AlertMetric::InodesFreePercent;
+    inodes.threshold = 10;
+    inodes.clear = 12;
+    inodes.severity = AlertSeverity::Critical;
+    addRule(inodes);
+}
+
+// ===== Rules and sinks =====
+void AlertEngine::indexRule(size_t index) {
+    const string& path = ruleList[index].path;
+    if (path == "*") wildcardRules.push_back(index);
+    else rulesByPath[path].push_back(index);
+}
+
+void AlertEngine::addRule(const AlertRule& rule) {
+    lock_guard<mutex> lock(engineMutex);
+    ruleList.push_back(rule);
+    states.emplace_back();
+    indexRule(ruleList.size() - 1);
+}
+
+void AlertEngine::clearRules() {
+    lock_guard<mutex> lock(engineMutex);
+    ruleList.clear();
+    states.clear();
+    rulesByPath.clear();
+    wildcardRules.clear();
+}
+
+vector<AlertRule> AlertEngine::rules() const {
+    lock_guard<mutex> lock(engineMutex);
+    return ruleList;
+}
+
+void AlertEngine::addSink(shared_ptr<AlertSink> sink) {
+    lock_guard<mutex> lock(engineMutex);
+    sinks.push_back(move(sink));
+}
+
+void AlertEngine::removeSink(const shared_ptr<AlertSink>& sink) {
+    lock_guard<mutex> lock(engineMutex);
+    sinks.erase(remove(sinks.begin(), sinks.end(), sink), sinks.end());
+}
+
+void AlertEngine::clearSinks() {
+    lock_guard<mutex> lock(engineMutex);
+    sinks.clear();
+}
+
+size_t AlertEngine::sinkCount() const {
+    lock_guard<mutex> lock(engineMutex);
+    return sinks.size();
+}
+
+// ===== Evaluation =====
+vector<Alert> AlertEngine::evaluate(const DiskSample& sample, const GrowthProvider& growth) {
+    vector<Alert> raised;
+    vector<shared_ptr<AlertSink>> targets;
+    {
+        lock_guard<mutex> lock(engineMutex);
+        map<time_t, double> growthByWindow;   // rules sharing a window share the computation
+
+        auto evaluateRule = [&](size_t index) {
+            const AlertRule& rule = ruleList[index];
+            double value;
+            switch (rule.metric) {
+            case AlertMetric::FreeBytes:
+                value = (double)sample.available;
+                break;
+            case AlertMetric::FreePercent:
+                if (sample.total == 0) return;
+                value = sample.available * 100.0 / sample.total;
+                break;
+            case AlertMetric::InodesFree:
+                if (sample.inodesTotal == 0) return;   // filesystems without an inode limit
+                value = (double)sample.inodesFree;
+                break;
+            case AlertMetric::InodesFreePercent:
+                if (sample.inodesTotal == 0) return;
+                value = sample.inodesFree * 100.0 / sample.inodesTotal;
+                break;
+            case AlertMetric::Growth: {
+                if (!growth) return;
+                auto cached = growthByWindow.find(rule.window);
+                value = cached != growthByWindow.end()
+                    ? cached->second
+                    : (growthByWindow[rule.window] = growth(sample.path, rule.window));
+                break;
+            }
+            case AlertMetric::TimeToFull:
+                value = sample.secondsToFull < 0 ? INFINITY : sample.secondsToFull;
+                break;
+            default:
+                return;
+            }
+
+            RuleState& state = states[index][sample.path];
+            bool crossed = rule.below ? value < rule.threshold : value > rule.threshold;
+            bool cleared = rule.below ? value >= rule.clear : value <= rule.clear;
+
+            Alert alert{rule.name, sample.path, rule.severity, value, rule.threshold, sample.timestamp, false, ""};
+            if (!state.active && crossed) {
+                if (state.lastNotified && sample.timestamp - state.lastNotified < rule.cooldown) return;
+                state.active = true;
+                state.lastNotified = sample.timestamp;
+                alert.message = metricLabel(rule.metric) + " " + formatValue(rule.metric, value) +
+                                (rule.below ? " is below " : " is above ") + formatValue(rule.metric, rule.threshold);
+                raised.push_back(alert);
+            } else if (state.active && cleared) {
+                state.active = false;
+                alert.resolved = true;
+                alert.message = metricLabel(rule.metric) + " back to " + formatValue(rule.metric, value);
+                raised.push_back(alert);
+            }
+        };
+
+        auto exact = rulesByPath.find(sample.path);
+        if (exact != rulesByPath.end()) {
+            for (size_t index : exact->second) evaluateRule(index);
+        }
+        for (size_t index : wildcardRules) evaluateRule(index);
+        if (!raised.empty()) targets = sinks;
+    }
+
+    for (const auto& alert : raised) {
+        for (const auto& sink : targets) sink->deliver(alert);
+    }
+    return raised;
+}
+
+// ===== Formatting =====
+string AlertEngine::metricName(AlertMetric metric) {
+    switch (metric) {
+    case AlertMetric::FreeBytes:         return "free_bytes";
+    case AlertMetric::FreePercent:       return "free_percent";
+    case AlertMetric::InodesFree:        return "inodes_free";
+    case AlertMetric::InodesFreePercent: return "inodes_free_percent";
+    case AlertMetric::Growth:            return "growth";
+    case AlertMetric::TimeToFull:        return "time_to_full";
+    }
+    return "unknown";
+}
+
+string AlertEngine::severityName(AlertSeverity severity) {
+    switch (severity) {
+    case AlertSeverity::Info:     return "INFO";
+    case AlertSeverity::Warning:  return "WARNING";
+    case AlertSeverity::Critical: return "CRITICAL";
+    }
+    return "UNKNOWN";
+}
+
+string AlertEngine::formatValue(AlertMetric metric, double value) {
+    ostringstream oss;
+    switch (metric) {
+    case AlertMetric::FreeBytes:
+        return Utils::formatSize((unsigned long long)max(0.0, value));
+    case AlertMetric::FreePercent:
+    case AlertMetric::InodesFreePercent:
+        oss << fixed << setprecision(1) << value << "%";
+        return oss.str();
+    case AlertMetric::InodesFree:
+        oss << (unsigned long long)max(0.0, value);
+        return oss.str();
+    case AlertMetric::Growth:
+        return (value < 0 ? "-" : "+") + Utils::formatSize((unsigned long long)fabs(value * 3600)) + "/h";
+    case AlertMetric::TimeToFull:
+        return isinf(value) ? "never" : Utils::formatDuration(value);
+    }
+    return to_string(value);
+}
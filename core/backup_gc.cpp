@@ -0,0 +1,193 @@
+#include "../include/backup_gc.h"
+#include "../include/object_store.h"
+#include "../include/pack_store.h"
+#include "../include/settings.h"
+#include "../include/utils.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <sys/stat.h>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+    // Orphans younger than this may belong to a session still running
+    const time_t SWEEP_GRACE_SECONDS = 24 * 60 * 60;
+
+    struct Session {
+        string id;
+        time_t started = 0;
+        vector<size_t> entries;   // slots in the entry list
+    };
+
+    bool untouchedSince(const fs::path& path, time_t cutoff) {
+        struct stat st;
+        return lstat(path.c_str(), &st) == 0 && st.st_mtime < cutoff;
+    }
+}
+
+BackupGc::BackupGc(BackupManager& manager) : backups(manager) {}
+
+RetentionPolicy BackupGc::loadPolicy() {
+    Settings settings;
+    settings.load();
+    RetentionPolicy policy;
+    policy.keepLast = max(0LL, settings.getInt("backup", "keep_last", 0));
+    policy.keepDays = max(0LL, settings.getInt("backup", "keep_days", settings.getInt("cleanup", "backup_retention_days", 0)));
+    string maxSize = settings.get("backup", "max_size", "");
+    if (!maxSize.empty() && !Utils::parseSize(maxSize, policy.maxBytes)) policy.maxBytes = 0;
+    return policy;
+}
+
+// ===== Planning =====
+GcPlan BackupGc::plan(const RetentionPolicy& policy) {
+    GcPlan plan;
+    vector<BackupEntry> entries = backups.loadBackupIndex();
+
+    // Sessions in the order they were written; entries come oldest first
+    vector<Session> sessions;
+    unordered_map<string, size_t> sessionSlot;
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto slot = sessionSlot.emplace(entries[i].timestamp, sessions.size());
+        if (slot.second) {
+            sessions.emplace_back();
+            sessions.back().id = entries[i].timestamp;
+            Utils::parseTimestamp(entries[i].timestamp, sessions.back().started);
+        }
+        sessions[slot.first->second].entries.push_back(i);
+    }
+    plan.sessions = sessions.size();
+
+    // Reference counts per stored object; packed objects share a file
+    unordered_map<string, unsigned long long> objectBytes;
+    unordered_map<string, size_t> references;
+    for (const auto& entry : entries) {
+        string key = entry.backupPath + "|" + entry.hash;
+        if (references[key]++ == 0) {
+            objectBytes[key] = entry.storedSize;
+            plan.storedBytes += entry.storedSize;
+        }
+    }
+    if (!policy.limited()) return plan;
+
+    vector<bool> evicted(sessions.size(), false);
+    unordered_set<string> packs;
+    auto evict = [&](size_t s) {
+        evicted[s] = true;
+        plan.evictedSessions++;
+        for (size_t slot : sessions[s].entries) {
+            const BackupEntry& entry = entries[slot];
+            string key = entry.backupPath + "|" + entry.hash;
+            plan.evict.push_back(entry.id);
+            if (--references[key] == 0) plan.freedBytes += objectBytes[key];
+            if (PackStore::isPack(entry.backupPath) && packs.insert(entry.backupPath).second) {
+                plan.packs.push_back(entry.backupPath);
+            }
+        }
+    };
+
+    // Count and age first, oldest first
+    time_t cutoff = time(nullptr) - (time_t)policy.keepDays * 24 * 60 * 60;
+    for (size_t s = 0; s < sessions.size(); s++) {
+        size_t newer = sessions.size() - 1 - s;
+        bool tooMany = policy.keepLast > 0 && newer >= policy.keepLast;
+        bool tooOld = policy.keepDays > 0 && sessions[s].started > 0 && sessions[s].started < cutoff;
+        if (tooMany || tooOld) evict(s);
+    }
+
+    // Then the oldest remaining sessions until the store fits; the newest
+    // session is always kept
+    for (size_t s = 0; policy.maxBytes > 0 && s + 1 < sessions.size(); s++) {
+        if (plan.storedBytes - plan.freedBytes <= policy.maxBytes) break;
+        if (!evicted[s]) evict(s);
+    }
+    return plan;
+}
+
+// ===== Collecting =====
+GcReport BackupGc::run(const GcPlan& plan, size_t batchSize) {
+    GcReport report;
+    auto start = chrono::steady_clock::now();
+
+    // Batches keep each index write and its deletions short
+    batchSize = max<size_t>(batchSize, 1);
+    for (size_t i = 0; i < plan.evict.size(); i += batchSize) {
+        vector<uint64_t> batch(plan.evict.begin() + i, plan.evict.begin() + min(plan.evict.size(), i + batchSize));
+        backups.removeBackups(batch);
+        const RemovalReport& removal = backups.lastRemoval();
+        report.entriesRemoved += removal.entries;
+        report.filesRemoved += removal.files;
+        report.bytesFreed += removal.bytes;
+    }
+    {
+        // Sessions still writing wait until the store is consistent again
+        StoreLock lock(backups.getObjectDir(), true);
+        rewritePacks(plan.packs, report);
+        sweep(report);
+    }
+
+    report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+void BackupGc::rewritePacks(const vector<string>& packs, GcReport& report) {
+    if (packs.empty()) return;
+    unordered_map<string, unordered_set<string>> live;
+    unordered_map<string, unsigned long long> liveBytes;
+    for (const auto& entry : backups.loadBackupIndex()) {
+        if (PackStore::isPack(entry.backupPath) && live[entry.backupPath].insert(entry.hash).second) {
+            liveBytes[entry.backupPath] += entry.storedSize;
+        }
+    }
+    BackupIndex& index = backups.getIndex();
+    for (const auto& pack : packs) {
+        struct stat st;
+        if (stat(pack.c_str(), &st) != 0 || !live.count(pack)) continue;   // already deleted as a whole
+        if (liveBytes[pack] * 2 >= (unsigned long long)st.st_size) continue;
+        unsigned long long saved = 0;
+        string rewritten = PackStore::rewritePack(pack, live[pack], saved);
+        if (rewritten.empty()) continue;
+        // The backups move to the new pack before the old one is deleted;
+        // whichever of the two nothing refers to after a crash is swept
+        if (!index.relocate(pack, rewritten)) {
+            PackStore::removePack(rewritten);
+            continue;
+        }
+        PackStore::removePack(pack);
+        report.packsRewritten++;
+        report.bytesFreed += saved;
+    }
+}
+
+void BackupGc::sweep(GcReport& report) {
+    BackupIndex& index = backups.getIndex();
+    ObjectStore store(backups.getObjectDir());
+    time_t cutoff = time(nullptr) - SWEEP_GRACE_SECONDS;
+    error_code ec;
+
+    vector<fs::path> orphans;
+    auto walk = fs::recursive_directory_iterator(store.root(), ec);
+    for (; !ec && walk != fs::recursive_directory_iterator(); walk.increment(ec)) {
+        error_code entryError;
+        if (!walk->is_regular_file(entryError)) continue;
+        const fs::path& path = walk->path();
+        string name = path.filename().string();
+        bool temporary = name[0] == '.' && path.extension() == ".tmp";   // an interrupted put()
+        bool object = !store.hashOf(path.string()).empty() || PackStore::isPack(path.string());
+        if (!(temporary || (object && index.references(path.string()) == 0))) continue;
+        if (untouchedSince(path, cutoff)) orphans.push_back(path);
+    }
+
+    for (const auto& path : orphans) {
+        error_code removeError;
+        unsigned long long size = fs::file_size(path, removeError);
+        bool removed = PackStore::isPack(path.string()) ? PackStore::removePack(path.string()) : fs::remove(path, removeError);
+        if (!removed) continue;
+        report.filesRemoved++;
+        report.bytesFreed += size;
+    }
+}
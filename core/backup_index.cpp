@@ -0,0 +1,403 @@
+#include "../include/backup_index.h"
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ctime>
+
+using namespace std;
+
+namespace {
+    const char MAGIC[8] = {'S', 'M', 'B', 'I', 'D', 'X', '0', '1'};
+    const uint32_t FORMAT_VERSION = 1;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t generation;   // new for every file written from scratch
+    };
+
+    // Followed by `length` bytes of payload
+    struct RecordHeader {
+        uint32_t length;
+        uint8_t type;
+        uint8_t reserved[3];
+    };
+
+    // NextId starts a compacted file: the id to hand out next, which the
+    // dropped tombstones would otherwise take with them. Moved repoints
+    // the entries stored in one file (a pack) at the file that replaced it.
+    enum RecordType : uint8_t { EntryRecord = 1, Tombstone = 2, NextId = 3, Moved = 4 };
+
+    const size_t COMPACT_MIN_REMOVED = 256;
+
+    int openLocked(const string& file, int flags) {
+        // Compaction replaces the file by rename; retry until the lock is
+        // held on the inode that is actually at `file`.
+        for (int attempt = 0; attempt < 5; attempt++) {
+            int fd = open(file.c_str(), flags, 0644);
+            if (fd < 0) return -1;
+            if (flock(fd, LOCK_EX) != 0) { close(fd); return -1; }
+
+            struct stat opened, current;
+            if (fstat(fd, &opened) == 0 && stat(file.c_str(), &current) == 0 &&
+                opened.st_ino == current.st_ino) {
+                return fd;
+            }
+            close(fd);
+        }
+        return -1;
+    }
+
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = write(fd, p, size);
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    template <typename T>
+    void putValue(string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void putString(string& out, const string& s) {
+        putValue<uint32_t>(out, s.size());
+        out += s;
+    }
+
+    template <typename T>
+    bool getValue(const char*& p, const char* end, T& value) {
+        if (end - p < (ptrdiff_t)sizeof(T)) return false;
+        memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    bool getString(const char*& p, const char* end, string& s) {
+        uint32_t length;
+        if (!getValue(p, end, length) || end - p < (ptrdiff_t)length) return false;
+        s.assign(p, length);
+        p += length;
+        return true;
+    }
+
+    void putRecord(string& out, uint8_t type, const string& payload) {
+        RecordHeader header = {(uint32_t)payload.size(), type, {0, 0, 0}};
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out += payload;
+    }
+
+    string encodeEntry(const BackupEntry& entry) {
+        string payload;
+        putValue<uint64_t>(payload, entry.id);
+        putValue<uint64_t>(payload, entry.size);
+        putValue<uint64_t>(payload, entry.storedSize);
+        putString(payload, entry.timestamp);
+        putString(payload, entry.originalPath);
+        putString(payload, entry.backupPath);
+        putString(payload, entry.hash);
+        putString(payload, entry.codec);
+        putValue<uint32_t>(payload, entry.mode);
+        putValue<uint32_t>(payload, entry.uid);
+        putValue<uint32_t>(payload, entry.gid);
+        putValue<int64_t>(payload, entry.mtime.tv_sec);
+        putValue<uint32_t>(payload, entry.mtime.tv_nsec);
+        string record;
+        putRecord(record, EntryRecord, payload);
+        return record;
+    }
+
+    string fileHeader() {
+        FileHeader header;
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = FORMAT_VERSION;
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        header.generation = (uint32_t)(now.tv_sec * 1000003 + now.tv_nsec) ^ (uint32_t)getpid();
+        return string(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+}
+
+BackupIndex::BackupIndex(const string& file) : indexFile(file) {}
+
+void BackupIndex::reset() {
+    records.clear();
+    live.clear();
+    byId.clear();
+    byPath.clear();
+    referenceCount.clear();
+    liveCount = 0;
+    nextId = 1;
+    parsedTo = 0;
+    parsedInode = 0;
+    parsedGeneration = 0;
+}
+
+// ===== Reading =====
+bool BackupIndex::refresh() {
+    struct stat st;
+    if (stat(indexFile.c_str(), &st) != 0) {
+        reset();
+        return true;   // no backups yet
+    }
+    if (st.st_ino != parsedInode || st.st_size < parsedTo) {
+        reset();   // replaced by compaction
+        parsedInode = st.st_ino;
+    }
+    if (st.st_size == parsedTo || st.st_size < (off_t)sizeof(FileHeader)) return true;
+
+    int fd = open(indexFile.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return false;
+
+    const char* base = static_cast<const char*>(addr);
+    const FileHeader* header = static_cast<const FileHeader*>(addr);
+    bool ok = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 && header->version == FORMAT_VERSION;
+    if (ok && parsedTo > 0 && header->generation != parsedGeneration) {
+        reset();   // a different file that happens to reuse the inode
+        parsedInode = st.st_ino;
+    }
+    if (ok) {
+        parsedGeneration = header->generation;
+        // Only what was appended since the last read; a partial record at
+        // the end (an append in progress) waits for the next refresh
+        off_t offset = max(parsedTo, (off_t)sizeof(FileHeader));
+        while (offset + (off_t)sizeof(RecordHeader) <= st.st_size) {
+            RecordHeader record;
+            memcpy(&record, base + offset, sizeof(record));
+            off_t end = offset + sizeof(RecordHeader) + record.length;
+            if (end > st.st_size) break;
+            apply(base + offset + sizeof(RecordHeader), record.type, record.length);
+            offset = end;
+        }
+        parsedTo = offset;
+    }
+    munmap(addr, st.st_size);
+    return ok;
+}
+
+void BackupIndex::apply(const char* record, uint8_t type, uint32_t length) {
+    const char* p = record;
+    const char* end = record + length;
+
+    if (type == Tombstone) {
+        uint64_t id;
+        if (!getValue(p, end, id)) return;
+        auto slot = byId.find(id);
+        if (slot == byId.end() || !live[slot->second]) return;
+        live[slot->second] = false;
+        liveCount--;
+        auto refs = referenceCount.find(records[slot->second].backupPath);
+        if (refs != referenceCount.end() && --refs->second == 0) referenceCount.erase(refs);
+        return;
+    }
+    if (type == NextId) {
+        uint64_t id;
+        if (getValue(p, end, id)) nextId = max(nextId, id);
+        return;
+    }
+    if (type == Moved) {
+        string from, to;
+        if (!getString(p, end, from) || !getString(p, end, to)) return;
+        for (auto& entry : records) {
+            if (entry.backupPath == from) entry.backupPath = to;
+        }
+        auto refs = referenceCount.find(from);
+        if (refs == referenceCount.end()) return;
+        size_t moved = refs->second;
+        referenceCount.erase(refs);
+        referenceCount[to] += moved;
+        return;
+    }
+    if (type != EntryRecord) return;   // written by a newer version
+
+    BackupEntry entry;
+    uint64_t size, storedSize;
+    if (!getValue(p, end, entry.id) || !getValue(p, end, size) || !getValue(p, end, storedSize) ||
+        !getString(p, end, entry.timestamp) || !getString(p, end, entry.originalPath) ||
+        !getString(p, end, entry.backupPath) || !getString(p, end, entry.hash) ||
+        !getString(p, end, entry.codec) || byId.count(entry.id)) {
+        return;
+    }
+    entry.size = size;
+    entry.storedSize = storedSize;
+    // The original's metadata; mode 0 when it was not recorded
+    int64_t seconds;
+    uint32_t nanoseconds;
+    if (getValue(p, end, entry.mode) && getValue(p, end, entry.uid) && getValue(p, end, entry.gid) &&
+        getValue(p, end, seconds) && getValue(p, end, nanoseconds)) {
+        entry.mtime.tv_sec = seconds;
+        entry.mtime.tv_nsec = nanoseconds;
+    } else {
+        entry.mode = 0;
+    }
+
+    size_t slot = records.size();
+    byId[entry.id] = slot;
+    byPath[entry.originalPath].push_back(slot);
+    referenceCount[entry.backupPath]++;
+    nextId = max(nextId, entry.id + 1);
+    liveCount++;
+    records.push_back(move(entry));
+    live.push_back(true);
+}
+
+vector<BackupEntry> BackupIndex::entries() {
+    lock_guard<mutex> lock(indexMutex);
+    refresh();
+    vector<BackupEntry> result;
+    result.reserve(liveCount);
+    for (size_t i = 0; i < records.size(); i++) {
+        if (live[i]) result.push_back(records[i]);
+    }
+    return result;
+}
+
+bool BackupIndex::find(uint64_t id, BackupEntry& entry) {
+    lock_guard<mutex> lock(indexMutex);
+    refresh();
+    auto slot = byId.find(id);
+    if (slot == byId.end() || !live[slot->second]) return false;
+    entry = records[slot->second];
+    return true;
+}
+
+vector<BackupEntry> BackupIndex::forPath(const string& originalPath) {
+    lock_guard<mutex> lock(indexMutex);
+    refresh();
+    vector<BackupEntry> result;
+    auto slots = byPath.find(originalPath);
+    if (slots == byPath.end()) return result;
+    for (size_t slot : slots->second) {
+        if (live[slot]) result.push_back(records[slot]);
+    }
+    return result;
+}
+
+size_t BackupIndex::references(const string& backupPath) {
+    lock_guard<mutex> lock(indexMutex);
+    refresh();
+    auto refs = referenceCount.find(backupPath);
+    return refs == referenceCount.end() ? 0 : refs->second;
+}
+
+size_t BackupIndex::size() {
+    lock_guard<mutex> lock(indexMutex);
+    refresh();
+    return liveCount;
+}
+
+// ===== Writing =====
+bool BackupIndex::append(vector<BackupEntry>& added) {
+    if (added.empty()) return true;
+    lock_guard<mutex> lock(indexMutex);
+    int fd = openLocked(indexFile, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC);
+    if (fd < 0) return false;
+    refresh();   // ids other processes handed out meanwhile
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    string buffer = st.st_size == 0 ? fileHeader() : "";
+    for (auto& entry : added) {
+        entry.id = nextId++;
+        buffer += encodeEntry(entry);
+    }
+    bool ok = writeAll(fd, buffer.data(), buffer.size());
+    // A short write would leave a torn record that hides every later one
+    if (!ok) ftruncate(fd, st.st_size);
+    close(fd);
+    refresh();
+    return ok;
+}
+
+bool BackupIndex::remove(const vector<uint64_t>& ids) {
+    bool ok;
+    {
+        lock_guard<mutex> lock(indexMutex);
+        int fd = openLocked(indexFile, O_RDWR | O_APPEND | O_CLOEXEC);
+        if (fd < 0) return false;
+        refresh();
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+
+        string buffer;
+        for (uint64_t id : ids) {
+            auto slot = byId.find(id);
+            if (slot == byId.end() || !live[slot->second]) continue;
+            string payload;
+            putValue<uint64_t>(payload, id);
+            putRecord(buffer, Tombstone, payload);
+        }
+        ok = writeAll(fd, buffer.data(), buffer.size());
+        if (!ok) ftruncate(fd, st.st_size);
+        close(fd);
+        refresh();
+        size_t removed = records.size() - liveCount;
+        if (!ok || removed < COMPACT_MIN_REMOVED || removed < liveCount) return ok;
+    }
+    compact();
+    return ok;
+}
+
+bool BackupIndex::relocate(const string& from, const string& to) {
+    lock_guard<mutex> lock(indexMutex);
+    int fd = openLocked(indexFile, O_RDWR | O_APPEND | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    string payload, buffer;
+    putString(payload, from);
+    putString(payload, to);
+    putRecord(buffer, Moved, payload);
+    // Synced, since the caller deletes `from` next
+    bool ok = writeAll(fd, buffer.data(), buffer.size()) && fsync(fd) == 0;
+    if (!ok) ftruncate(fd, st.st_size);
+    close(fd);
+    refresh();
+    return ok;
+}
+
+bool BackupIndex::compact() {
+    lock_guard<mutex> lock(indexMutex);
+    int fd = openLocked(indexFile, O_RDWR | O_CLOEXEC);
+    if (fd < 0) return false;
+    refresh();
+
+    string buffer = fileHeader();
+    string next;
+    putValue<uint64_t>(next, nextId);   // removed ids are never handed out again
+    putRecord(buffer, NextId, next);
+    for (size_t i = 0; i < records.size(); i++) {
+        if (live[i]) buffer += encodeEntry(records[i]);
+    }
+    string tmpFile = indexFile + ".tmp";
+    int out = open(tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = out >= 0 && writeAll(out, buffer.data(), buffer.size()) && fsync(out) == 0;
+    if (out >= 0) close(out);
+    ok = ok && rename(tmpFile.c_str(), indexFile.c_str()) == 0;
+    if (!ok) unlink(tmpFile.c_str());
+
+    close(fd);
+    refresh();
+    return ok;
+}
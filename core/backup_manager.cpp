@@ -1,11 +1,20 @@
 #include "../include/backup_manager.h"
 #include "../include/utils.h"
+#include "../include/backup_session.h"
+#include "../include/backup_gc.h"
+#include "../include/backup_restorer.h"
+#include "../include/backup_verifier.h"
+#include "../include/settings.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <sstream>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <filesystem>
+#include <cstring>
+#include <set>
 
 #define RESET   "\033[0m"
 #define GREEN   "\033[32m"
@@ -18,54 +27,81 @@ namespace fs = std::filesystem;
 
 // ===== Helper: get backup directory =====
 string BackupManager::getBackupDir() {
+    if (!backupDir.empty()) return backupDir;
     string baseDir = Utils::getHomeDir() + "/.spacemate";
     Utils::createDirectory(baseDir);
-    string backupDir = baseDir + "/backup";
+    backupDir = baseDir + "/backup";
     Utils::createDirectory(backupDir);
     return backupDir;
 }
 
+string BackupManager::getObjectDir() {
+    return getBackupDir() + "/objects";
+}
+
+// ===== Compression settings =====
+const CompressionSettings& BackupManager::getCompression() {
+    if (compressionLoaded) return compression;
+    compressionLoaded = true;
+
+    Settings settings;
+    settings.load();
+    string codec = settings.get("backup", "compression", "none");
+    if (!Compressor::parse(codec, compression.codec) || !Compressor::available(compression.codec)) {
+        cerr << YELLOW << "⚠️  Compression '" << codec << "' is not available; backups are stored uncompressed\n" << RESET;
+        compression.codec = Codec::None;
+    }
+    compression.level = settings.getInt("backup", "compression_level", 0);
+    compression.threads = settings.getInt("backup", "compression_threads", TaskPool::defaultThreads());
+    return compression;
+}
+
+const PackSettings& BackupManager::getPacking() {
+    if (packingLoaded) return packing;
+    packingLoaded = true;
+
+    Settings settings;
+    settings.load();
+    packing.enabled = settings.getBool("backup", "pack_small_files", false);
+    packing.threshold = (unsigned long long)max(1LL, settings.getInt("backup", "pack_threshold_kb", 64)) << 10;
+    packing.packSize = (unsigned long long)max(1LL, settings.getInt("backup", "pack_size_mb", 256)) << 20;
+    return packing;
+}
+
 // ===== CLI method: create backup for a single file =====
 string BackupManager::createBackup(const string& filepath) {
     if (!Utils::fileExists(filepath)) return "";
 
-    string backupDir = getBackupDir() + "/" + Utils::getCurrentTimestamp();
-    Utils::createDirectory(backupDir);
-
-    string filename = filepath.substr(filepath.find_last_of("/")+1);
-    string backupPath = backupDir + "/" + filename;
-
-    if (copyFile(filepath, backupPath)) {
-        // Save entry to index
-        string indexFile = getBackupDir() + "/index.txt";
-        ofstream index(indexFile, ios::app);
-        if (index.is_open()) {
-            index << Utils::getCurrentTimestamp() << "|"
-                  << filepath << "|"
-                  << backupPath << "|"
-                  << Utils::getFileSize(filepath) << "\n";
-            index.close();
-        }
-        return backupPath;
-    }
-    return "";
+    BackupSession session(*this, 1);
+    session.add(filepath);
+    if (!session.commit() || session.entries().empty()) return "";
+    return session.entries().front().backupPath;
 }
 
 // ===== GUI method: create backup from source to destination =====
 // Returns destination path on success, "" on failure
 string BackupManager::createBackup(const string& source, const string& dest) {
-    try {
-        if (!fs::exists(source)) return "";
+    error_code ec;
+    if (!fs::exists(source, ec)) return "";
 
-        if (fs::exists(dest)) fs::remove_all(dest);
-        fs::create_directories(dest);
-        fs::copy(source, dest, fs::copy_options::recursive);
+    Settings settings;
+    settings.load();
+    SyncOptions options;
+    options.compareHashes = settings.getBool("backup", "sync_compare_hashes", false);
 
-    } catch (const exception& e) {
-        cerr << "Backup failed: " << e.what() << endl;
+    lastSyncReport = DirSync::sync(source, dest, options);
+    lastCopyResult = CopyResult();
+    lastCopyResult.ok = lastSyncReport.ok();
+    lastCopyResult.bytes = lastSyncReport.bytesCopied;
+    lastCopyResult.files = lastSyncReport.copied;
+    lastCopyResult.seconds = lastSyncReport.seconds;
+    lastCopyResult.method = "incremental";
+    lastCopyResult.error = lastSyncReport.error;
+    if (!lastSyncReport.ok()) {
+        cerr << "Backup failed: " << lastSyncReport.failed << " files not copied ("
+             << strerror(lastSyncReport.error ? lastSyncReport.error : EIO) << ")" << endl;
         return "";
     }
-
     return dest;
 }
 
@@ -83,8 +119,85 @@ void BackupManager::showBackups() {
     for (size_t i = 0; i < backups.size(); i++) {
         cout << "[" << (i+1) << "] " << CYAN << backups[i].timestamp << RESET << "\n";
         cout << "    Original: " << backups[i].originalPath << "\n";
-        cout << "    Size: " << Utils::formatSize(backups[i].size) << "\n";
+        cout << "    Stored: " << backups[i].backupPath << "\n";
+        cout << "    Size: " << Utils::formatSize(backups[i].size);
+        if (backups[i].codec != "none") {
+            cout << " (" << Utils::formatSize(backups[i].storedSize) << " stored, " << backups[i].codec << ")";
+        }
+        cout << "\n";
+    }
+
+    // Identical content is stored once, and may be compressed
+    unsigned long long total = 0, stored = 0;
+    set<string> files, objects;
+    for (const auto& entry : backups) {
+        total += entry.size;
+        files.insert(entry.backupPath);
+        if (objects.insert(entry.backupPath + "|" + entry.hash).second) stored += entry.storedSize;
+    }
+    cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    cout << backups.size() << " backups, " << Utils::formatSize(total) << " backed up, "
+         << files.size() << " stored files, " << Utils::formatSize(stored) << " on disk\n";
+}
+
+// ===== Retention =====
+void BackupManager::collectGarbage(bool dryRun) {
+    RetentionPolicy policy = BackupGc::loadPolicy();
+    BackupGc gc(*this);
+    GcPlan plan = gc.plan(policy);
+    cout << BOLD << "Backup store: " << RESET << plan.sessions << " sessions, "
+         << Utils::formatSize(plan.storedBytes) << " stored\n";
+    if (!policy.limited()) {
+        cout << "No retention policy set; add keep_last, keep_days or max_size under [backup] in ~/.spacematerc\n";
+    } else {
+        cout << "Policy: keep_last " << policy.keepLast << ", keep_days " << policy.keepDays << ", max_size "
+             << (policy.maxBytes ? Utils::formatSize(policy.maxBytes) : "none") << "\n";
+        cout << plan.evictedSessions << " sessions (" << plan.evict.size() << " backups) to remove, freeing "
+             << Utils::formatSize(plan.freedBytes) << "\n";
+    }
+    if (dryRun) return;
+
+    GcReport report = gc.run(plan);
+    cout << GREEN << "✓ Removed " << report.entriesRemoved << " backups and " << report.filesRemoved
+         << " stored files, rewrote " << report.packsRewritten << " packs, freed " << Utils::formatSize(report.bytesFreed) << " in "
+         << Utils::formatDuration(report.seconds) << "\n" << RESET;
+}
+
+// ===== Verification =====
+bool BackupManager::verifyBackups(size_t threads, double timeLimit, bool restart) {
+    VerifyOptions options;
+    options.threads = threads;
+    options.timeLimit = timeLimit;
+    options.restart = restart;
+    BackupVerifier verifier(*this);
+    VerifyReport report = verifier.run(options, [](size_t done, size_t total) {
+        cout << "  Checked " << done << "/" << total << " stored files...\r" << flush;
+    });
+
+    cout << "\n";
+    if (report.skipped > 0) cout << "Continued after " << report.skipped << " files checked by an earlier run\n";
+    cout << "Checked " << report.checked << " stored files (" << report.objects << " objects, "
+         << Utils::formatSize(report.bytes) << ") in " << Utils::formatDuration(report.seconds) << " at "
+         << Utils::formatSize((unsigned long long)report.bytesPerSecond()) << "/s\n";
+    if (report.unchecked > 0) {
+        cout << YELLOW << report.unchecked << " older backups have no checksum and were only checked to exist\n" << RESET;
+    }
+    for (const auto& problem : report.problems) {
+        cout << "\033[31m" << (problem.missing ? "✗ Missing: " : "✗ Corrupt: ") << RESET << problem.path;
+        if (PackStore::isPack(problem.path)) cout << " (object " << problem.hash.substr(0, 12) << ")";
+        cout << "\n";
+        for (const auto& original : problem.originals) cout << "    backup of " << original << "\n";
+    }
+    if (!report.complete) {
+        cout << YELLOW << "⏸  Stopped after " << report.skipped + report.checked << " of " << report.files
+             << " files; run verify again to continue\n" << RESET;
+    }
+    if (report.problems.empty()) {
+        cout << GREEN << "✓ No corrupt or missing backups found\n" << RESET;
+        return true;
     }
+    cout << "\033[31m" << report.problems.size() << " stored objects are corrupt or missing\n" << RESET;
+    return false;
 }
 
 // ===== Restore file from backup =====
@@ -111,61 +224,174 @@ void BackupManager::restoreFiles() {
         if (resp != "y" && resp != "Y") { cout << "Restore cancelled.\n"; return; }
     }
 
-    if (copyFile(entry.backupPath, entry.originalPath))
-        cout << GREEN << "✓ File restored successfully!\n" << RESET;
+    lastCopyResult = restoreEntry(entry, entry.originalPath);
+    if (lastCopyResult.ok)
+        cout << GREEN << "✓ File restored successfully! (" << Utils::formatSize(lastCopyResult.bytes) << " at "
+             << Utils::formatSize((unsigned long long)lastCopyResult.bytesPerSecond()) << "/s via "
+             << lastCopyResult.method << ")\n" << RESET;
     else
         cout << "\033[31mError: Failed to restore file\n" << RESET;
 }
 
-// ===== Load backup index =====
-vector<BackupEntry> BackupManager::loadBackupIndex() {
-    vector<BackupEntry> backups;
-    string indexFile = getBackupDir() + "/index.txt";
-    ifstream index(indexFile);
-    if (!index.is_open()) return backups;
+bool BackupManager::restoreBackups(const RestoreSelection& selection, const RestoreOptions& options, bool dryRun) {
+    BackupRestorer restorer(*this);
+    vector<BackupEntry> entries = restorer.select(selection);
+    if (entries.empty()) {
+        cout << "No backups match the selection.\n";
+        return false;
+    }
+    RestorePlan plan = BackupRestorer::plan(entries, options);
 
-    string line;
-    while (getline(index, line)) {
-        BackupEntry entry;
-        stringstream ss(line); string sizeStr;
-        getline(ss, entry.timestamp, '|');
-        getline(ss, entry.originalPath, '|');
-        getline(ss, entry.backupPath, '|');
-        getline(ss, sizeStr, '|');
-        entry.size = stoull(sizeStr);
-        backups.push_back(entry);
+    if (dryRun) {
+        for (const auto& item : plan.items) {
+            cout << (item.replaces ? YELLOW : CYAN) << item.entry.timestamp << RESET << "  " << item.entry.originalPath;
+            if (item.dest != item.entry.originalPath) cout << " -> " << item.dest;
+            if (item.replaces) cout << YELLOW << " (overwrites)" << RESET;
+            cout << "\n";
+        }
+        cout << "\nWould restore " << plan.items.size() << " files (" << Utils::formatSize(plan.bytes) << ")";
+        if (plan.skipped > 0) cout << ", skipping " << plan.skipped << " that already exist";
+        cout << "\n";
+        return true;
     }
-    index.close();
-    return backups;
+
+    cout << "Restoring " << plan.items.size() << " files (" << Utils::formatSize(plan.bytes) << ") with "
+         << options.threads << " threads\n";
+    RestoreReport report = BackupRestorer::run(plan, options, [](size_t done, size_t total) {
+        cout << "  Restored " << done << "/" << total << " files...\r" << flush;
+    });
+
+    cout << "\n";
+    for (const auto& failure : report.failures) cout << "\033[31m✗ " << RESET << failure << "\n";
+    cout << GREEN << "✓ Restored " << report.restored << " files (" << Utils::formatSize(report.bytes) << ") in "
+         << Utils::formatDuration(report.seconds) << " at "
+         << Utils::formatSize((unsigned long long)report.bytesPerSecond()) << "/s\n" << RESET;
+    if (report.renamed > 0) cout << YELLOW << report.renamed << " restored under a new name next to an existing file\n" << RESET;
+    if (report.skipped > 0) cout << YELLOW << report.skipped << " skipped because the file already exists\n" << RESET;
+    if (report.failed > 0) {
+        cout << "\033[31m" << report.failed << " files could not be restored\n" << RESET;
+        return false;
+    }
+    return true;
 }
 
-// ===== Add backup entry to index =====
-void BackupManager::addBackupIndexEntry(const string& originalPath, const string& backupPath) {
-    string indexFile = getBackupDir() + "/index.txt";
-    ofstream index(indexFile, ios::app);
-    if (index.is_open()) {
-        unsigned long long size = 0;
-        try {
-            if (fs::exists(backupPath)) {
-                size = fs::file_size(backupPath);
+CopyResult BackupManager::restoreEntry(const BackupEntry& entry, const string& dest, PackReader* pack) {
+    CopyResult result;
+    if (PackStore::isPack(entry.backupPath)) {
+        result = pack ? PackStore::restore(*pack, entry.hash, dest) : PackStore::restore(entry.backupPath, entry.hash, dest);
+    } else if (ObjectStore::isCompressed(entry.backupPath)) {
+        result = Compressor::decompressFile(entry.backupPath, dest);
+    } else {
+        result = CopyEngine::copyFile(entry.backupPath, dest);
+    }
+    if (!result.ok || entry.mode == 0) return result;
+
+    // Owner first: chown clears the set-id bits
+    if (chown(dest.c_str(), entry.uid, entry.gid) != 0) {}   // only root may give files away
+    chmod(dest.c_str(), entry.mode & 07777);
+    struct timespec times[2] = {entry.mtime, entry.mtime};
+    utimensat(AT_FDCWD, dest.c_str(), times, 0);
+    return result;
+}
+
+// ===== Backup index =====
+BackupIndex& BackupManager::getIndex() {
+    lock_guard<mutex> lock(indexMutex);
+    if (index) return *index;
+    string dir = getBackupDir();
+    index = make_unique<BackupIndex>(dir + "/index.bin");
+
+    // One-time migration of the old `time|original|backup|size[|hash|mode|uid|gid|sec|nsec|stored|codec]` lines
+    string textIndex = dir + "/index.txt";
+    error_code ec;
+    if (!fs::exists(index->file(), ec) && fs::exists(textIndex, ec)) {
+        vector<BackupEntry> entries;
+        ifstream in(textIndex);
+        string line;
+        while (getline(in, line)) {
+            BackupEntry entry;
+            stringstream ss(line);
+            string sizeStr, mode, uid, gid, seconds, nanoseconds, storedStr, codec;
+            getline(ss, entry.timestamp, '|');
+            getline(ss, entry.originalPath, '|');
+            getline(ss, entry.backupPath, '|');
+            getline(ss, sizeStr, '|');
+            getline(ss, entry.hash, '|');
+            bool metadata = getline(ss, mode, '|') && getline(ss, uid, '|') && getline(ss, gid, '|') &&
+                            getline(ss, seconds, '|') && getline(ss, nanoseconds, '|');
+            getline(ss, storedStr, '|');
+            getline(ss, codec, '|');
+            try {
+                entry.size = stoull(sizeStr);
+                entry.storedSize = storedStr.empty() ? entry.size : stoull(storedStr);
+                if (metadata) {
+                    entry.mode = stoul(mode);
+                    entry.uid = stoul(uid);
+                    entry.gid = stoul(gid);
+                    entry.mtime.tv_sec = stoll(seconds);
+                    entry.mtime.tv_nsec = stol(nanoseconds);
+                }
+            } catch (...) {
+                continue;   // a '|' in a path made this line unreadable
             }
-        } catch (...) {
-            size = 0;
+            if (!codec.empty()) entry.codec = codec;
+            entries.push_back(entry);
         }
-        
-        index << Utils::getCurrentTimestamp() << "|"
-              << originalPath << "|"
-              << backupPath << "|"
-              << size << "\n";
-        index.close();
+        if (index->append(entries)) fs::rename(textIndex, textIndex + ".migrated", ec);
     }
+    return *index;
 }
 
-// ===== Copy file helper =====
-bool BackupManager::copyFile(const string& source, const string& dest) {
-    ifstream src(source, ios::binary); if (!src.is_open()) return false;
-    ofstream dst(dest, ios::binary); if (!dst.is_open()) { src.close(); return false; }
-    dst << src.rdbuf();
-    src.close(); dst.close();
-    return true;
+vector<BackupEntry> BackupManager::loadBackupIndex() {
+    return getIndex().entries();
+}
+
+// ===== Add backup entry to index =====
+void BackupManager::addBackupIndexEntry(const string& originalPath, const string& backupPath) {
+    BackupEntry entry;
+    entry.timestamp = Utils::getCurrentTimestamp();
+    entry.originalPath = originalPath;
+    entry.backupPath = backupPath;
+    error_code ec;
+    entry.size = fs::file_size(backupPath, ec);
+    if (ec) entry.size = 0;
+    entry.storedSize = entry.size;
+    vector<BackupEntry> entries = {entry};
+    getIndex().append(entries);
+}
+
+// ===== Append many entries at once =====
+bool BackupManager::appendIndexEntries(vector<BackupEntry>& entries) {
+    return getIndex().append(entries);
+}
+
+// ===== Remove entries =====
+size_t BackupManager::removeBackups(const vector<uint64_t>& ids) {
+    lastRemovalReport = RemovalReport();
+    // No session may reuse an object between the count and the delete
+    StoreLock lock(getObjectDir(), true);
+    BackupIndex& backups = getIndex();
+    set<string> candidates;
+    vector<uint64_t> found;
+    for (uint64_t id : ids) {
+        BackupEntry entry;
+        if (!backups.find(id, entry)) continue;
+        found.push_back(id);
+        candidates.insert(entry.backupPath);
+    }
+    if (found.empty() || !backups.remove(found)) return 0;
+    lastRemovalReport.entries = found.size();
+
+    // Delete stored files only once no entry refers to them; a pack goes
+    // when none of its objects is referenced any more
+    for (const auto& path : candidates) {
+        if (backups.references(path) > 0) continue;
+        error_code ec;
+        unsigned long long size = fs::file_size(path, ec);
+        bool removed = PackStore::isPack(path) ? PackStore::removePack(path) && !ec : fs::remove(path, ec);
+        if (!removed) continue;
+        lastRemovalReport.files++;
+        lastRemovalReport.bytes += size;
+    }
+    return found.size();
 }
@@ -0,0 +1,182 @@
+#include "../include/backup_restorer.h"
+#include "../include/pack_store.h"
+#include "../include/task_pool.h"
+#include "../include/utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+    atomic<unsigned long> temporaries{0};
+
+    string destinationFor(const string& original, const string& targetDir) {
+        if (targetDir.empty()) return original;
+        return (fs::path(targetDir) / fs::path(original).relative_path()).string();
+    }
+
+    bool occupied(const string& path, const unordered_set<string>& claimed) {
+        struct stat st;
+        return claimed.count(path) || lstat(path.c_str(), &st) == 0;
+    }
+
+    // "report.log" -> "report.restored.log", "report.restored-2.log", ...
+    string freeNameFor(const string& dest, const unordered_set<string>& claimed) {
+        fs::path path(dest);
+        string stem = (path.parent_path() / path.stem()).string() + ".restored";
+        string extension = path.extension().string();
+        string candidate = stem + extension;
+        for (int n = 2; occupied(candidate, claimed); n++) candidate = stem + "-" + to_string(n) + extension;
+        return candidate;
+    }
+
+    // Restores through a temporary file next to `dest`, renamed into place
+    template <typename Restore>
+    CopyResult restoreInto(const string& dest, Restore restore) {
+        fs::path path(dest);
+        error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+        string temp = (path.parent_path() / ("." + path.filename().string() + "." + to_string(getpid()) + "." +
+                                             to_string(temporaries++) + ".restore.tmp")).string();
+        CopyResult copy = restore(temp);
+        if (copy.ok && rename(temp.c_str(), dest.c_str()) != 0) {
+            copy.ok = false;
+            copy.error = errno;
+        }
+        if (!copy.ok) unlink(temp.c_str());
+        return copy;
+    }
+}
+
+BackupRestorer::BackupRestorer(BackupManager& manager) : backups(manager) {}
+
+bool BackupRestorer::parseConflict(const string& name, RestoreConflict& conflict) {
+    if (name == "skip") conflict = RestoreConflict::Skip;
+    else if (name == "overwrite") conflict = RestoreConflict::Overwrite;
+    else if (name == "rename") conflict = RestoreConflict::Rename;
+    else return false;
+    return true;
+}
+
+// ===== Selection =====
+vector<BackupEntry> BackupRestorer::select(const RestoreSelection& selection) {
+    vector<BackupEntry> entries = backups.loadBackupIndex();
+    string session = selection.session;
+    if (session == "latest") session = entries.empty() ? "" : entries.back().timestamp;
+
+    string prefix = selection.pathPrefix;
+    while (prefix.size() > 1 && prefix.back() == '/') prefix.pop_back();
+    auto underPrefix = [&prefix](const string& path) {
+        if (prefix.empty() || prefix == "/" || path == prefix) return true;
+        return path.size() > prefix.size() && path.compare(0, prefix.size(), prefix) == 0 && path[prefix.size()] == '/';
+    };
+
+    // Entries come oldest first, so a later match replaces an earlier one
+    vector<BackupEntry> selected;
+    unordered_map<string, size_t> slotOf;
+    for (auto& entry : entries) {
+        if (!session.empty() && entry.timestamp != session) continue;
+        if (!underPrefix(entry.originalPath)) continue;
+        if (selection.before > 0) {
+            time_t started = 0;
+            if (!Utils::parseTimestamp(entry.timestamp, started) || started >= selection.before) continue;
+        }
+        auto slot = slotOf.emplace(entry.originalPath, selected.size());
+        if (slot.second) selected.push_back(move(entry));
+        else selected[slot.first->second] = move(entry);
+    }
+    return selected;
+}
+
+// ===== Planning =====
+RestorePlan BackupRestorer::plan(const vector<BackupEntry>& entries, const RestoreOptions& options) {
+    RestorePlan plan;
+    unordered_set<string> claimed;   // destinations earlier items of this plan write
+    for (const auto& entry : entries) {
+        RestoreItem item;
+        item.entry = entry;
+        item.dest = destinationFor(entry.originalPath, options.targetDir);
+        if (occupied(item.dest, claimed)) {
+            if (options.conflict == RestoreConflict::Skip) {
+                plan.skipped++;
+                continue;
+            }
+            // Two versions of one file in the plan are both kept
+            if (options.conflict == RestoreConflict::Overwrite && !claimed.count(item.dest)) {
+                item.replaces = true;
+            } else {
+                item.dest = freeNameFor(item.dest, claimed);
+                plan.renamed++;
+            }
+        }
+        claimed.insert(item.dest);
+        plan.bytes += entry.size;
+        plan.items.push_back(move(item));
+    }
+    return plan;
+}
+
+// ===== Restoring =====
+RestoreReport BackupRestorer::run(const RestorePlan& plan, const RestoreOptions& options, Progress progress) {
+    RestoreReport report;
+    report.skipped = plan.skipped;
+    report.renamed = plan.renamed;
+    auto start = chrono::steady_clock::now();
+
+    // Packed objects are restored a pack at a time, loose ones each on their own
+    map<string, vector<const RestoreItem*>> packs;
+    vector<const RestoreItem*> loose;
+    for (const auto& item : plan.items) {
+        if (PackStore::isPack(item.entry.backupPath)) packs[item.entry.backupPath].push_back(&item);
+        else loose.push_back(&item);
+    }
+
+    mutex reportMutex;
+    size_t done = 0;
+    auto finish = [&](const RestoreItem& item, const CopyResult& copy) {
+        lock_guard<mutex> lock(reportMutex);
+        if (copy.ok) {
+            report.restored++;
+            report.bytes += copy.bytes;
+        } else {
+            report.failed++;
+            report.failures.push_back(item.entry.originalPath + ": " + strerror(copy.error ? copy.error : EIO));
+        }
+        if (progress) progress(++done, plan.items.size());
+    };
+
+    {
+        TaskPool pool(max<size_t>(options.threads, 1));
+        for (const auto& pack : packs) {
+            pool.submit([&finish, &pack] {
+                PackReader reader(pack.first);
+                for (const RestoreItem* item : pack.second) {
+                    finish(*item, restoreInto(item->dest, [&](const string& temp) {
+                        return BackupManager::restoreEntry(item->entry, temp, &reader);
+                    }));
+                }
+            });
+        }
+        for (const RestoreItem* item : loose) {
+            pool.submit([&finish, item] {
+                finish(*item, restoreInto(item->dest, [item](const string& temp) {
+                    return BackupManager::restoreEntry(item->entry, temp);
+                }));
+            });
+        }
+    }   // the pool finishes every task here
+
+    sort(report.failures.begin(), report.failures.end());
+    report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,99 @@
+#include "../include/backup_session.h"
+#include "../include/utils.h"
+#include <algorithm>
+
+using namespace std;
+
+BackupSession::BackupSession(BackupManager& manager, size_t parallelism)
+    : backups(manager), objects(manager.getObjectDir(), manager.getCompression(), manager.getPacking()), started(chrono::steady_clock::now()) {
+    // The id is the start time; a later session in the same second gets a suffix
+    static mutex idMutex;
+    static string lastStamp;
+    static int lastSuffix = 0;
+    string stamp = Utils::getCurrentTimestamp();
+    {
+        lock_guard<mutex> lock(idMutex);
+        lastSuffix = stamp == lastStamp ? lastSuffix + 1 : 1;
+        lastStamp = stamp;
+        sessionId = lastSuffix == 1 ? stamp : stamp + "_" + to_string(lastSuffix);
+    }
+    opened = objects.open();
+    if (opened) pool = make_unique<TaskPool>(parallelism);
+}
+
+BackupSession::~BackupSession() {
+    if (!committed) commit();
+}
+
+// ===== Storing =====
+void BackupSession::add(const string& path) {
+    {
+        lock_guard<mutex> lock(sessionMutex);
+        // Waits here while a gc runs
+        if (isOpen() && !committed && !storeLock) storeLock = make_unique<StoreLock>(objects.root(), false);
+        if (!isOpen() || committed || !storeLock->held()) {
+            failed.push_back(path);
+            return;
+        }
+    }
+    pool->submit([this, path] { store(path); });
+}
+
+void BackupSession::store(const string& path) {
+    StoredObject object = objects.put(path);
+
+    lock_guard<mutex> lock(sessionMutex);
+    if (object.ok) {
+        BackupEntry entry;
+        entry.originalPath = path;
+        entry.backupPath = object.path;
+        entry.size = object.size;
+        entry.timestamp = sessionId;
+        entry.hash = object.hash;
+        entry.storedSize = object.storedSize;
+        entry.codec = Compressor::name(object.codec);
+        entry.mode = object.source.st_mode;
+        entry.uid = object.source.st_uid;
+        entry.gid = object.source.st_gid;
+        entry.mtime = object.source.st_mtim;
+        backedUp.push_back(move(entry));
+        summary.files++;
+        summary.bytes += object.size;
+        if (object.deduplicated) summary.deduplicated++;
+        else summary.storedBytes += object.storedSize;
+    } else {
+        failed.push_back(path);
+        summary.failed++;
+    }
+    done++;
+}
+
+// ===== Commit =====
+bool BackupSession::commit() {
+    if (committed) return failed.empty();
+    committed = true;
+    if (pool) pool->wait();
+
+    lock_guard<mutex> lock(sessionMutex);
+    // Packed objects must be on disk before the index points at them
+    if (!objects.flush()) {
+        for (const auto& entry : backedUp) {
+            if (PackStore::isPack(entry.backupPath)) failed.push_back(entry.originalPath);
+        }
+        backedUp.erase(remove_if(backedUp.begin(), backedUp.end(),
+                                 [](const BackupEntry& entry) { return PackStore::isPack(entry.backupPath); }),
+                       backedUp.end());
+    }
+    // Without its index entry a stored object restores nothing
+    if (!backedUp.empty() && !backups.appendIndexEntries(backedUp)) {
+        for (const auto& entry : backedUp) failed.push_back(entry.originalPath);
+        backedUp.clear();
+        summary.files = 0;
+        summary.bytes = 0;
+        summary.indexFailed = true;
+    }
+    if (storeLock) storeLock->release();   // the entries keep the objects alive now
+    summary.failed = failed.size();
+    summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    return failed.empty();
+}
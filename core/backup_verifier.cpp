@@ -0,0 +1,177 @@
+#include "../include/backup_verifier.h"
+#include "../include/object_store.h"
+#include "../include/pack_store.h"
+#include "../include/sha256.h"
+#include "../include/task_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+    // How often an unfinished pass records how far it got
+    const double CHECKPOINT_SECONDS = 5.0;
+
+    struct StoredFile {
+        string path;
+        vector<string> hashes;                             // objects in use, in index order
+        unordered_map<string, vector<string>> originals;   // hash -> backed-up paths
+    };
+
+    struct Outcome {
+        size_t objects = 0;
+        size_t unchecked = 0;
+        unsigned long long bytes = 0;
+        vector<VerifyProblem> problems;
+    };
+
+    Outcome check(const StoredFile& file) {
+        Outcome outcome;
+        auto problem = [&](const string& hash, bool missing) {
+            VerifyProblem found;
+            found.path = file.path;
+            found.hash = hash;
+            found.missing = missing;
+            found.originals = file.originals.at(hash);
+            outcome.problems.push_back(move(found));
+        };
+
+        struct stat st;
+        if (stat(file.path.c_str(), &st) != 0) {
+            for (const auto& hash : file.hashes) problem(hash, true);
+            return outcome;
+        }
+
+        // A pack: its index is read once, then every object it should hold
+        if (PackStore::isPack(file.path)) {
+            PackReader reader(file.path);
+            vector<char> raw;
+            for (const auto& hash : file.hashes) {
+                PackLocation location;
+                errno = 0;
+                if (!reader.read(hash, raw, location)) {
+                    problem(hash, errno == ENOENT);
+                    continue;
+                }
+                Sha256 digest;
+                digest.update(raw.data(), raw.size());
+                outcome.objects++;
+                outcome.bytes += location.storedSize;
+                if (digest.hexDigest() != hash) problem(hash, false);
+            }
+            return outcome;
+        }
+
+        const string& hash = file.hashes.front();
+        if (hash.empty()) {
+            outcome.unchecked++;   // a plain copy made before objects had checksums
+            return outcome;
+        }
+        string actual = ObjectStore::isCompressed(file.path) ? Compressor::hashContent(file.path)
+                                                              : Sha256::hashFile(file.path);
+        outcome.objects++;
+        outcome.bytes += st.st_size;
+        if (actual != hash) problem(hash, false);
+        return outcome;
+    }
+
+    bool writeCheckpoint(const string& file, const string& lastPath) {
+        string temp = file + ".tmp";
+        {
+            ofstream out(temp, ios::trunc);
+            out << lastPath << "\n";
+            if (!out.flush()) return false;
+        }
+        return rename(temp.c_str(), file.c_str()) == 0;
+    }
+}
+
+BackupVerifier::BackupVerifier(BackupManager& manager) : backups(manager) {}
+
+string BackupVerifier::checkpointFile() {
+    return backups.getBackupDir() + "/verify.checkpoint";
+}
+
+VerifyReport BackupVerifier::run(const VerifyOptions& options, Progress progress) {
+    VerifyReport report;
+    auto start = chrono::steady_clock::now();
+    auto elapsed = [&start] { return chrono::duration<double>(chrono::steady_clock::now() - start).count(); };
+
+    // Stored files in path order, each with the objects entries use in it
+    map<string, StoredFile> byPath;
+    for (const auto& entry : backups.loadBackupIndex()) {
+        StoredFile& file = byPath[entry.backupPath];
+        file.path = entry.backupPath;
+        auto& originals = file.originals[entry.hash];
+        if (originals.empty()) file.hashes.push_back(entry.hash);
+        originals.push_back(entry.originalPath);
+    }
+    vector<const StoredFile*> files;
+    files.reserve(byPath.size());
+    for (const auto& file : byPath) files.push_back(&file.second);
+    report.files = files.size();
+
+    // Continue after the stored file the last run got to
+    string checkpoint = checkpointFile();
+    size_t first = 0;
+    if (options.restart) {
+        unlink(checkpoint.c_str());
+    } else {
+        ifstream in(checkpoint);
+        string last;
+        if (getline(in, last) && !last.empty()) {
+            first = upper_bound(files.begin(), files.end(), last,
+                                [](const string& path, const StoredFile* file) { return path < file->path; }) -
+                    files.begin();
+        }
+    }
+    report.skipped = first;
+
+    // Files finish out of order; the checkpoint only moves past a file
+    // once every file before it is done
+    mutex reportMutex;
+    vector<bool> done(files.size(), false);
+    size_t frontier = first;
+    size_t saved = first;
+    double lastSave = 0;
+    {
+        TaskPool pool(max<size_t>(options.threads, 1));
+        for (size_t i = first; i < files.size(); i++) {
+            if (options.timeLimit > 0 && elapsed() >= options.timeLimit) break;
+            pool.submit([&, i] {
+                Outcome outcome = check(*files[i]);
+
+                lock_guard<mutex> lock(reportMutex);
+                report.checked++;
+                report.objects += outcome.objects;
+                report.unchecked += outcome.unchecked;
+                report.bytes += outcome.bytes;
+                for (auto& problem : outcome.problems) report.problems.push_back(move(problem));
+                done[i] = true;
+                while (frontier < files.size() && done[frontier]) frontier++;
+                if (frontier > saved && elapsed() - lastSave >= CHECKPOINT_SECONDS) {
+                    writeCheckpoint(checkpoint, files[frontier - 1]->path);
+                    saved = frontier;
+                    lastSave = elapsed();
+                }
+                if (progress) progress(report.skipped + report.checked, report.files);
+            });
+        }
+    }   // the pool finishes the files in flight here
+
+    report.complete = frontier == files.size();
+    if (report.complete) unlink(checkpoint.c_str());
+    else if (frontier > saved) writeCheckpoint(checkpoint, files[frontier - 1]->path);
+    sort(report.problems.begin(), report.problems.end(),
+         [](const VerifyProblem& a, const VerifyProblem& b) { return a.path < b.path; });
+    report.seconds = elapsed();
+    return report;
+}
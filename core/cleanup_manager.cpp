@@ -1,10 +1,14 @@
 #include "../include/cleanup_manager.h"
 #include "../include/backup_manager.h"
+#include "../include/backup_session.h"
+#include "../include/backup_gc.h"
 #include "../include/file_analyzer.h"
 #include "../include/utils.h"
 #include <iostream>
 #include <fstream>
 #include <unistd.h>
+#include <set>
+#include <algorithm>
 
 #define RESET   "\033[0m"
 #define RED     "\033[31m"
@@ -71,17 +75,39 @@ void CleanupManager::cleanPath(const string& path, bool dryRun, bool force, bool
         return;
     }
     
-    // Create backup first
+    // Create backup first; a file whose backup failed is not deleted
     if (!force) {
         cout << "\n🔒 Creating backup...\n";
+        BackupSession session(backup);
         for (const auto& file : filesToDelete) {
-            backup.createBackup(file.path);
+            session.add(file.path);
+        }
+        session.commit();
+        const SessionReport& report = session.report();
+        if (report.indexFailed) {
+            cout << RED << "✗ Could not write the backup index; no files are deleted\n" << RESET;
+            return;
+        }
+        cout << GREEN << "✓ Backup complete: " << report.files << " files, " << Utils::formatSize(report.bytes)
+             << " (" << Utils::formatSize(report.storedBytes) << " new, " << report.deduplicated << " already stored)"
+             << " at " << Utils::formatSize((unsigned long long)report.bytesPerSecond()) << "/s\n" << RESET;
+        if (!session.failures().empty()) {
+            cout << YELLOW << "⚠️  " << session.failures().size() << " files could not be backed up and are kept\n" << RESET;
+            set<string> keep(session.failures().begin(), session.failures().end());
+            filesToDelete.erase(remove_if(filesToDelete.begin(), filesToDelete.end(),
+                                          [&keep](const FileInfo& f) { return keep.count(f.path) > 0; }),
+                                filesToDelete.end());
         }
-        cout << GREEN << "✓ Backup complete\n" << RESET;
     }
     
     // Delete files
     deleteFiles(filesToDelete, false, force);
+
+    // Keep the new backups from growing the store past its limits
+    if (!force && BackupGc::loadPolicy().limited()) {
+        cout << "\n♻️  Applying backup retention...\n";
+        backup.collectGarbage(false);
+    }
 }
 
 void CleanupManager::deleteFiles(const vector<FileInfo>& files, bool dryRun, bool force) {
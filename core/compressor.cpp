@@ -0,0 +1,445 @@
+#include "../include/compressor.h"
+#include "../include/task_pool.h"
+#include <vector>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#ifdef SPACEMATE_WITH_ZSTD
+#include <zstd.h>
+#endif
+#ifdef SPACEMATE_WITH_LZ4
+#include <lz4.h>
+#endif
+
+using namespace std;
+
+namespace {
+    const char MAGIC[4] = {'S', 'M', 'Z', '1'};
+    const size_t HEADER_SIZE = 20;
+    const size_t CHUNK_HEADER_SIZE = 8;
+    const size_t MAX_CHUNK = 64 << 20;   // sanity limit when reading a header
+
+    void put32(unsigned char* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = v >> (8 * i); }
+    void put64(unsigned char* p, uint64_t v) { for (int i = 0; i < 8; i++) p[i] = v >> (8 * i); }
+    uint32_t get32(const unsigned char* p) { uint32_t v = 0; for (int i = 3; i >= 0; i--) v = v << 8 | p[i]; return v; }
+    uint64_t get64(const unsigned char* p) { uint64_t v = 0; for (int i = 7; i >= 0; i--) v = v << 8 | p[i]; return v; }
+
+    bool writeAll(int fd, const void* data, size_t length) {
+        const char* p = static_cast<const char*>(data);
+        while (length > 0) {
+            ssize_t n = write(fd, p, length);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return false;
+            p += n;
+            length -= n;
+        }
+        return true;
+    }
+
+    // Reads up to `length` bytes; fewer only at end of file
+    ssize_t readFull(int fd, void* data, size_t length) {
+        char* p = static_cast<char*>(data);
+        size_t got = 0;
+        while (got < length) {
+            ssize_t n = read(fd, p + got, length - got);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return -1;
+            if (n == 0) break;
+            got += n;
+        }
+        return got;
+    }
+
+    // Compressed form of `raw`, or empty when the codec failed or gained nothing
+    vector<char> compressChunk(Codec codec, int level, const vector<char>& raw) {
+        vector<char> out;
+        switch (codec) {
+        case Codec::Zlib: {
+            uLongf length = compressBound(raw.size());
+            out.resize(length);
+            if (compress2(reinterpret_cast<Bytef*>(out.data()), &length,
+                          reinterpret_cast<const Bytef*>(raw.data()), raw.size(),
+                          level ? level : Z_DEFAULT_COMPRESSION) != Z_OK) return {};
+            out.resize(length);
+            break;
+        }
+#ifdef SPACEMATE_WITH_ZSTD
+        case Codec::Zstd: {
+            out.resize(ZSTD_compressBound(raw.size()));
+            size_t length = ZSTD_compress(out.data(), out.size(), raw.data(), raw.size(),
+                                          level ? level : ZSTD_CLEVEL_DEFAULT);
+            if (ZSTD_isError(length)) return {};
+            out.resize(length);
+            break;
+        }
+#endif
+#ifdef SPACEMATE_WITH_LZ4
+        case Codec::Lz4: {   // LZ4 has no levels in its fast mode; the level is ignored
+            out.resize(LZ4_compressBound(raw.size()));
+            int length = LZ4_compress_default(raw.data(), out.data(), raw.size(), out.size());
+            if (length <= 0) return {};
+            out.resize(length);
+            break;
+        }
+#endif
+        default:
+            return {};
+        }
+        if (out.size() >= raw.size()) return {};
+        return out;
+    }
+
+    bool decompressChunk(Codec codec, const vector<char>& in, vector<char>& raw) {
+        switch (codec) {
+        case Codec::Zlib: {
+            uLongf length = raw.size();
+            return uncompress(reinterpret_cast<Bytef*>(raw.data()), &length,
+                              reinterpret_cast<const Bytef*>(in.data()), in.size()) == Z_OK &&
+                   length == raw.size();
+        }
+#ifdef SPACEMATE_WITH_ZSTD
+        case Codec::Zstd: {
+            size_t length = ZSTD_decompress(raw.data(), raw.size(), in.data(), in.size());
+            return !ZSTD_isError(length) && length == raw.size();
+        }
+#endif
+#ifdef SPACEMATE_WITH_LZ4
+        case Codec::Lz4:
+            return LZ4_decompress_safe(in.data(), raw.data(), in.size(), raw.size()) == (int)raw.size();
+#endif
+        default:
+            return false;
+        }
+    }
+
+    // Streams the chunks after the header to sink(data, length), one chunk
+    // in memory at a time; `restored` tells how far it got
+    template <typename Sink>
+    bool decodeChunks(int in, Codec codec, uint64_t original, uint64_t& restored, Sink sink) {
+        bool ok = true;
+        vector<char> stored, raw;
+        while (ok && restored < original) {
+            unsigned char chunkHeader[CHUNK_HEADER_SIZE];
+            ok = readFull(in, chunkHeader, CHUNK_HEADER_SIZE) == (ssize_t)CHUNK_HEADER_SIZE;
+            uint32_t rawLength = ok ? get32(chunkHeader) : 0;
+            uint32_t storedLength = ok ? get32(chunkHeader + 4) : 0;
+            if (ok && (rawLength == 0 || rawLength > MAX_CHUNK || storedLength > rawLength)) ok = false;
+            if (!ok) {
+                errno = EINVAL;
+                break;
+            }
+            stored.resize(storedLength);
+            ok = readFull(in, stored.data(), storedLength) == (ssize_t)storedLength;
+            if (ok && storedLength == rawLength) {
+                ok = sink(stored.data(), storedLength);   // kept raw
+            } else if (ok) {
+                raw.resize(rawLength);
+                ok = decompressChunk(codec, stored, raw);
+                if (!ok) errno = EINVAL;
+                else ok = sink(raw.data(), rawLength);
+            }
+            restored += rawLength;
+        }
+        return ok;
+    }
+
+    // Mode and timestamps last: setting times before writing would be undone by the writes
+    void copyMetadata(const struct stat& st, int fd) {
+        if (fchown(fd, st.st_uid, st.st_gid) != 0) {}   // only root may give files away
+        fchmod(fd, st.st_mode & 07777);
+        struct timespec times[2] = {st.st_atim, st.st_mtim};
+        futimens(fd, times);
+    }
+
+    const unordered_set<string> compressedExtensions = {
+        ".jpg", ".jpeg", ".png", ".gif", ".webp", ".heic", ".avif",
+        ".mp3", ".m4a", ".aac", ".ogg", ".opus", ".flac",
+        ".mp4", ".m4v", ".mkv", ".mov", ".avi", ".webm", ".wmv",
+        ".zip", ".gz", ".tgz", ".bz2", ".xz", ".zst", ".lz4", ".7z", ".rar",
+        ".jar", ".apk", ".deb", ".rpm", ".whl", ".docx", ".xlsx", ".pptx", ".odt", ".epub",
+    };
+}
+
+// ===== Codecs =====
+bool Compressor::available(Codec codec) {
+    switch (codec) {
+    case Codec::None:
+    case Codec::Zlib:
+        return true;
+#ifdef SPACEMATE_WITH_ZSTD
+    case Codec::Zstd:
+        return true;
+#endif
+#ifdef SPACEMATE_WITH_LZ4
+    case Codec::Lz4:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* Compressor::name(Codec codec) {
+    switch (codec) {
+    case Codec::Zlib: return "zlib";
+    case Codec::Zstd: return "zstd";
+    case Codec::Lz4:  return "lz4";
+    default:          return "none";
+    }
+}
+
+bool Compressor::parse(const string& name, Codec& codec) {
+    for (Codec c : {Codec::None, Codec::Zlib, Codec::Zstd, Codec::Lz4}) {
+        if (name == Compressor::name(c)) {
+            codec = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+vector<char> Compressor::compressBlock(Codec codec, int level, const vector<char>& raw) {
+    return available(codec) ? compressChunk(codec, level, raw) : vector<char>();
+}
+
+bool Compressor::decompressBlock(Codec codec, const vector<char>& stored, vector<char>& raw) {
+    return available(codec) && decompressChunk(codec, stored, raw);
+}
+
+// ===== What to compress =====
+bool Compressor::worthCompressing(const string& path) {
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of('/');
+    if (dot != string::npos && (slash == string::npos || dot > slash)) {
+        string extension = path.substr(dot);
+        transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return tolower(c); });
+        if (compressedExtensions.count(extension)) return false;
+    }
+
+    // Byte entropy of three samples; compressed or encrypted data is close to 8 bits
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    const size_t SAMPLE = 16 * 1024;
+    vector<unsigned char> sample(SAMPLE);
+    unsigned long long counts[256] = {0};
+    unsigned long long total = 0;
+    off_t size = st.st_size;
+    for (off_t offset : {(off_t)0, size / 2, size > (off_t)SAMPLE ? size - (off_t)SAMPLE : (off_t)0}) {
+        ssize_t n = pread(fd, sample.data(), SAMPLE, offset);
+        for (ssize_t i = 0; i < n; i++) counts[sample[i]]++;
+        if (n > 0) total += n;
+        if (size <= (off_t)SAMPLE) break;
+    }
+    close(fd);
+    if (total == 0) return false;
+
+    double entropy = 0;
+    for (auto count : counts) {
+        if (!count) continue;
+        double p = (double)count / total;
+        entropy -= p * log2(p);
+    }
+    return entropy < 7.5;
+}
+
+bool Compressor::readHeader(const string& path, Codec& codec, unsigned long long& originalSize) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    unsigned char header[HEADER_SIZE];
+    bool ok = readFull(fd, header, HEADER_SIZE) == (ssize_t)HEADER_SIZE && memcmp(header, MAGIC, 4) == 0;
+    close(fd);
+    if (!ok) return false;
+    codec = (Codec)header[4];
+    originalSize = get64(header + 12);
+    return true;
+}
+
+// ===== Compress =====
+CopyResult Compressor::compressFile(const string& source, const string& dest, const CompressionSettings& settings,
+                                    Sha256* digest) {
+    CopyResult result;
+    result.method = name(settings.codec);
+    auto start = chrono::steady_clock::now();
+    if (settings.codec == Codec::None || !available(settings.codec)) {
+        result.error = ENOTSUP;
+        return result;
+    }
+
+    int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        result.error = errno;
+        return result;
+    }
+    struct stat st;
+    if (fstat(in, &st) != 0 || !S_ISREG(st.st_mode)) {
+        result.error = errno ? errno : EINVAL;
+        close(in);
+        return result;
+    }
+    int out = open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out < 0) {
+        result.error = errno;
+        close(in);
+        return result;
+    }
+    posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    size_t chunkSize = max<size_t>(64 * 1024, min(settings.chunkSize, MAX_CHUNK));
+    // Only files of several chunks are worth threads
+    size_t batch = (unsigned long long)st.st_size > 2 * chunkSize ? max<size_t>(settings.threads, 1) : 1;
+    unique_ptr<TaskPool> pool;
+    if (batch > 1) pool = make_unique<TaskPool>(batch, batch);
+
+    unsigned char header[HEADER_SIZE] = {0};
+    bool ok = writeAll(out, header, HEADER_SIZE);   // filled in once the size is known
+    uint64_t original = 0;
+    unsigned long long written = HEADER_SIZE;
+    vector<vector<char>> raw(batch), packed(batch);
+    while (ok) {
+        // Read a batch of chunks, compress them together, write them in order
+        size_t filled = 0;
+        for (; filled < batch; filled++) {
+            raw[filled].resize(chunkSize);
+            ssize_t n = readFull(in, raw[filled].data(), chunkSize);
+            if (n < 0) ok = false;
+            if (n <= 0) break;
+            raw[filled].resize(n);
+            if (digest) digest->update(raw[filled].data(), n);
+            if ((size_t)n < chunkSize) {
+                filled++;
+                break;
+            }
+        }
+        if (!ok || filled == 0) break;
+
+        for (size_t i = 0; i < filled; i++) {
+            auto task = [&, i] { packed[i] = compressChunk(settings.codec, settings.level, raw[i]); };
+            if (pool) pool->submit(task);
+            else task();
+        }
+        if (pool) pool->wait();
+
+        for (size_t i = 0; i < filled && ok; i++) {
+            const vector<char>& data = packed[i].empty() ? raw[i] : packed[i];
+            unsigned char chunkHeader[CHUNK_HEADER_SIZE];
+            put32(chunkHeader, raw[i].size());
+            put32(chunkHeader + 4, data.size());
+            ok = writeAll(out, chunkHeader, CHUNK_HEADER_SIZE) && writeAll(out, data.data(), data.size());
+            original += raw[i].size();
+            written += CHUNK_HEADER_SIZE + data.size();
+        }
+        if (raw[filled - 1].size() < chunkSize) break;   // end of file
+    }
+    if (!ok) result.error = errno ? errno : EIO;
+
+    if (ok) {
+        memcpy(header, MAGIC, 4);
+        header[4] = (unsigned char)settings.codec;
+        put32(header + 8, chunkSize);
+        put64(header + 12, original);
+        ok = pwrite(out, header, HEADER_SIZE, 0) == (ssize_t)HEADER_SIZE;
+        if (!ok) result.error = errno;
+    }
+    if (ok) copyMetadata(st, out);
+    posix_fadvise(in, 0, 0, POSIX_FADV_DONTNEED);   // a backup should not evict the working set
+    close(in);
+    if (close(out) != 0 && ok) {
+        ok = false;
+        result.error = errno;
+    }
+
+    result.ok = ok;
+    result.bytes = written;
+    result.files = ok ? 1 : 0;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// ===== Decompress =====
+CopyResult Compressor::decompressFile(const string& source, const string& dest) {
+    CopyResult result;
+    auto start = chrono::steady_clock::now();
+
+    int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        result.error = errno;
+        return result;
+    }
+    struct stat st;
+    unsigned char header[HEADER_SIZE];
+    if (fstat(in, &st) != 0 || readFull(in, header, HEADER_SIZE) != (ssize_t)HEADER_SIZE ||
+        memcmp(header, MAGIC, 4) != 0) {
+        result.error = errno ? errno : EINVAL;
+        close(in);
+        return result;
+    }
+    Codec codec = (Codec)header[4];
+    uint64_t original = get64(header + 12);
+    result.method = name(codec);
+    if (!available(codec)) {
+        result.error = ENOTSUP;
+        close(in);
+        return result;
+    }
+    int out = open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out < 0) {
+        result.error = errno;
+        close(in);
+        return result;
+    }
+    posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    uint64_t restored = 0;
+    bool ok = decodeChunks(in, codec, original, restored,
+                           [out](const char* data, size_t length) { return writeAll(out, data, length); });
+    if (!ok) result.error = errno ? errno : EIO;
+
+    if (ok) copyMetadata(st, out);
+    posix_fadvise(in, 0, 0, POSIX_FADV_DONTNEED);
+    close(in);
+    if (close(out) != 0 && ok) {
+        ok = false;
+        result.error = errno;
+    }
+
+    result.ok = ok && restored == original;
+    if (ok && !result.ok) result.error = EINVAL;
+    result.bytes = restored;
+    result.files = result.ok ? 1 : 0;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+string Compressor::hashContent(const string& source) {
+    int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return "";
+    unsigned char header[HEADER_SIZE];
+    bool ok = readFull(in, header, HEADER_SIZE) == (ssize_t)HEADER_SIZE && memcmp(header, MAGIC, 4) == 0 &&
+              available((Codec)header[4]);
+    uint64_t original = ok ? get64(header + 12) : 0;
+    uint64_t restored = 0;
+    Sha256 digest;
+    if (ok) {
+        posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+        ok = decodeChunks(in, (Codec)header[4], original, restored, [&digest](const char* data, size_t length) {
+            digest.update(data, length);
+            return true;
+        });
+        posix_fadvise(in, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    close(in);
+    return ok && restored == original ? digest.hexDigest() : "";
+}
@@ -0,0 +1,199 @@
+#include "../include/copy_engine.h"
+#include <vector>
+#include <chrono>
+#include <cerrno>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+    // The kernel cannot do this copy this way; try the next mechanism
+    bool unsupported(int err) {
+        return err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP || err == ENOTSUP;
+    }
+
+    // Each stage copies from `offset` until EOF. Returns false with errno set
+    // when the mechanism is unsupported or failed; `offset` tells how far it got.
+    bool copyRange(int in, int out, off_t& offset) {
+#ifdef __linux__
+        while (true) {
+            loff_t inOffset = offset;
+            ssize_t n = copy_file_range(in, &inOffset, out, nullptr, 1 << 30, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return false;
+            if (n == 0) return true;
+            offset += n;
+        }
+#else
+        (void)in; (void)out; (void)offset;
+        errno = ENOSYS;
+        return false;
+#endif
+    }
+
+    bool sendFile(int in, int out, off_t& offset) {
+#ifdef __linux__
+        while (true) {
+            ssize_t n = sendfile(out, in, &offset, 1 << 30);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return false;
+            if (n == 0) return true;
+        }
+#else
+        (void)in; (void)out; (void)offset;
+        errno = ENOSYS;
+        return false;
+#endif
+    }
+
+    bool readWrite(int in, int out, off_t& offset, size_t bufferSize, Sha256* digest) {
+        vector<char> buffer(bufferSize);
+        while (true) {
+            ssize_t n = pread(in, buffer.data(), buffer.size(), offset);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return false;
+            if (n == 0) return true;
+            if (digest) digest->update(buffer.data(), n);
+            for (ssize_t done = 0; done < n;) {
+                ssize_t w = write(out, buffer.data() + done, n - done);
+                if (w < 0 && errno == EINTR) continue;
+                if (w < 0) return false;
+                done += w;
+            }
+            offset += n;
+        }
+    }
+}
+
+// ===== Single file =====
+CopyResult CopyEngine::copyFile(const string& source, const string& dest, Sha256* digest) {
+    CopyResult result;
+    auto start = chrono::steady_clock::now();
+
+    errno = 0;
+    int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        result.error = errno;
+        return result;
+    }
+    struct stat st;
+    if (fstat(in, &st) != 0 || !S_ISREG(st.st_mode)) {
+        result.error = errno ? errno : EINVAL;
+        close(in);
+        return result;
+    }
+    int out = open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out < 0) {
+        result.error = errno;
+        close(in);
+        return result;
+    }
+    posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // Stream the data; a hashed copy has to see every byte
+    off_t offset = 0;
+    bool ok = false;
+    errno = ENOTSUP;
+    if (!digest) {
+        ok = copyRange(in, out, offset);
+        result.method = "copy_file_range";
+        // Some pseudo files claim a size but give copy_file_range (or
+        // sendfile) nothing; plain reads still get their content
+        if (ok && offset == 0 && st.st_size > 0) {
+            ok = false;
+            errno = EINVAL;
+        }
+        if (!ok && unsupported(errno)) {
+            ok = sendFile(in, out, offset);
+            result.method = "sendfile";
+            if (ok && offset == 0 && st.st_size > 0) {
+                ok = false;
+                errno = EINVAL;
+            }
+        }
+    }
+    if (!ok && unsupported(errno)) {
+        // The destination may have been written to part-way; continue from offset
+        if (lseek(out, offset, SEEK_SET) == offset) {
+            size_t bufferSize = st.st_size > 0 && (size_t)st.st_size < BUFFER_SIZE ? max((size_t)st.st_size, (size_t)65536) : BUFFER_SIZE;
+            ok = readWrite(in, out, offset, bufferSize, digest);
+            result.method = "read/write";
+        }
+    }
+    if (!ok) result.error = errno;
+
+    if (ok) {
+        // Metadata last: setting times before writing would be undone by the writes
+        if (fchown(out, st.st_uid, st.st_gid) != 0) {}   // only root may give files away
+        fchmod(out, st.st_mode & 07777);
+        struct timespec times[2] = {st.st_atim, st.st_mtim};
+        futimens(out, times);
+    }
+    posix_fadvise(in, 0, 0, POSIX_FADV_DONTNEED);   // a backup should not evict the working set
+    close(in);
+    if (close(out) != 0 && ok) {
+        ok = false;
+        result.error = errno;
+    }
+
+    result.ok = ok;
+    result.bytes = offset;
+    result.files = ok ? 1 : 0;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// ===== Directory trees =====
+CopyResult CopyEngine::copyTree(const string& source, const string& dest) {
+    CopyResult total;
+    auto start = chrono::steady_clock::now();
+    error_code ec;
+
+    auto add = [&total](const CopyResult& file) {
+        total.bytes += file.bytes;
+        total.files += file.files;
+        // Report the slowest mechanism that was needed
+        if (total.method.empty() || file.method == "read/write" ||
+            (file.method == "sendfile" && total.method == "copy_file_range")) {
+            total.method = file.method;
+        }
+        if (!file.ok && !total.error) total.error = file.error ? file.error : EIO;
+    };
+
+    if (!fs::is_directory(source, ec)) {
+        string target = fs::is_directory(dest, ec) ? (fs::path(dest) / fs::path(source).filename()).string() : dest;
+        add(copyFile(source, target));
+    } else {
+        fs::create_directories(dest, ec);
+        if (ec) total.error = ec.value();
+        for (auto it = fs::recursive_directory_iterator(source, fs::directory_options::skip_permission_denied, ec);
+             !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            fs::path target = fs::path(dest) / it->path().lexically_relative(source);
+            if (it->is_symlink(ec)) {
+                fs::remove(target, ec);
+                fs::copy_symlink(it->path(), target, ec);
+            } else if (it->is_directory(ec)) {
+                fs::create_directories(target, ec);
+            } else if (it->is_regular_file(ec)) {
+                add(copyFile(it->path().string(), target.string()));
+                continue;
+            } else {
+                continue;   // sockets, fifos and devices are not backed up
+            }
+            if (ec && !total.error) total.error = ec.value();
+            ec.clear();
+        }
+        if (ec && !total.error) total.error = ec.value();
+    }
+
+    total.ok = total.error == 0;
+    total.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return total;
+}
@@ -0,0 +1,188 @@
+#include "../include/dir_snapshot.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+    const double SINGLE_CHILD_SHARE = 0.9;   // growth this concentrated in one child is reported there
+
+    string joinPath(const string& dir, const string& name) {
+        return dir.size() && dir.back() == '/' ? dir + name : dir + "/" + name;
+    }
+}
+
+string DirSnapshot::parentOf(const string& path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == string::npos || path == "/") return "";
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+// ===== Taking a snapshot =====
+shared_ptr<DirSnapshot> DirSnapshot::take(const string& root, const DirSnapshot* previous, SnapshotStats* stats) {
+    auto start = chrono::steady_clock::now();
+    string rootDir = root;
+    while (rootDir.size() > 1 && rootDir.back() == '/') rootDir.pop_back();
+
+    shared_ptr<DirSnapshot> snapshot(new DirSnapshot(rootDir));
+    snapshot->timestamp = time(nullptr);
+    if (previous && previous->rootDir != rootDir) previous = nullptr;
+
+    SnapshotStats counters;
+    struct stat rootStat;
+    if (lstat(rootDir.c_str(), &rootStat) != 0 || !S_ISDIR(rootStat.st_mode)) {
+        if (stats) *stats = counters;
+        return snapshot;
+    }
+
+    vector<string> pending{rootDir};
+    while (!pending.empty()) {
+        string path = move(pending.back());
+        pending.pop_back();
+
+        struct stat st;
+        if (lstat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) continue;
+        if (st.st_dev != rootStat.st_dev) continue;   // another filesystem mounted here
+
+        Dir dir;
+        dir.mtime = st.st_mtim.tv_sec;
+        dir.mtimeNsec = st.st_mtim.tv_nsec;
+
+        const Dir* old = nullptr;
+        if (previous) {
+            auto it = previous->dirs.find(path);
+            if (it != previous->dirs.end()) old = &it->second;
+        }
+        // A directory modified in the same second it was listed may have
+        // changed after the listing, so it only counts as unchanged if its
+        // mtime is strictly older than that listing
+        bool unchanged = old && old->mtime == dir.mtime && old->mtimeNsec == dir.mtimeNsec &&
+                         old->mtime < old->readAt;
+
+        if (unchanged) {
+            dir.readAt = old->readAt;
+            dir.smallBytes = old->smallBytes;
+            dir.directFiles = old->directFiles;
+            dir.subdirs = old->subdirs;
+            int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            for (const auto& file : old->largeFiles) {
+                struct stat fileStat;
+                if (fd >= 0 && fstatat(fd, file.first.c_str(), &fileStat, AT_SYMLINK_NOFOLLOW) == 0) {
+                    dir.largeFiles.push_back({file.first, (unsigned long long)fileStat.st_size});
+                } else {
+                    dir.largeFiles.push_back(file);
+                }
+            }
+            if (fd >= 0) close(fd);
+            counters.directoriesReused++;
+        } else {
+            dir.readAt = time(nullptr);
+            DIR* handle = opendir(path.c_str());
+            if (handle) {
+                int fd = dirfd(handle);
+                struct dirent* entry;
+                while ((entry = readdir(handle)) != nullptr) {
+                    const char* name = entry->d_name;
+                    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+                    struct stat entryStat;
+                    if (fstatat(fd, name, &entryStat, AT_SYMLINK_NOFOLLOW) != 0) continue;
+                    if (S_ISDIR(entryStat.st_mode)) {
+                        dir.subdirs.push_back(name);
+                    } else if (S_ISREG(entryStat.st_mode)) {
+                        dir.directFiles++;
+                        if ((unsigned long long)entryStat.st_size >= LARGE_FILE) {
+                            dir.largeFiles.push_back({name, (unsigned long long)entryStat.st_size});
+                        } else {
+                            dir.smallBytes += entryStat.st_size;
+                        }
+                    }
+                }
+                closedir(handle);
+            }
+            counters.directoriesRead++;
+        }
+
+        for (const auto& sub : dir.subdirs) pending.push_back(joinPath(path, sub));
+        snapshot->dirs.emplace(path, move(dir));
+    }
+
+    // Children sort after their parent, so a reverse sweep sees every
+    // subtree complete before adding it to the parent
+    for (auto it = snapshot->dirs.rbegin(); it != snapshot->dirs.rend(); ++it) {
+        Dir& dir = it->second;
+        dir.bytes += dir.smallBytes;
+        for (const auto& file : dir.largeFiles) dir.bytes += file.second;
+        dir.files += dir.directFiles;
+        if (it->first == rootDir) continue;
+
+        auto parent = snapshot->dirs.find(parentOf(it->first));
+        if (parent != snapshot->dirs.end()) {
+            parent->second.bytes += dir.bytes;
+            parent->second.files += dir.files;
+        }
+    }
+
+    counters.elapsedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (stats) *stats = counters;
+    return snapshot;
+}
+
+// ===== Queries =====
+unsigned long long DirSnapshot::bytes(const string& path) const {
+    auto it = dirs.find(path);
+    return it != dirs.end() ? it->second.bytes : 0;
+}
+
+unsigned long long DirSnapshot::files(const string& path) const {
+    auto it = dirs.find(path);
+    return it != dirs.end() ? it->second.files : 0;
+}
+
+vector<DirGrowth> DirSnapshot::topGrowers(const DirSnapshot& older, const DirSnapshot& newer,
+                                          size_t limit, bool byFiles) {
+    auto deltaOf = [&](const string& path, const Dir& dir) {
+        return byFiles ? (long long)dir.files - (long long)older.files(path)
+                       : (long long)dir.bytes - (long long)older.bytes(path);
+    };
+
+    vector<DirGrowth> result;
+    for (const auto& entry : newer.dirs) {
+        const Dir& dir = entry.second;
+        long long delta = deltaOf(entry.first, dir);
+        if (delta <= 0) continue;
+
+        // Skip directories whose growth is really one subdirectory's
+        long long largestChild = 0;
+        for (const auto& sub : dir.subdirs) {
+            string childPath = joinPath(entry.first, sub);
+            auto child = newer.dirs.find(childPath);
+            if (child != newer.dirs.end()) largestChild = max(largestChild, deltaOf(childPath, child->second));
+        }
+        if (largestChild >= delta * SINGLE_CHILD_SHARE) continue;
+
+        DirGrowth growth;
+        growth.path = entry.first;
+        growth.bytesDelta = (long long)dir.bytes - (long long)older.bytes(entry.first);
+        growth.filesDelta = (long long)dir.files - (long long)older.files(entry.first);
+        growth.bytes = dir.bytes;
+        growth.files = dir.files;
+        result.push_back(growth);
+    }
+
+    auto byDelta = [byFiles](const DirGrowth& a, const DirGrowth& b) {
+        return byFiles ? a.filesDelta > b.filesDelta : a.bytesDelta > b.bytesDelta;
+    };
+    if (result.size() > limit) {
+        partial_sort(result.begin(), result.begin() + limit, result.end(), byDelta);
+        result.resize(limit);
+    } else {
+        sort(result.begin(), result.end(), byDelta);
+    }
+    return result;
+}
@@ -0,0 +1,165 @@
+#include "../include/dir_sync.h"
+#include "../include/copy_engine.h"
+#include "../include/sha256.h"
+#include <filesystem>
+#include <unordered_set>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+    struct Progress {
+        mutex progressMutex;
+        SyncReport report;
+    };
+
+    atomic<unsigned long> temporaries{0};
+
+    // CopyEngine gives copies the source's mtime, so an unchanged file matches to the nanosecond
+    bool unchanged(const string& source, const string& dest, const SyncOptions& options) {
+        struct stat s, d;
+        if (stat(source.c_str(), &s) != 0 || lstat(dest.c_str(), &d) != 0 || !S_ISREG(d.st_mode)) return false;
+        if (s.st_size != d.st_size || s.st_mtim.tv_sec != d.st_mtim.tv_sec || s.st_mtim.tv_nsec != d.st_mtim.tv_nsec) {
+            return false;
+        }
+        if (!options.compareHashes) return true;
+        string hash = Sha256::hashFile(source);
+        return !hash.empty() && hash == Sha256::hashFile(dest);
+    }
+
+    void syncFile(const string& source, const string& dest, const SyncOptions& options, Progress& progress) {
+        if (unchanged(source, dest, options)) {
+            lock_guard<mutex> lock(progress.progressMutex);
+            progress.report.unchanged++;
+            return;
+        }
+        // Copied next to `dest` and renamed over it, so the previous copy
+        // stays intact until the new one is complete (and a link at `dest`
+        // is replaced, not written through)
+        fs::path path(dest);
+        string temp = (path.parent_path() / ("." + path.filename().string() + "." + to_string(getpid()) + "." +
+                                             to_string(temporaries++) + ".sync.tmp")).string();
+        CopyResult copy = CopyEngine::copyFile(source, temp);
+        error_code ec;
+        if (copy.ok && fs::is_directory(fs::symlink_status(dest, ec))) fs::remove_all(dest, ec);   // was a directory
+        if (copy.ok && rename(temp.c_str(), dest.c_str()) != 0) {
+            copy.ok = false;
+            copy.error = errno;
+        }
+        if (!copy.ok) unlink(temp.c_str());
+
+        lock_guard<mutex> lock(progress.progressMutex);
+        if (copy.ok) {
+            progress.report.copied++;
+            progress.report.bytesCopied += copy.bytes;
+        } else {
+            progress.report.failed++;
+            if (!progress.report.error) progress.report.error = copy.error ? copy.error : EIO;
+        }
+    }
+
+    // Makes `target` a symlink to the same place as `link`, unless it already is one
+    bool syncSymlink(const fs::path& link, const fs::path& target) {
+        error_code ec;
+        fs::path wanted = fs::read_symlink(link, ec);
+        if (ec) return false;
+        if (fs::is_symlink(fs::symlink_status(target, ec)) && fs::read_symlink(target, ec) == wanted) return true;
+        fs::remove_all(target, ec);
+        fs::create_symlink(wanted, target, ec);
+        return !ec;
+    }
+}
+
+SyncReport DirSync::sync(const string& source, const string& dest, const SyncOptions& options) {
+    auto start = chrono::steady_clock::now();
+    Progress progress;
+    SyncReport& report = progress.report;
+    error_code ec;
+
+    if (!fs::exists(source, ec)) {
+        report.error = ENOENT;
+        return report;
+    }
+    if (!fs::is_directory(source, ec)) {
+        string target = fs::is_directory(dest, ec) ? (fs::path(dest) / fs::path(source).filename()).string() : dest;
+        report.files = 1;
+        syncFile(source, target, options, progress);
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+    if (fs::exists(fs::symlink_status(dest, ec)) && !fs::is_directory(fs::symlink_status(dest, ec))) fs::remove(dest, ec);
+    fs::create_directories(dest, ec);
+    if (ec) {
+        report.error = ec.value();
+        return report;
+    }
+    fs::path destRoot = fs::weakly_canonical(dest, ec);
+
+    // Walk the source; files are compared and copied on the pool meanwhile
+    unordered_set<string> seen;
+    {
+        TaskPool pool(options.threads);
+        auto walk = fs::recursive_directory_iterator(source, fs::directory_options::skip_permission_denied, ec);
+        for (; !ec && walk != fs::recursive_directory_iterator(); walk.increment(ec)) {
+            const fs::path& path = walk->path();
+            string relative = path.lexically_relative(source).string();
+            fs::path target = fs::path(dest) / relative;
+            error_code entryError;
+            if (walk->is_symlink(entryError)) {
+                seen.insert(relative);
+                if (!syncSymlink(path, target)) {
+                    lock_guard<mutex> lock(progress.progressMutex);
+                    report.failed++;
+                }
+            } else if (walk->is_directory(entryError)) {
+                if (fs::equivalent(path, destRoot, entryError)) {
+                    walk.disable_recursion_pending();   // a destination inside the source is not copied into itself
+                    continue;
+                }
+                seen.insert(relative);
+                if (!fs::is_directory(fs::symlink_status(target, entryError))) {
+                    fs::remove(target, entryError);
+                    fs::create_directory(target, entryError);
+                }
+            } else if (walk->is_regular_file(entryError)) {
+                seen.insert(relative);
+                report.files++;
+                pool.submit([&progress, &options, source = path.string(), target = target.string()] {
+                    syncFile(source, target, options, progress);
+                });
+            }
+            // sockets, fifos and devices are not backed up
+        }
+    }   // the pool finishes its copies here
+    if (ec && !report.error) report.error = ec.value();
+
+    // Remove what the source no longer has
+    if (options.removeDeleted && report.error == 0) {
+        vector<fs::path> gone;
+        error_code walkError;
+        auto walk = fs::recursive_directory_iterator(dest, walkError);
+        for (; !walkError && walk != fs::recursive_directory_iterator(); walk.increment(walkError)) {
+            fs::path relative = walk->path().lexically_relative(dest);
+            if (seen.count(relative.string())) continue;
+            // A directory the walk could not read says nothing about its contents
+            if (access((fs::path(source) / relative.parent_path()).c_str(), R_OK | X_OK) != 0) continue;
+            gone.push_back(walk->path());
+            walk.disable_recursion_pending();   // removed as a whole
+        }
+        for (const auto& path : gone) {
+            error_code removeError;
+            if (fs::remove_all(path, removeError) > 0) report.removed++;
+        }
+    }
+
+    report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return report;
+}
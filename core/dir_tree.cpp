@@ -0,0 +1,164 @@
+#include "../include/dir_tree.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+DirTree::DirTree(const string& rootPath) : rootDir(rootPath) {
+    nodes.reserve(1024);
+    namePool.reserve(16 * 1024);
+
+    DirNode rootNode;
+    rootNode.nameOffset = 0;
+    rootNode.nameLength = static_cast<uint32_t>(rootPath.size());
+    namePool.insert(namePool.end(), rootPath.begin(), rootPath.end());
+    nodes.push_back(rootNode);
+}
+
+// ===== Builder =====
+NodeId DirTree::addDirectory(NodeId parent, const string& name) {
+    NodeId id = static_cast<NodeId>(nodes.size());
+
+    DirNode node;
+    node.parent = parent;
+    node.nameOffset = static_cast<uint32_t>(namePool.size());
+    node.nameLength = static_cast<uint32_t>(name.size());
+    namePool.insert(namePool.end(), name.begin(), name.end());
+
+    DirNode& p = nodes[parent];
+    node.nextSibling = p.firstChild;
+    p.firstChild = id;
+    p.childCount++;
+    p.directEntries++;
+
+    nodes.push_back(node);
+    return id;
+}
+
+void DirTree::addFile(NodeId parent, unsigned long long size, time_t mtime) {
+    DirNode& p = nodes[parent];
+    p.directBytes += size;
+    p.directFiles++;
+    p.directEntries++;
+    if (mtime > p.maxMtime) p.maxMtime = mtime;
+}
+
+void DirTree::addEntry(NodeId parent) {
+    nodes[parent].directEntries++;
+}
+
+void DirTree::finalize() {
+    for (auto& n : nodes) {
+        n.bytes = n.directBytes;
+        n.files = n.directFiles;
+        n.entries = n.directEntries;
+    }
+    // Children always come after their parent, so one reverse sweep suffices
+    for (size_t i = nodes.size(); i-- > 1;) {
+        DirNode& child = nodes[i];
+        DirNode& parent = nodes[child.parent];
+        parent.bytes += child.bytes;
+        parent.files += child.files;
+        parent.entries += child.entries;
+        if (child.maxMtime > parent.maxMtime) parent.maxMtime = child.maxMtime;
+    }
+}
+
+// ===== Single-pass walk =====
+shared_ptr<DirTree> DirTree::build(const string& path) {
+    auto tree = make_shared<DirTree>(path);
+
+    // Pending directories are kept as node IDs rather than open descriptors
+    // so a directory with 100k subdirectories cannot exhaust the fd limit.
+    vector<NodeId> pending;
+    pending.push_back(tree->root());
+
+    while (!pending.empty()) {
+        NodeId current = pending.back();
+        pending.pop_back();
+
+        DIR* dir = opendir(tree->path(current).c_str());
+        if (!dir) continue;
+        int fd = dirfd(dir);
+
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            const char* name = entry->d_name;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+            struct stat st;
+            if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+
+            if (S_ISDIR(st.st_mode)) {
+                pending.push_back(tree->addDirectory(current, name));
+            } else if (S_ISREG(st.st_mode)) {
+                tree->addFile(current, st.st_size, st.st_mtime);
+            } else {
+                tree->addEntry(current);
+            }
+        }
+        closedir(dir);
+    }
+
+    tree->finalize();
+    return tree;
+}
+
+// ===== Queries =====
+string DirTree::name(NodeId id) const {
+    const DirNode& n = nodes[id];
+    return string(namePool.data() + n.nameOffset, n.nameLength);
+}
+
+string DirTree::path(NodeId id) const {
+    vector<NodeId> chain;
+    for (NodeId cur = id; cur != NO_NODE; cur = nodes[cur].parent) chain.push_back(cur);
+
+    string result;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (!result.empty() && result.back() != '/') result += '/';
+        result += name(*it);
+    }
+    return result;
+}
+
+vector<NodeId> DirTree::children(NodeId id) const {
+    vector<NodeId> result;
+    result.reserve(nodes[id].childCount);
+    for (NodeId c = nodes[id].firstChild; c != NO_NODE; c = nodes[c].nextSibling) {
+        result.push_back(c);
+    }
+    return result;
+}
+
+vector<NodeId> DirTree::largestChildren(NodeId id, size_t limit) const {
+    vector<NodeId> result = children(id);
+    auto bySize = [this](NodeId a, NodeId b) { return nodes[a].bytes > nodes[b].bytes; };
+    if (result.size() > limit) {
+        partial_sort(result.begin(), result.begin() + limit, result.end(), bySize);
+        result.resize(limit);
+    } else {
+        sort(result.begin(), result.end(), bySize);
+    }
+    return result;
+}
+
+vector<NodeId> DirTree::busiestDirectories(size_t limit, bool subtree) const {
+    vector<NodeId> result;
+    result.reserve(nodes.size());
+    for (NodeId id = subtree ? 1 : 0; id < nodes.size(); id++) result.push_back(id);
+
+    auto byEntries = [this, subtree](NodeId a, NodeId b) {
+        return subtree ? nodes[a].entries > nodes[b].entries : nodes[a].directEntries > nodes[b].directEntries;
+    };
+    if (result.size() > limit) {
+        partial_sort(result.begin(), result.begin() + limit, result.end(), byEntries);
+        result.resize(limit);
+    } else {
+        sort(result.begin(), result.end(), byEntries);
+    }
+    return result;
+}
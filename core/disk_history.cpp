@@ -0,0 +1,113 @@
+#include "../include/disk_history.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+    const double LEVEL_SMOOTHING = 0.5;
+    const double TREND_SMOOTHING = 0.2;
+    const size_t MIN_MODEL_UPDATES = 5;   // minutes of history before the model is trusted
+}
+
+UsageHistory::UsageHistory(size_t secondSlots, size_t minuteSlots, size_t hourSlots)
+    : seconds(secondSlots), minutes(minuteSlots), hours(hourSlots),
+      level(0), trend(0), modelTime(0), modelUpdates(0) {}
+
+// ===== Recording =====
+void UsageHistory::add(const HistoryPoint& point) {
+    seconds.push(point);
+
+    // Coarser series keep the first sample of each minute / hour
+    if (minutes.empty() || point.timestamp / 60 != minutes.back().timestamp / 60) {
+        minutes.push(point);
+        updateModel(point);
+    }
+    if (hours.empty() || point.timestamp / 3600 != hours.back().timestamp / 3600) {
+        hours.push(point);
+    }
+}
+
+void UsageHistory::updateModel(const HistoryPoint& point) {
+    double x = static_cast<double>(point.used);
+    if (modelUpdates == 0) {
+        level = x;
+        trend = 0;
+    } else {
+        double dt = static_cast<double>(max<time_t>(1, point.timestamp - modelTime));
+        double previous = level;
+        level = LEVEL_SMOOTHING * x + (1 - LEVEL_SMOOTHING) * (level + trend * dt);
+        trend = TREND_SMOOTHING * (level - previous) / dt + (1 - TREND_SMOOTHING) * trend;
+    }
+    modelTime = point.timestamp;
+    modelUpdates++;
+}
+
+const RingBuffer<HistoryPoint>& UsageHistory::series(Resolution resolution) const {
+    switch (resolution) {
+    case Minutes: return minutes;
+    case Hours:   return hours;
+    default:      return seconds;
+    }
+}
+
+// ===== Analysis =====
+double UsageHistory::fillRate(time_t window) const {
+    if (seconds.empty()) return 0;
+    time_t now = seconds.back().timestamp;
+    time_t since = now - window;
+
+    const RingBuffer<HistoryPoint>* source = &hours;
+    if (seconds[0].timestamp <= since) source = &seconds;
+    else if (!minutes.empty() && minutes[0].timestamp <= since) source = &minutes;
+
+    // Times relative to `now` keep the sums well-conditioned
+    double n = 0, sumT = 0, sumY = 0, sumTT = 0, sumTY = 0;
+    for (size_t i = source->size(); i-- > 0;) {
+        const HistoryPoint& p = (*source)[i];
+        if (p.timestamp < since) break;
+        double t = static_cast<double>(p.timestamp - now);
+        double y = static_cast<double>(p.used);
+        n++; sumT += t; sumY += y; sumTT += t * t; sumTY += t * y;
+    }
+    double denom = n * sumTT - sumT * sumT;
+    if (n < 2 || denom <= 0) return 0;
+    return (n * sumTY - sumT * sumY) / denom;
+}
+
+double UsageHistory::growth(time_t window) const {
+    if (seconds.empty()) return 0;
+    const HistoryPoint& now = seconds.back();
+    time_t since = now.timestamp - window;
+
+    const RingBuffer<HistoryPoint>* source = &hours;
+    if (seconds[0].timestamp <= since) source = &seconds;
+    else if (!minutes.empty() && minutes[0].timestamp <= since) source = &minutes;
+    if (source->empty()) return 0;
+
+    // First point inside the window; series are in time order
+    size_t lo = 0, hi = source->size() - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if ((*source)[mid].timestamp < since) lo = mid + 1;
+        else hi = mid;
+    }
+    const HistoryPoint& start = (*source)[lo];
+    if (start.timestamp >= now.timestamp) return 0;
+    return ((double)now.used - (double)start.used) / (now.timestamp - start.timestamp);
+}
+
+Forecast UsageHistory::forecast() const {
+    Forecast f;
+    if (seconds.empty()) return f;
+
+    if (modelUpdates >= MIN_MODEL_UPDATES) {
+        f.fillRate = trend;
+        f.reliable = true;
+    } else {
+        // Not enough minutes yet: fall back to a regression over raw samples
+        f.fillRate = fillRate(seconds.back().timestamp - seconds[0].timestamp);
+        f.reliable = false;
+    }
+    if (f.fillRate > 0) f.secondsToFull = seconds.back().available / f.fillRate;
+    return f;
+}
@@ -1,7 +1,13 @@
 #include "../include/disk_monitor.h"
 #include "../include/utils.h"
+#include "../include/dir_tree.h"
+#include "../include/size_estimator.h"
+#include "../include/live_index.h"
+#include "../include/fs_watcher.h"
+#include "../include/mount_table.h"
 #include <iostream>
 #include <iomanip>
+#include <cassert>
 #include <sys/statvfs.h>
 #include <dirent.h>
 #include <sys/stat.h>
@@ -12,10 +18,14 @@
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <mutex>
+#include <csignal>
+#include <cmath>
 
 #define RESET   "\033[0m"
 #define GREEN   "\033[32m"
 #define YELLOW  "\033[33m"
+#define RED     "\033[31m"
 #define CYAN    "\033[36m"
 #define BOLD    "\033[1m"
 
@@ -26,75 +36,409 @@ using namespace std;
 void DiskMonitor::scanPath(const string& path, bool verbose) {
     showDiskUsage(path);
     cout << "\n";
-    showLargestDirectories(path);
+    if (!Utils::isDirectory(path)) {
+        showLargestDirectories(path);
+        return;
+    }
+    auto tree = DirTree::build(path);
+    showLargestDirectories(*tree, 5);
+    showEntryHotspots(*tree, 5);
 }
 
 void DiskMonitor::showDiskUsage(const string& path) {
-    struct statvfs stat;
-    
-    if (statvfs(path.c_str(), &stat) != 0) {
+    VolumeStats volume;
+    if (!MountTable::instance().stats(path, volume)) {
         cerr << "\n⚠️  Warning: Cannot get disk statistics for " << path << "\n";
         return;
     }
 
-    unsigned long long total = stat.f_blocks * stat.f_frsize;
-    unsigned long long available = stat.f_bavail * stat.f_frsize;
+    unsigned long long total = volume.total;
+    unsigned long long available = volume.available;
     unsigned long long used = total - available;
-    double percentage = (used * 100.0) / total;
+    double percentage = total ? (used * 100.0) / total : 0.0;
     
     cout << BOLD << "╔════════════════════════════════════════╗\n";
     cout << "║        DISK USAGE STATISTICS          ║\n";
     cout << "╚════════════════════════════════════════╝\n" << RESET;
     
     cout << "\nFilesystem: " << path << "\n";
+    if (!volume.mount.fsType.empty()) {
+        cout << "Mounted On:     " << volume.mount.mountPoint << " (" << volume.mount.fsType << ", "
+             << volume.mount.device << (volume.mount.readOnly ? ", read-only" : "") << ")\n";
+    }
     cout << "Total Size:     " << formatSize(total) << "\n";
     cout << "Used Space:     " << formatSize(used) << "  ";
     printProgressBar(percentage);
     cout << " " << fixed << setprecision(1) << percentage << "%\n";
     cout << "Free Space:     " << formatSize(available) << "\n";
+    if (volume.inodesTotal > 0) {   // some filesystems (btrfs, tmpfs without nr_inodes) report no limit
+        unsigned long long inodesUsed = volume.inodesTotal - volume.inodesFree;
+        double inodePercent = inodesUsed * 100.0 / volume.inodesTotal;
+        cout << "Inodes Used:    " << inodesUsed << " / " << volume.inodesTotal << "  ";
+        printProgressBar(inodePercent);
+        cout << " " << fixed << setprecision(1) << inodePercent << "%\n";
+    }
     
-    if (percentage > 75) {
-        cout << YELLOW << "\n⚠️  WARNING: Disk usage above 75% - cleanup recommended\n" << RESET;
-    } else {
+    // Alert rules from ~/.spacemate/alerts.conf (or the defaults), with the
+    // fill rate taken from the last day of recorded monitoring history
+    DiskSample sample;
+    sample.path = path;
+    sample.timestamp = time(nullptr);
+    sample.total = volume.total;
+    sample.free = volume.free;
+    sample.available = volume.available;
+    sample.inodesTotal = volume.inodesTotal;
+    sample.inodesFree = volume.inodesFree;
+    UsageHistory history;
+    time_t now = sample.timestamp;
+    for (const auto& point : HistoryStore(historyFile).read(path, now - 86400, now)) history.add(point);
+    if (!history.empty()) {
+        history.add({sample.timestamp, sample.total - sample.available, sample.available, sample.inodesFree});
+        Forecast f = history.forecast();
+        sample.fillRate = f.fillRate;
+        sample.secondsToFull = f.reliable ? f.secondsToFull : -1;
+    }
+
+    AlertEngine engine;
+    if (!engine.loadConfig(AlertEngine::defaultConfigFile())) engine.loadDefaults();
+    engine.clearSinks();
+    auto raised = engine.evaluate(sample, [&history](const string&, time_t window) { return history.growth(window); });
+
+    if (raised.empty()) {
         cout << GREEN << "\n✓ Disk usage is healthy\n" << RESET;
+        return;
+    }
+    cout << "\n";
+    for (const auto& alert : raised) {
+        cout << (alert.severity == AlertSeverity::Critical ? RED : YELLOW) << "⚠️  "
+             << AlertEngine::severityName(alert.severity) << ": " << alert.message
+             << " (" << alert.rule << ")" << RESET << "\n";
+    }
+    if (sample.secondsToFull >= 0) {
+        cout << "   At the current rate the disk is full in " << Utils::formatDuration(sample.secondsToFull) << "\n";
     }
 }
 
 void DiskMonitor::showLargestDirectories(const string& path, int limit) {
-    cout << BOLD << "\nTop " << limit << " Largest Directories:\n" << RESET;
-    
-    map<string, unsigned long long> dirSizes;
-    
-    DIR* dir = opendir(path.c_str());
-    if (!dir) {
+    if (!Utils::isDirectory(path)) {
+        cout << BOLD << "\nTop " << limit << " Largest Directories:\n" << RESET;
         cout << "  Unable to scan directories\n";
         return;
     }
-    
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        if (entry->d_name[0] == '.') continue;
-        
-        string fullPath = path + "/" + entry->d_name;
-        struct stat st;
-        
-        if (stat(fullPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
-            // Approximation: actual size calculation can be recursive
-            dirSizes[entry->d_name] = st.st_size * 1000;
+    showLargestDirectories(*DirTree::build(path), limit);
+}
+
+void DiskMonitor::showLargestDirectories(const DirTree& tree, int limit) {
+    cout << BOLD << "\nTop " << limit << " Largest Directories:\n" << RESET;
+    int count = 0;
+    for (NodeId id : tree.largestChildren(tree.root(), limit)) {
+        const DirNode& node = tree.node(id);
+        string name = tree.name(id);
+        cout << "  " << (++count) << ". " << CYAN << name << "/" << RESET;
+        cout << string(name.length() < 30 ? 30 - name.length() : 1, ' ');
+        cout << formatSize(node.bytes) << "  (" << node.files << " files)\n";
+    }
+}
+
+// Directories holding the most entries - where the inodes went
+void DiskMonitor::showEntryHotspots(const DirTree& tree, int limit) {
+    auto printRanking = [&](bool subtree) {
+        int count = 0;
+        for (NodeId id : tree.busiestDirectories(limit, subtree)) {
+            const DirNode& node = tree.node(id);
+            if (node.entries == 0) break;
+            string relative = id == tree.root() ? "." : tree.path(id).substr(tree.rootPath().size());
+            if (!relative.empty() && relative[0] == '/') relative.erase(0, 1);
+            cout << "  " << (++count) << ". " << CYAN << relative << "/" << RESET;
+            cout << string(relative.length() < 30 ? 30 - relative.length() : 1, ' ');
+            cout << node.directEntries << " entries  (" << node.entries << " in subtree)\n";
         }
+        if (count == 0) cout << "  (no entries)\n";
+    };
+
+    cout << BOLD << "\nTop " << limit << " Directories by Entry Count:\n" << RESET;
+    printRanking(false);
+    cout << BOLD << "\nTop " << limit << " Subtrees by Entry Count:\n" << RESET;
+    printRanking(true);
+}
+
+void DiskMonitor::estimatePath(const string& path, double seconds, int limit) {
+    if (!Utils::isDirectory(path)) {
+        cerr << "\n⚠️  Warning: Cannot estimate " << path << " - not a directory\n";
+        return;
     }
-    closedir(dir);
-    
-    vector<pair<string, unsigned long long>> sortedDirs(dirSizes.begin(), dirSizes.end());
-    sort(sortedDirs.begin(), sortedDirs.end(), 
-         [](const auto& a, const auto& b) { return a.second > b.second; });
-    
+
+    SizeEstimator estimator(path);
+    auto printLine = [this](const SizeEstimate& e) {
+        cout << "\r  ~" << formatSize((unsigned long long)e.bytes)
+             << "  ±" << fixed << setprecision(1) << e.relativeError() * 100 << "%"
+             << "  (" << e.probes << " probes, " << e.directoriesRead << " dirs read)   " << flush;
+    };
+    SizeEstimate est = estimator.run(seconds, 0.05, [&](const SizeEstimate& e) {
+        printLine(e);
+        return true;
+    });
+    printLine(est);
+    cout << "\n\n";
+
+    cout << BOLD << "╔════════════════════════════════════════╗\n";
+    cout << "║        ESTIMATED TREE SIZE            ║\n";
+    cout << "╚════════════════════════════════════════╝\n" << RESET;
+    cout << "\nPath:           " << path << "\n";
+    cout << "Size:           " << formatSize((unsigned long long)est.bytes)
+         << "  (95%: " << formatSize((unsigned long long)est.bytesLow)
+         << " - " << formatSize((unsigned long long)est.bytesHigh) << ")\n";
+    cout << "Files:          ~" << (unsigned long long)est.files
+         << "  (95%: " << (unsigned long long)est.filesLow
+         << " - " << (unsigned long long)est.filesHigh << ")\n";
+    cout << "Sampled:        " << est.directoriesRead << " directories in "
+         << setprecision(1) << est.elapsedSeconds << "s\n";
+
+    cout << BOLD << "\nTop " << limit << " Largest Directories (estimated):\n" << RESET;
     int count = 0;
-    for (const auto& item : sortedDirs) {
-        if (count++ >= limit) break;
-        cout << "  " << (count) << ". " << CYAN << item.first << "/" << RESET;
-        cout << string(30 - item.first.length(), ' ');
-        cout << formatSize(item.second) << "\n";
+    for (const auto& child : est.children) {
+        if (count >= limit) break;
+        cout << "  " << (++count) << ". " << CYAN << child.name << "/" << RESET;
+        cout << string(child.name.length() < 30 ? 30 - child.name.length() : 1, ' ');
+        cout << formatSize((unsigned long long)child.bytes);
+        if (child.bytesMargin > 0) cout << "  ±" << formatSize((unsigned long long)child.bytesMargin);
+        cout << "\n";
+    }
+    if (est.relativeError() > 0.05) {
+        cout << YELLOW << "\n⚠️  Interval wider than ±5% - rerun with a longer --time for a tighter answer\n" << RESET;
+    }
+}
+
+namespace {
+    volatile sig_atomic_t interrupted = 0;
+    void onInterrupt(int) { interrupted = 1; }
+}
+
+void DiskMonitor::monitorPath(const string& path, double intervalSeconds, double durationSeconds,
+                              double growthSeconds) {
+    DiskSample first;
+    if (!takeSample(path, first)) {
+        cerr << "\n⚠️  Warning: Cannot get disk statistics for " << path << "\n";
+        return;
+    }
+
+    cout << "Watching " << path << " every " << intervalSeconds << "s";
+    cout << (durationSeconds > 0 ? " for " + Utils::formatDuration(durationSeconds) : string(" (Ctrl+C to stop)")) << "\n";
+    cout << "Only changes are printed.\n";
+
+    mutex printMutex;
+    SubscriptionId id = subscribe([&](const DiskSample& s) {
+        char when[16];
+        strftime(when, sizeof(when), "%H:%M:%S", localtime(&s.timestamp));
+
+        lock_guard<mutex> lock(printMutex);
+        cout << "[" << when << "] used " << formatSize(s.total - s.available)
+             << " (" << fixed << setprecision(1) << s.usedPercent() << "%)"
+             << "  free " << formatSize(s.available);
+        if (s.fillRate != 0) {
+            cout << "  rate " << (s.fillRate > 0 ? "+" : "-")
+                 << formatSize((unsigned long long)(fabs(s.fillRate) * 3600)) << "/h";
+        }
+        if (s.inodesTotal > 0) cout << "  inodes " << setprecision(1) << s.inodesUsedPercent() << "%";
+        if (s.secondsToFull >= 0 && s.secondsToFull < 3 * 3600) {
+            cout << RED << "  ⚠️  full in " << Utils::formatDuration(s.secondsToFull) << RESET;
+        } else if (s.secondsToFull >= 0 && s.secondsToFull < 86400) {
+            cout << YELLOW << "  full in " << Utils::formatDuration(s.secondsToFull) << RESET;
+        }
+        cout << "\n" << flush;
+    });
+
+    SubscriptionId growthId = subscribeGrowth([&](const string&, const vector<DirGrowth>& byBytes,
+                                                  const vector<DirGrowth>& byFiles) {
+        lock_guard<mutex> lock(printMutex);
+        if (!byBytes.empty()) {
+            cout << BOLD << "  Grew the most since the last snapshot:\n" << RESET;
+            for (const auto& g : byBytes) {
+                cout << "    " << CYAN << g.path << RESET << "  +" << formatSize(g.bytesDelta)
+                     << "  (now " << formatSize(g.bytes) << ")\n";
+            }
+        }
+        if (!byFiles.empty()) {
+            cout << BOLD << "  Most new files:\n" << RESET;
+            for (const auto& g : byFiles) {
+                cout << "    " << CYAN << g.path << RESET << "  +" << g.filesDelta
+                     << " files  (now " << g.files << ")\n";
+            }
+        }
+        cout << flush;
+    });
+    if (growthSeconds > 0) {
+        setGrowthTracking(chrono::seconds((long long)max(1.0, growthSeconds)));
+        cout << "Directory growth is compared every " << Utils::formatDuration(growthSeconds) << ".\n";
+    }
+
+    string alertError;
+    if (!alerts.loadConfig(AlertEngine::defaultConfigFile(), &alertError)) {
+        if (Utils::fileExists(AlertEngine::defaultConfigFile())) cerr << "⚠️  " << alertError << " - using default alert rules\n";
+        alerts.loadDefaults();
+    }
+    if (alerts.sinkCount() == 0) {
+        alerts.addSink(make_shared<StdoutAlertSink>());
+        alerts.addSink(make_shared<LogFileAlertSink>(Utils::getHomeDir() + "/.spacemate/logs/alerts.log"));
+    }
+    cout << alerts.rules().size() << " alert rule(s) active.\n\n";
+
+    interrupted = 0;
+    auto previousHandler = signal(SIGINT, onInterrupt);
+    setInterval(chrono::milliseconds((long long)(intervalSeconds * 1000)));
+    startMonitoring(path);
+
+    auto start = chrono::steady_clock::now();
+    while (!interrupted) {
+        this_thread::sleep_for(chrono::milliseconds(100));
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (durationSeconds > 0 && elapsed >= durationSeconds) break;
+    }
+
+    stopMonitoring();
+    unsubscribe(id);
+    unsubscribe(growthId);
+    signal(SIGINT, previousHandler);
+
+    Forecast f = forecast(path);
+    cout << BOLD << "\nFill rate: " << RESET;
+    if (f.fillRate > 0) {
+        cout << "+" << formatSize((unsigned long long)(f.fillRate * 3600)) << "/h, full in "
+             << Utils::formatDuration(f.secondsToFull);
+    } else {
+        cout << "not filling";
+    }
+    if (!f.reliable) cout << " (less than 5 minutes of history)";
+    cout << "\n";
+}
+
+void DiskMonitor::watchPath(const string& path, double durationSeconds) {
+    LiveIndex index(path);
+    auto start = chrono::steady_clock::now();
+    if (!Utils::isDirectory(path) || !index.build()) {
+        cerr << "\n⚠️  Warning: Cannot watch " << path << " - not a readable directory\n";
+        return;
+    }
+    cout << "Indexed " << index.fileCount() << " files in " << index.directoryCount() << " directories ("
+         << formatSize(index.totalBytes()) << ") in " << fixed << setprecision(2)
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s\n";
+
+    mutex printMutex;
+    FsWatcher watcher;
+    bool started = watcher.start(path, [&](const vector<string>& changed, const vector<string>& rescan) {
+        unsigned long long before = index.totalBytes();
+        index.apply(changed, rescan);
+        unsigned long long after = index.totalBytes();
+
+        time_t now = time(nullptr);
+        char when[16];
+        strftime(when, sizeof(when), "%H:%M:%S", localtime(&now));
+        lock_guard<mutex> lock(printMutex);
+        cout << "[" << when << "] " << changed.size() << " changed";
+        if (!rescan.empty()) cout << ", " << YELLOW << rescan.size() << " rescanned" << RESET;
+        cout << "  →  " << index.fileCount() << " files, " << formatSize(after)
+             << "  (" << (after >= before ? "+" : "-")
+             << formatSize(after >= before ? after - before : before - after) << ")\n" << flush;
+    });
+    if (!started) {
+        cerr << "\n⚠️  Warning: Cannot watch " << path << " - no fanotify or inotify available\n";
+        return;
+    }
+
+    cout << "Watching with " << FsWatcher::backendName(watcher.backend());
+    if (watcher.backend() == FsWatcher::Backend::Inotify) cout << " (" << watcher.watchCount() << " directories)";
+    cout << (durationSeconds > 0 ? " for " + Utils::formatDuration(durationSeconds) : string(" (Ctrl+C to stop)")) << "\n";
+    if (watcher.failedWatches() > 0) {
+        cout << YELLOW << "⚠️  " << watcher.failedWatches()
+             << " directories could not be watched - raise fs.inotify.max_user_watches\n" << RESET;
+    }
+
+    interrupted = 0;
+    auto previousHandler = signal(SIGINT, onInterrupt);
+    start = chrono::steady_clock::now();
+    while (!interrupted) {
+        this_thread::sleep_for(chrono::milliseconds(100));
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (durationSeconds > 0 && elapsed >= durationSeconds) break;
+    }
+    watcher.stop();
+    signal(SIGINT, previousHandler);
+
+    cout << BOLD << "\nIndex: " << RESET << index.fileCount() << " files, " << formatSize(index.totalBytes())
+         << " after " << index.updateCount() << " incremental updates";
+    if (watcher.overflowCount() > 0) cout << ", " << watcher.overflowCount() << " overflow rescans";
+    cout << "\n";
+}
+
+void DiskMonitor::showHistory(const string& path, time_t from, time_t to, bool json) {
+    HistoryStore history(historyFile);
+
+    if (path.empty()) {
+        auto mounts = history.mounts();
+        if (json) {
+            cout << "{\n  \"mounts\": [";
+            for (size_t i = 0; i < mounts.size(); i++) {
+                cout << (i ? "," : "") << "\n    {\"path\": \"" << Utils::jsonEscape(mounts[i].path)
+                     << "\", \"first\": " << mounts[i].first << ", \"last\": " << mounts[i].last
+                     << ", \"samples\": " << mounts[i].samples << "}";
+            }
+            cout << "\n  ]\n}\n";
+            return;
+        }
+        if (mounts.empty()) {
+            cout << "No monitoring history yet. Run './spacemate monitor <path>' to record some.\n";
+            return;
+        }
+        cout << BOLD << "Recorded paths:\n" << RESET;
+        for (const auto& m : mounts) {
+            char first[32], last[32];
+            strftime(first, sizeof(first), "%Y-%m-%d %H:%M", localtime(&m.first));
+            strftime(last, sizeof(last), "%Y-%m-%d %H:%M", localtime(&m.last));
+            cout << "  " << CYAN << m.path << RESET << "  " << first << " → " << last
+                 << "  (" << m.samples << " samples)\n";
+        }
+        return;
+    }
+
+    auto points = history.read(path, from, to);
+    if (json) {
+        cout << "{\n  \"path\": \"" << Utils::jsonEscape(path) << "\",\n  \"samples\": [";
+        for (size_t i = 0; i < points.size(); i++) {
+            const HistoryPoint& p = points[i];
+            cout << (i ? "," : "") << "\n    {\"time\": " << p.timestamp << ", \"used\": " << p.used
+                 << ", \"available\": " << p.available << ", \"inodesFree\": " << p.inodesFree << "}";
+        }
+        cout << "\n  ]\n}\n";
+        return;
+    }
+
+    if (points.empty()) {
+        cout << "No samples for " << path << " in that range.\n";
+        return;
+    }
+    cout << BOLD << "Time                  Used            Available       Free inodes\n" << RESET;
+    for (const auto& p : points) {
+        char when[32];
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&p.timestamp));
+        string used = formatSize(p.used), available = formatSize(p.available);
+        cout << when << "   " << used << string(used.size() < 16 ? 16 - used.size() : 1, ' ')
+             << available << string(available.size() < 16 ? 16 - available.size() : 1, ' ')
+             << p.inodesFree << "\n";
+    }
+    cout << "\n" << points.size() << " samples\n";
+}
+
+void DiskMonitor::compactHistory() {
+    HistoryStore history(historyFile);
+    struct stat before, after;
+    bool hadFile = stat(historyFile.c_str(), &before) == 0;
+    if (!history.compact()) {
+        cerr << "\n⚠️  Warning: Could not compact " << historyFile << "\n";
+        return;
+    }
+    if (hadFile && stat(historyFile.c_str(), &after) == 0) {
+        cout << "Compacted " << historyFile << ": " << formatSize(before.st_size)
+             << " → " << formatSize(after.st_size) << "\n";
     }
 }
 
@@ -116,10 +460,10 @@ string DiskMonitor::formatSize(unsigned long long bytes) {
 
 // ================= GUI FUNCTIONS =================
 
-    // Return structured disk info: Total, Used, Free
+    // Return structured disk info: Total, Used, Free, then the inode counts
 vector<pair<string, long long>> DiskMonitor::getDiskInfo(const string& path) {
     vector<pair<string, long long>> info;
-    struct statvfs stat;
+    VolumeStats volume;
     
     // Convert Windows path to WSL path if needed
     string wslPath = path;
@@ -129,24 +473,23 @@ vector<pair<string, long long>> DiskMonitor::getDiskInfo(const string& path) {
         std::replace(wslPath.begin(), wslPath.end(), '\\', '/');
     }
 
-    if (statvfs(wslPath.c_str(), &stat) != 0) {
+    if (!MountTable::instance().stats(wslPath, volume)) {
         cerr << "Failed to get disk info for path: " << wslPath << endl;
         return info;
     }
 
-    unsigned long long total = stat.f_blocks * stat.f_frsize;
-    unsigned long long free  = stat.f_bfree * stat.f_frsize;
-    unsigned long long used  = total - free;    info.push_back({"Total", (long long)total});
-    info.push_back({"Used",  (long long)used});
-    info.push_back({"Free",  (long long)free});
+    info.push_back({"Total", (long long)volume.total});
+    info.push_back({"Used",  (long long)volume.used()});
+    info.push_back({"Free",  (long long)volume.free});
+    info.push_back({"Inodes Total", (long long)volume.inodesTotal});
+    info.push_back({"Inodes Used",  (long long)(volume.inodesTotal - volume.inodesFree)});
+    info.push_back({"Inodes Free",  (long long)volume.inodesFree});
 
     return info;
 }
 
-// Optionally: Return top N largest directories for GUI
+// Return top N largest directories (real subtree sizes) for GUI
 vector<pair<string, long long>> DiskMonitor::getLargestDirectories(const string& path, int limit) {
-    map<string, unsigned long long> dirSizes;
-    
     // Convert Windows path to WSL path if needed
     string wslPath = path;
     if (path.length() >= 2 && path[1] == ':') {
@@ -155,57 +498,323 @@ vector<pair<string, long long>> DiskMonitor::getLargestDirectories(const string&
         std::replace(wslPath.begin(), wslPath.end(), '\\', '/');
     }
     
-    DIR* dir = opendir(wslPath.c_str());
-    if (!dir) {
-        cerr << "Failed to open directory: " << wslPath << endl;
-        return {};
+    auto tree = DirTree::build(wslPath);
+    vector<pair<string, long long>> sortedDirs;
+    for (NodeId id : tree->largestChildren(tree->root(), limit)) {
+        sortedDirs.push_back({tree->name(id), (long long)tree->node(id).bytes});
     }
-    
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        if (entry->d_name[0] == '.') continue;
-        string fullPath = path + "/" + entry->d_name;
-        struct stat st;
-        if (stat(fullPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
-            dirSizes[entry->d_name] = st.st_size * 1000;
-        }
-    }
-    closedir(dir);
-    
-    vector<pair<string, long long>> sortedDirs(dirSizes.begin(), dirSizes.end());
-    sort(sortedDirs.begin(), sortedDirs.end(),
-         [](const auto& a, const auto& b) { return a.second > b.second; });
-    
-    if (sortedDirs.size() > (size_t)limit)
-        sortedDirs.resize(limit);
-    
     return sortedDirs;
 }
 
+// ================= MONITORING SERVICE =================
+DiskMonitor::~DiskMonitor() {
+    // stopMonitoring() would leave the thread joinable, and destroying a
+    // joinable std::thread calls std::terminate
+    assert(monitorThread.get_id() != this_thread::get_id() && "DiskMonitor destroyed from its own callback");
+    stopMonitoring();
+    stopFolderStats();
+}
+
+bool DiskMonitor::takeSample(const string& path, DiskSample& sample) {
+    struct statvfs stat;
+    if (statvfs(path.c_str(), &stat) != 0) return false;
+
+    sample.path = path;
+    sample.timestamp = time(nullptr);
+    sample.total = (unsigned long long)stat.f_blocks * stat.f_frsize;
+    sample.free = (unsigned long long)stat.f_bfree * stat.f_frsize;
+    sample.available = (unsigned long long)stat.f_bavail * stat.f_frsize;
+    sample.inodesTotal = stat.f_files;
+    sample.inodesFree = stat.f_ffree;
+    return true;
+}
+
+DiskMonitor::SubscriptionId DiskMonitor::subscribe(SampleCallback callback) {
+    lock_guard<mutex> lock(monitorMutex);
+    SubscriptionId id = nextSubscription++;
+    subscribers[id] = move(callback);
+    return id;
+}
+
+void DiskMonitor::unsubscribe(SubscriptionId id) {
+    lock_guard<recursive_mutex> publishing(publishMutex);
+    lock_guard<mutex> lock(monitorMutex);
+    subscribers.erase(id);
+    growthSubscribers.erase(id);
+    folderStatsSubscribers.erase(id);
+}
+
+DiskMonitor::SubscriptionId DiskMonitor::subscribeFolderStats(FolderStatsCallback callback) {
+    lock_guard<mutex> lock(monitorMutex);
+    SubscriptionId id = nextSubscription++;
+    folderStatsSubscribers[id] = move(callback);
+    return id;
+}
+
+DiskMonitor::SubscriptionId DiskMonitor::subscribeGrowth(GrowthCallback callback) {
+    lock_guard<mutex> lock(monitorMutex);
+    SubscriptionId id = nextSubscription++;
+    growthSubscribers[id] = move(callback);
+    return id;
+}
+
+void DiskMonitor::setGrowthTracking(chrono::seconds newInterval) {
+    lock_guard<mutex> lock(monitorMutex);
+    growthInterval = newInterval;
+    if (growthInterval.count() <= 0) growthStates.clear();
+}
+
+void DiskMonitor::setInterval(chrono::milliseconds newInterval) {
+    {
+        lock_guard<mutex> lock(monitorMutex);
+        interval = max(newInterval, chrono::milliseconds(100));
+    }
+    wakeup.notify_all();
+}
+
+void DiskMonitor::setChangeThreshold(unsigned long long bytes) {
+    lock_guard<mutex> lock(monitorMutex);
+    changeThreshold = bytes;
+}
+
+bool DiskMonitor::lastSample(const string& path, DiskSample& sample) const {
+    lock_guard<mutex> lock(monitorMutex);
+    auto it = lastSamples.find(path);
+    if (it == lastSamples.end()) return false;
+    sample = it->second;
+    return true;
+}
+
+Forecast DiskMonitor::forecast(const string& path) const {
+    lock_guard<mutex> lock(monitorMutex);
+    auto it = histories.find(path);
+    return it != histories.end() ? it->second.forecast() : Forecast();
+}
+
+double DiskMonitor::fillRate(const string& path, time_t window) const {
+    lock_guard<mutex> lock(monitorMutex);
+    auto it = histories.find(path);
+    return it != histories.end() ? it->second.fillRate(window) : 0.0;
+}
+
+double DiskMonitor::growth(const string& path, time_t window) const {
+    lock_guard<mutex> lock(monitorMutex);
+    auto it = histories.find(path);
+    return it != histories.end() ? it->second.growth(window) : 0.0;
+}
+
+vector<DirGrowth> DiskMonitor::topGrowers(const string& path, size_t limit, bool byFiles) const {
+    lock_guard<mutex> lock(monitorMutex);
+    auto it = growthStates.find(path);
+    if (it == growthStates.end() || !it->second.previous) return {};
+    return DirSnapshot::topGrowers(*it->second.previous, *it->second.current, limit, byFiles);
+}
+
+vector<HistoryPoint> DiskMonitor::history(const string& path, UsageHistory::Resolution resolution) const {
+    lock_guard<mutex> lock(monitorMutex);
+    vector<HistoryPoint> points;
+    auto it = histories.find(path);
+    if (it == histories.end()) return points;
+
+    const RingBuffer<HistoryPoint>& series = it->second.series(resolution);
+    points.reserve(series.size());
+    for (size_t i = 0; i < series.size(); i++) points.push_back(series[i]);
+    return points;
+}
+
+bool DiskMonitor::hasChanged(const DiskSample& previous, const DiskSample& current) const {
+    if (previous.total != current.total || previous.inodesTotal != current.inodesTotal) return true;
+    unsigned long long delta = previous.available > current.available
+        ? previous.available - current.available
+        : current.available - previous.available;
+    if (changeThreshold > 0) {
+        if (delta >= changeThreshold) return true;
+        // Millions of tiny files barely move the byte count; scale the
+        // threshold to the inode table so they still register
+        unsigned long long inodeDelta = previous.inodesFree > current.inodesFree
+            ? previous.inodesFree - current.inodesFree
+            : current.inodesFree - previous.inodesFree;
+        return current.total > 0 && current.inodesTotal > 0 && inodeDelta > 0 &&
+               (double)inodeDelta / current.inodesTotal >= (double)changeThreshold / current.total;
+    }
+    return delta != 0 || previous.free != current.free || previous.inodesFree != current.inodesFree;
+}
+
+void DiskMonitor::publish(const DiskSample& sample) {
+    // Callbacks run without monitorMutex so they may (un)subscribe themselves
+    lock_guard<recursive_mutex> publishing(publishMutex);
+    vector<SampleCallback> callbacks;
+    {
+        lock_guard<mutex> lock(monitorMutex);
+        for (const auto& entry : subscribers) callbacks.push_back(entry.second);
+    }
+    for (const auto& callback : callbacks) callback(sample);
+}
+
 void DiskMonitor::monitorLoop() {
+    unique_lock<mutex> lock(monitorMutex);
     while (monitoring) {
-        // You can update GUI via signals or polling
-        auto info = getDiskInfo(monitoredPath);
-        auto dirs = getLargestDirectories(monitoredPath, 5);
+        vector<string> paths = monitoredPaths;
+        lock.unlock();
 
-        // Sleep for a while (e.g., update every 5 seconds)
-        std::this_thread::sleep_for(std::chrono::seconds(5));
+        vector<DiskSample> changed, all;
+        for (const auto& path : paths) {
+            DiskSample sample;
+            if (!takeSample(path, sample)) continue;
+
+            lock_guard<mutex> guard(monitorMutex);
+            UsageHistory& history = histories[path];
+            HistoryPoint point{sample.timestamp, sample.total - sample.available, sample.available, sample.inodesFree};
+            history.add(point);
+            if (store) store->append(path, point);
+            Forecast f = history.forecast();
+            sample.fillRate = f.fillRate;
+            sample.secondsToFull = f.reliable ? f.secondsToFull : -1;
+            all.push_back(sample);
+
+            auto it = lastSamples.find(path);
+            if (it == lastSamples.end() || hasChanged(it->second, sample)) {
+                lastSamples[path] = sample;
+                changed.push_back(sample);
+            }
+        }
+        for (const auto& sample : changed) publish(sample);
+        for (const auto& sample : all) {
+            alerts.evaluate(sample, [this](const string& p, time_t window) { return growth(p, window); });
+        }
+        trackGrowth(paths);
+
+        lock.lock();
+        wakeup.wait_for(lock, interval, [&] { return !monitoring || monitoredPaths.size() != paths.size(); });
     }
 }
 
+// Runs on the monitor thread without monitorMutex held; the walk itself
+// only reads the previous snapshot, which nothing else modifies
+void DiskMonitor::trackGrowth(const vector<string>& paths) {
+    for (const auto& path : paths) {
+        shared_ptr<DirSnapshot> previous;
+        {
+            lock_guard<mutex> lock(monitorMutex);
+            if (growthInterval.count() <= 0 || !monitoring) return;
+            GrowthState& state = growthStates[path];
+            if (state.current && chrono::steady_clock::now() < state.due) continue;
+            previous = state.current;
+        }
+
+        auto snapshot = DirSnapshot::take(path, previous.get());
+
+        vector<GrowthCallback> callbacks;
+        vector<DirGrowth> byBytes, byFiles;
+        {
+            lock_guard<mutex> lock(monitorMutex);
+            GrowthState& state = growthStates[path];
+            state.previous = previous;
+            state.current = snapshot;
+            state.due = chrono::steady_clock::now() + growthInterval;
+            if (!previous) continue;   // nothing to compare against yet
+
+            byBytes = DirSnapshot::topGrowers(*previous, *snapshot, 5);
+            byFiles = DirSnapshot::topGrowers(*previous, *snapshot, 5, true);
+            if (byBytes.empty() && byFiles.empty()) continue;
+            for (const auto& entry : growthSubscribers) callbacks.push_back(entry.second);
+        }
+
+        lock_guard<recursive_mutex> publishing(publishMutex);
+        for (const auto& callback : callbacks) callback(path, byBytes, byFiles);
+    }
+}
+
+// ================= FOLDER STATISTICS =================
+void DiskMonitor::startFolderStats(const string& path) {
+    stopFolderStats();
+    if (!hashCacheLoaded) {
+        hashCache.load();
+        hashCacheLoaded = true;
+    }
+
+    folderJob.reset(new FolderStatsJob(path, hashCache, [this](const FolderStats& stats) {
+        vector<FolderStatsCallback> callbacks;
+        {
+            lock_guard<mutex> lock(monitorMutex);
+            folderStats = stats;
+            haveFolderStats = true;
+            for (const auto& entry : folderStatsSubscribers) callbacks.push_back(entry.second);
+        }
+        lock_guard<recursive_mutex> publishing(publishMutex);
+        for (const auto& callback : callbacks) callback(stats);
+    }));
+    folderJob->start();
+}
+
+void DiskMonitor::stopFolderStats() {
+    if (!folderJob) return;
+    folderJob->stop();
+    folderJob.reset();
+    hashCache.save();
+
+    lock_guard<mutex> lock(monitorMutex);
+    haveFolderStats = false;
+}
+
+bool DiskMonitor::lastFolderStats(FolderStats& stats) const {
+    lock_guard<mutex> lock(monitorMutex);
+    if (!haveFolderStats) return false;
+    stats = folderStats;
+    return true;
+}
+
+void DiskMonitor::setPersistence(bool enabled, const string& file) {
+    lock_guard<mutex> lock(monitorMutex);
+    persist = enabled;
+    historyFile = file;
+    store.reset();
+}
+
+void DiskMonitor::addPath(const string& path) {
+    {
+        lock_guard<mutex> lock(monitorMutex);
+        if (find(monitoredPaths.begin(), monitoredPaths.end(), path) != monitoredPaths.end()) return;
+        monitoredPaths.push_back(path);
+
+        if (persist && !store) store.reset(new HistoryStore(historyFile));
+        if (store && histories.find(path) == histories.end()) {
+            time_t now = time(nullptr);
+            UsageHistory& history = histories[path];
+            for (const auto& point : store->read(path, now - 90 * 86400, now)) history.add(point);
+        }
+    }
+    wakeup.notify_all();   // sample the new path right away
+}
+
 void DiskMonitor::startMonitoring(const std::string& path) {
-    if (monitoring) return;  // already running
+    // A service a subscriber stopped from its callback is joined first
+    bool onMonitorThread = monitorThread.get_id() == this_thread::get_id();
+    if (!monitoring && monitorThread.joinable() && !onMonitorThread) stopMonitoring();
+
+    addPath(path);
+    if (monitoring.exchange(true)) return;  // already running
+    if (monitorThread.joinable()) return;   // restarted from a callback: the loop carries on
 
-    monitoredPath = path;
-    monitoring = true;
     monitorThread = std::thread(&DiskMonitor::monitorLoop, this);
-    monitorThread.detach(); // or join in destructor if you prefer
 }
 
 void DiskMonitor::stopMonitoring() {
-    if (!monitoring) return;
+    {
+        lock_guard<mutex> lock(monitorMutex);
+        monitoring = false;
+    }
+    wakeup.notify_all();
+    // From inside a subscriber callback this only signals; the loop ends
+    // once the callback returns and the next start, stop or the
+    // destructor joins the thread
+    if (!monitorThread.joinable() || monitorThread.get_id() == this_thread::get_id()) return;
+    monitorThread.join();
 
-    monitoring = false;
-    // If detached thread, it will exit naturally after the next sleep
-    // Otherwise, you can join here if needed
+    // Histories are kept so a restarted service continues its forecast
+    lock_guard<mutex> lock(monitorMutex);
+    monitoredPaths.clear();
+    lastSamples.clear();
+    growthStates.clear();
+    if (store) store->flush();
 }
\ No newline at end of file
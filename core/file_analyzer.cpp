@@ -7,6 +7,8 @@
 #include <fstream>
 #include <algorithm>
 #include <set>
+#include <thread>
+#include <iomanip>
 
 #define RESET   "\033[0m"
 #define YELLOW  "\033[33m"
@@ -85,6 +87,10 @@ void FileAnalyzer::analyzePath(const string& path, bool verbose) {
         cout << YELLOW << "Space used: " << Utils::formatSize(oldSize) << RESET << "\n";
     }
     
+    // Space by file type (reuses the file list from the initial scan)
+    cout << "\n";
+    printTypeBreakdown(aggregateTypes(allFiles), path, false);
+    
     // Summary
     unsigned long long totalSavings = duplicateWaste + tempSize;
     if (totalSavings > 0) {
@@ -123,6 +129,13 @@ vector<FileInfo> FileAnalyzer::scanDirectory(const string& path) {
                 string filename = entry->d_name;
                 size_t dotPos = filename.find_last_of(".");
                 info.extension = (dotPos != string::npos) ? filename.substr(dotPos) : "";
+                info.typeId = ExtensionTable::instance().intern(info.extension);
+                info.uid = st.st_uid;
+                info.gid = st.st_gid;
+                info.allocated = (unsigned long long)st.st_blocks * 512;
+                info.device = st.st_dev;
+                info.inode = st.st_ino;
+                info.links = st.st_nlink;
                 
                 files.push_back(info);
             }
@@ -162,10 +175,8 @@ vector<FileInfo> FileAnalyzer::findTempFiles(const string& path) {
     vector<FileInfo> allFiles = scanDirectory(path);
     vector<FileInfo> tempFiles;
     
-    set<string> tempExtensions = {".tmp", ".temp", ".log", ".cache", ".bak", "~"};
-    
     for (const auto& file : allFiles) {
-        if (tempExtensions.count(file.extension) > 0) {
+        if (ExtensionTable::isTemporary(file.extension)) {
             tempFiles.push_back(file);
         }
     }
@@ -195,15 +206,108 @@ string FileAnalyzer::calculateHash(const string& filepath) {
 }
 
 bool FileAnalyzer::isTempFile(const string& filename) {
-    set<string> tempExtensions = {".tmp", ".temp", ".log", ".cache"};
     size_t dotPos = filename.find_last_of(".");
     if (dotPos != string::npos) {
-        string ext = filename.substr(dotPos);
-        return tempExtensions.count(ext) > 0;
+        return ExtensionTable::isTemporary(filename.substr(dotPos));
     }
     return false;
 }
 
+// ===== File type breakdown =====
+TypeBreakdown FileAnalyzer::aggregateTypes(const vector<FileInfo>& files) {
+    // Split the file list across worker threads; each one fills its own
+    // TypeAggregator so the hot loop never takes a lock.
+    size_t workers = max(1u, thread::hardware_concurrency());
+    const size_t minChunk = 50000;
+    workers = min(workers, files.size() / minChunk + 1);
+
+    vector<TypeAggregator> partial(workers);
+    vector<thread> threads;
+    size_t chunk = (files.size() + workers - 1) / workers;
+
+    for (size_t w = 0; w < workers; w++) {
+        size_t begin = w * chunk;
+        size_t end = min(files.size(), begin + chunk);
+        auto work = [&files, &partial, w, begin, end]() {
+            for (size_t i = begin; i < end; i++) {
+                partial[w].add(files[i].typeId, files[i].size);
+            }
+        };
+        if (w + 1 == workers) work();
+        else threads.emplace_back(work);
+    }
+    for (auto& t : threads) t.join();
+
+    for (size_t w = 1; w < workers; w++) partial[0].merge(partial[w]);
+    return partial[0].finish();
+}
+
+TypeBreakdown FileAnalyzer::getTypeBreakdown(const string& path) {
+    return aggregateTypes(scanDirectory(path));
+}
+
+void FileAnalyzer::showTypeBreakdown(const string& path, bool json) {
+    printTypeBreakdown(getTypeBreakdown(path), path, json);
+}
+
+void FileAnalyzer::printTypeBreakdown(const TypeBreakdown& breakdown, const string& path, bool json) {
+    if (json) {
+        cout << "{\n  \"path\": \"" << Utils::jsonEscape(path) << "\",\n";
+        cout << "  \"totalBytes\": " << breakdown.totalBytes << ",\n";
+        cout << "  \"totalFiles\": " << breakdown.totalFiles << ",\n";
+        cout << "  \"categories\": [\n";
+        for (size_t i = 0; i < breakdown.categories.size(); i++) {
+            const auto& c = breakdown.categories[i];
+            cout << "    {\"category\": \"" << categoryName(c.category) << "\", \"bytes\": "
+                 << c.bytes << ", \"files\": " << c.count << "}"
+                 << (i + 1 < breakdown.categories.size() ? "," : "") << "\n";
+        }
+        cout << "  ],\n  \"extensions\": [\n";
+        for (size_t i = 0; i < breakdown.extensions.size(); i++) {
+            const auto& e = breakdown.extensions[i];
+            cout << "    {\"extension\": \"" << Utils::jsonEscape(e.extension) << "\", \"category\": \""
+                 << categoryName(e.category) << "\", \"bytes\": " << e.bytes
+                 << ", \"files\": " << e.count << "}"
+                 << (i + 1 < breakdown.extensions.size() ? "," : "") << "\n";
+        }
+        cout << "  ]\n}\n";
+        return;
+    }
+
+    cout << BOLD << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    cout << "📁 SPACE BY FILE TYPE\n";
+    cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n" << RESET;
+
+    if (breakdown.totalFiles == 0) {
+        cout << "No files found\n";
+        return;
+    }
+
+    auto share = [&breakdown](unsigned long long bytes) {
+        return breakdown.totalBytes ? bytes * 100.0 / breakdown.totalBytes : 0.0;
+    };
+
+    cout << "\nBy category:\n";
+    for (const auto& c : breakdown.categories) {
+        cout << "  " << CYAN << left << setw(18) << categoryName(c.category) << RESET
+             << right << setw(12) << Utils::formatSize(c.bytes)
+             << setw(10) << c.count << " files"
+             << setw(8) << fixed << setprecision(1) << share(c.bytes) << "%\n";
+    }
+
+    cout << "\nTop extensions:\n";
+    size_t shown = 0;
+    for (const auto& e : breakdown.extensions) {
+        if (shown++ >= 15) break;
+        string label = e.extension.empty() ? "(none)" : e.extension;
+        cout << "  " << CYAN << left << setw(18) << label << RESET
+             << right << setw(12) << Utils::formatSize(e.bytes)
+             << setw(10) << e.count << " files"
+             << setw(8) << fixed << setprecision(1) << share(e.bytes) << "%\n";
+    }
+    cout << left;
+}
+
 // ===== GUI Methods =====
 // Add these **after all CLI methods** in this file
 
@@ -233,3 +337,95 @@ unsigned long long FileAnalyzer::getPotentialSavings(const std::string& path) {
 
     return duplicateWaste + tempSize;
 }
+
+// ===== Owner accounting =====
+OwnerReport FileAnalyzer::getOwnerReport(const string& path) {
+    OwnerAccounting accounting;
+    for (const auto& file : scanDirectory(path)) {
+        accounting.add(file.uid, file.gid, file.size, file.allocated, file.device, file.inode, file.links);
+    }
+
+    OwnerReport report = accounting.finish(path);
+    UsageIndex().store(report);
+    return report;
+}
+
+void FileAnalyzer::showOwnerReport(const string& path, bool cached, bool json) {
+    OwnerReport report;
+    if (cached) {
+        if (!UsageIndex().load(path, report)) {
+            cout << YELLOW << "No indexed owner report for " << path
+                 << " - run without --cached to scan it\n" << RESET;
+            return;
+        }
+    } else {
+        report = getOwnerReport(path);
+    }
+    printOwnerReport(report, json);
+}
+
+void FileAnalyzer::printOwnerReport(const OwnerReport& report, bool json) {
+    if (json) {
+        auto printList = [](const vector<OwnerUsage>& list, const char* key) {
+            cout << "  \"" << key << "\": [\n";
+            for (size_t i = 0; i < list.size(); i++) {
+                const auto& o = list[i];
+                cout << "    {\"id\": " << o.id << ", \"name\": \"" << Utils::jsonEscape(o.name)
+                     << "\", \"apparentBytes\": " << o.apparentBytes
+                     << ", \"allocatedBytes\": " << o.allocatedBytes
+                     << ", \"files\": " << o.files << "}"
+                     << (i + 1 < list.size() ? "," : "") << "\n";
+            }
+            cout << "  ]";
+        };
+        cout << "{\n  \"path\": \"" << Utils::jsonEscape(report.root) << "\",\n";
+        cout << "  \"generated\": " << report.generated << ",\n";
+        printList(report.users, "users");
+        cout << ",\n";
+        printList(report.groups, "groups");
+        cout << "\n}\n";
+        return;
+    }
+
+    char when[64];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&report.generated));
+
+    cout << BOLD << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    cout << "👤 SPACE BY OWNER\n";
+    cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n" << RESET;
+    cout << "Report time: " << when << "\n";
+
+    auto printTable = [](const vector<OwnerUsage>& list, const char* title) {
+        cout << "\n" << title << ":\n";
+        cout << "  " << left << setw(20) << "Name" << right << setw(14) << "Apparent"
+             << setw(14) << "Allocated" << setw(12) << "Files" << "\n";
+        for (const auto& o : list) {
+            cout << "  " << CYAN << left << setw(20) << o.name << RESET
+                 << right << setw(14) << Utils::formatSize(o.apparentBytes)
+                 << setw(14) << Utils::formatSize(o.allocatedBytes)
+                 << setw(12) << o.files << "\n";
+        }
+        cout << left;
+    };
+    printTable(report.users, "Users");
+    printTable(report.groups, "Groups");
+}
+
+void FileAnalyzer::showOwnerQuery(const string& name, bool isGroup) {
+    auto matches = UsageIndex().query(name, isGroup);
+    if (matches.empty()) {
+        cout << "No indexed usage for " << (isGroup ? "group " : "user ") << name << "\n";
+        return;
+    }
+
+    cout << BOLD << "Indexed usage for " << (isGroup ? "group " : "user ") << name << ":\n" << RESET;
+    unsigned long long total = 0;
+    for (const auto& match : matches) {
+        cout << "  " << CYAN << match.first << RESET << "\n";
+        cout << "    Apparent: " << Utils::formatSize(match.second.apparentBytes)
+             << "  Allocated: " << Utils::formatSize(match.second.allocatedBytes)
+             << "  Files: " << match.second.files << "\n";
+        total += match.second.allocatedBytes;
+    }
+    cout << YELLOW << "Total allocated: " << Utils::formatSize(total) << RESET << "\n";
+}
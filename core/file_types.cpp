@@ -0,0 +1,165 @@
+#include "../include/file_types.h"
+#include <algorithm>
+#include <cctype>
+#include <map>
+
+using namespace std;
+
+const char* categoryName(FileCategory category) {
+    switch (category) {
+        case FileCategory::Media:     return "Media";
+        case FileCategory::Archive:   return "Archives";
+        case FileCategory::Build:     return "Build artefacts";
+        case FileCategory::Log:       return "Logs";
+        case FileCategory::Temporary: return "Temporary";
+        case FileCategory::Document:  return "Documents";
+        default:                      return "Other";
+    }
+}
+
+// ===== Well-known extensions =====
+namespace {
+
+const pair<const char*, FileCategory> knownExtensions[] = {
+    // Media
+    {".jpg", FileCategory::Media}, {".jpeg", FileCategory::Media}, {".png", FileCategory::Media},
+    {".gif", FileCategory::Media}, {".bmp", FileCategory::Media}, {".webp", FileCategory::Media},
+    {".heic", FileCategory::Media}, {".raw", FileCategory::Media}, {".svg", FileCategory::Media},
+    {".mp3", FileCategory::Media}, {".flac", FileCategory::Media}, {".wav", FileCategory::Media},
+    {".ogg", FileCategory::Media}, {".aac", FileCategory::Media}, {".m4a", FileCategory::Media},
+    {".mp4", FileCategory::Media}, {".mkv", FileCategory::Media}, {".avi", FileCategory::Media},
+    {".mov", FileCategory::Media}, {".webm", FileCategory::Media}, {".wmv", FileCategory::Media},
+    // Archives
+    {".zip", FileCategory::Archive}, {".tar", FileCategory::Archive}, {".gz", FileCategory::Archive},
+    {".tgz", FileCategory::Archive}, {".bz2", FileCategory::Archive}, {".xz", FileCategory::Archive},
+    {".zst", FileCategory::Archive}, {".7z", FileCategory::Archive}, {".rar", FileCategory::Archive},
+    {".iso", FileCategory::Archive}, {".deb", FileCategory::Archive}, {".rpm", FileCategory::Archive},
+    {".jar", FileCategory::Archive}, {".whl", FileCategory::Archive},
+    // Build artefacts
+    {".o", FileCategory::Build}, {".obj", FileCategory::Build}, {".a", FileCategory::Build},
+    {".so", FileCategory::Build}, {".dll", FileCategory::Build}, {".exe", FileCategory::Build},
+    {".lib", FileCategory::Build}, {".pch", FileCategory::Build}, {".gch", FileCategory::Build},
+    {".class", FileCategory::Build}, {".pyc", FileCategory::Build}, {".d", FileCategory::Build},
+    {".pdb", FileCategory::Build}, {".rlib", FileCategory::Build}, {".wasm", FileCategory::Build},
+    // Logs
+    {".log", FileCategory::Log}, {".out", FileCategory::Log}, {".trace", FileCategory::Log},
+    // Temporary
+    {".tmp", FileCategory::Temporary}, {".temp", FileCategory::Temporary},
+    {".cache", FileCategory::Temporary}, {".bak", FileCategory::Temporary},
+    {".swp", FileCategory::Temporary}, {".part", FileCategory::Temporary},
+    // Documents
+    {".pdf", FileCategory::Document}, {".doc", FileCategory::Document}, {".docx", FileCategory::Document},
+    {".xls", FileCategory::Document}, {".xlsx", FileCategory::Document}, {".ppt", FileCategory::Document},
+    {".pptx", FileCategory::Document}, {".odt", FileCategory::Document}, {".txt", FileCategory::Document},
+    {".md", FileCategory::Document}, {".csv", FileCategory::Document}, {".epub", FileCategory::Document},
+};
+
+// Extensions that cleanup treats as disposable, case-sensitive like the
+// old findTempFiles set
+const char* temporaryExtensions[] = {".tmp", ".temp", ".log", ".cache", ".bak", "~"};
+
+string lowerCase(const string& s) {
+    string out = s;
+    transform(out.begin(), out.end(), out.begin(),
+              [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return out;
+}
+
+}  // namespace
+
+// ===== ExtensionTable =====
+ExtensionTable& ExtensionTable::instance() {
+    static ExtensionTable table;
+    return table;
+}
+
+ExtensionTable::ExtensionTable() {
+    // ID 0 is reserved for files without an extension
+    ids[""] = 0;
+    names.push_back("");
+    categories.push_back(FileCategory::Other);
+
+    for (const auto& known : knownExtensions) {
+        TypeId id = static_cast<TypeId>(names.size());
+        ids[known.first] = id;
+        names.push_back(known.first);
+        categories.push_back(known.second);
+    }
+}
+
+TypeId ExtensionTable::intern(const string& extension) {
+    string key = lowerCase(extension);
+
+    lock_guard<mutex> lock(tableMutex);
+    auto it = ids.find(key);
+    if (it != ids.end()) return it->second;
+
+    TypeId id = static_cast<TypeId>(names.size());
+    ids.emplace(key, id);
+    names.push_back(key);
+    categories.push_back(FileCategory::Other);
+    return id;
+}
+
+string ExtensionTable::name(TypeId id) const {
+    lock_guard<mutex> lock(tableMutex);
+    return id < names.size() ? names[id] : "";
+}
+
+FileCategory ExtensionTable::category(TypeId id) const {
+    lock_guard<mutex> lock(tableMutex);
+    return id < categories.size() ? categories[id] : FileCategory::Other;
+}
+
+bool ExtensionTable::isTemporary(const string& extension) {
+    for (const char* ext : temporaryExtensions) {
+        if (extension == ext) return true;
+    }
+    return false;
+}
+
+// ===== TypeAggregator =====
+void TypeAggregator::add(TypeId id, unsigned long long bytes) {
+    Totals& t = totals[id];
+    t.bytes += bytes;
+    t.count++;
+}
+
+void TypeAggregator::merge(const TypeAggregator& other) {
+    for (const auto& item : other.totals) {
+        Totals& t = totals[item.first];
+        t.bytes += item.second.bytes;
+        t.count += item.second.count;
+    }
+}
+
+TypeBreakdown TypeAggregator::finish() const {
+    ExtensionTable& table = ExtensionTable::instance();
+    TypeBreakdown result;
+    map<FileCategory, CategoryStat> byCategory;
+
+    for (const auto& item : totals) {
+        TypeStat stat;
+        stat.id = item.first;
+        stat.extension = table.name(item.first);
+        stat.category = table.category(item.first);
+        stat.bytes = item.second.bytes;
+        stat.count = item.second.count;
+        result.extensions.push_back(stat);
+
+        CategoryStat& cat = byCategory.emplace(stat.category, CategoryStat{stat.category, 0, 0}).first->second;
+        cat.bytes += stat.bytes;
+        cat.count += stat.count;
+
+        result.totalBytes += stat.bytes;
+        result.totalFiles += stat.count;
+    }
+
+    for (const auto& item : byCategory) result.categories.push_back(item.second);
+
+    sort(result.extensions.begin(), result.extensions.end(),
+         [](const TypeStat& a, const TypeStat& b) { return a.bytes > b.bytes; });
+    sort(result.categories.begin(), result.categories.end(),
+         [](const CategoryStat& a, const CategoryStat& b) { return a.bytes > b.bytes; });
+    return result;
+}
@@ -0,0 +1,135 @@
+#include "../include/folder_stats.h"
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+constexpr chrono::seconds FolderStatsJob::MIN_INTERVAL;
+
+FolderStatsJob::FolderStatsJob(const string& path, HashCache& cache, Callback callback)
+    : index(path), hashes(cache), onStats(move(callback)) {}
+
+FolderStatsJob::~FolderStatsJob() {
+    stop();
+}
+
+// ===== Lifecycle =====
+void FolderStatsJob::start() {
+    if (worker.joinable()) return;
+    {
+        lock_guard<mutex> lock(jobMutex);
+        stopping = false;
+        dirty = true;
+    }
+    worker = thread(&FolderStatsJob::run, this);
+}
+
+void FolderStatsJob::stop() {
+    {
+        lock_guard<mutex> lock(jobMutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    if (worker.joinable()) worker.join();
+    watcher.stop();
+}
+
+void FolderStatsJob::refresh() {
+    {
+        lock_guard<mutex> lock(jobMutex);
+        dirty = true;
+    }
+    wakeup.notify_all();
+}
+
+void FolderStatsJob::run() {
+    if (!index.build(&stopping)) {
+        if (stopping) return;
+        FolderStats failed;
+        failed.path = index.rootPath();
+        failed.error = "not a readable directory";
+        failed.computedAt = time(nullptr);
+        if (onStats) onStats(failed);
+        return;
+    }
+    {
+        lock_guard<mutex> lock(jobMutex);
+        if (stopping) return;
+    }
+    watcher.start(index.rootPath(), [this](const vector<string>& changed, const vector<string>& rescan) {
+        index.apply(changed, rescan);
+        refresh();
+    }, chrono::milliseconds(1000));
+
+    unique_lock<mutex> lock(jobMutex);
+    while (true) {
+        wakeup.wait(lock, [this] { return stopping || dirty; });
+        if (stopping) break;
+        dirty = false;
+        lock.unlock();
+
+        FolderStats stats;
+        bool complete = compute(stats);
+        if (complete && onStats) onStats(stats);
+
+        lock.lock();
+        // Rate limit: a busy folder changes constantly
+        wakeup.wait_for(lock, MIN_INTERVAL, [this] { return stopping.load(); });
+    }
+}
+
+// ===== Statistics =====
+bool FolderStatsJob::isTempPath(const string& path) {
+    string lower = path;
+    transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return tolower(c); });
+    auto endsWith = [&path](const string& suffix) {
+        return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return path.find("/tmp/") != string::npos || lower.find("\\temp\\") != string::npos ||
+           endsWith(".tmp") || endsWith(".cache");
+}
+
+bool FolderStatsJob::compute(FolderStats& stats) {
+    auto start = chrono::steady_clock::now();
+    time_t oldCutoff = time(nullptr) - OLD_FILE_DAYS * 86400;
+
+    stats.path = index.rootPath();
+    stats.folders = index.directoryCount();
+    stats.backend = FsWatcher::backendName(watcher.backend());
+
+    // Copy what is needed out of the index so hashing runs without its lock
+    unordered_map<unsigned long long, vector<pair<string, time_t>>> bySize;
+    index.forEachFile([&](const string& path, const IndexedFile& file) {
+        stats.files++;
+        stats.bytes += file.size;
+        if (file.mtime < oldCutoff) stats.oldFiles++;
+        if (isTempPath(path)) stats.tempFiles++;
+        if (file.size > 1024) bySize[file.size].push_back({path, file.mtime});
+    });
+
+    // Only files sharing a size can be duplicates
+    size_t missesBefore = hashes.misses();
+    for (const auto& group : bySize) {
+        if (group.second.size() < 2) continue;
+        unordered_map<string, size_t> copies;
+        for (const auto& file : group.second) {
+            {
+                lock_guard<mutex> lock(jobMutex);
+                if (stopping) return false;
+            }
+            string digest = hashes.hash(file.first, group.first, file.second);
+            if (!digest.empty()) copies[digest]++;
+        }
+        for (const auto& entry : copies) {
+            if (entry.second < 2) continue;
+            stats.duplicateFiles += entry.second - 1;
+            stats.duplicateBytes += (entry.second - 1) * group.first;
+        }
+    }
+    stats.hashedFiles = hashes.misses() - missesBefore;
+    stats.computedAt = time(nullptr);
+    stats.elapsedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return true;
+}
@@ -0,0 +1,329 @@
+#include "../include/fs_watcher.h"
+#include <sys/inotify.h>
+#include <sys/fanotify.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+    const uint32_t INOTIFY_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO |
+                                  IN_ONLYDIR | IN_DONT_FOLLOW;
+    const size_t MAX_PENDING = 65536;    // beyond this a rescan is cheaper than the paths
+    const size_t HANDLE_CACHE_SIZE = 4096;
+
+    string joinPath(const string& dir, const string& name) {
+        return dir == "/" ? "/" + name : dir + "/" + name;
+    }
+    bool isUnder(const string& path, const string& dir) {
+        if (path.compare(0, dir.size(), dir) != 0) return false;
+        return path.size() == dir.size() || dir == "/" || path[dir.size()] == '/';
+    }
+}
+
+FsWatcher::~FsWatcher() {
+    stop();
+}
+
+string FsWatcher::backendName(Backend backend) {
+    switch (backend) {
+    case Backend::Fanotify: return "fanotify";
+    case Backend::Inotify:  return "inotify";
+    default:                return "none";
+    }
+}
+
+// ===== Setup =====
+bool FsWatcher::start(const string& root, Callback callback, chrono::milliseconds coalesce, bool allowFanotify) {
+    lock_guard<mutex> lock(lifecycleMutex);
+    if (running) return false;
+    rootDir = root;
+    while (rootDir.size() > 1 && rootDir.back() == '/') rootDir.pop_back();
+    onChange = move(callback);
+    coalesceDelay = coalesce;
+    overflows = 0;
+    watchFailures = 0;
+
+    stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stopFd < 0) return false;
+    if (!(allowFanotify && startFanotify()) && !startInotify()) {
+        close(stopFd);
+        stopFd = -1;
+        return false;
+    }
+
+    running = true;
+    watchThread = thread(&FsWatcher::run, this);
+    return true;
+}
+
+bool FsWatcher::startFanotify() {
+#ifdef FAN_REPORT_DFID_NAME
+    int fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME, O_RDONLY | O_LARGEFILE);
+    if (fd < 0) return false;   // EPERM without CAP_SYS_ADMIN, EINVAL before 5.9
+
+    uint64_t mask = FAN_CREATE | FAN_DELETE | FAN_MODIFY | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_ONDIR;
+    if (fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, mask, AT_FDCWD, rootDir.c_str()) != 0) {
+        close(fd);
+        return false;
+    }
+    mountFd = open(rootDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (mountFd < 0) {
+        close(fd);
+        return false;
+    }
+    eventFd = fd;
+    activeBackend = Backend::Fanotify;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool FsWatcher::startInotify() {
+    eventFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (eventFd < 0) return false;
+    addWatches(rootDir);
+    if (watchPaths.empty()) {
+        close(eventFd);
+        eventFd = -1;
+        return false;
+    }
+    activeBackend = Backend::Inotify;
+    return true;
+}
+
+void FsWatcher::stop() {
+    lock_guard<mutex> lock(lifecycleMutex);
+    if (!running.exchange(false)) return;
+    uint64_t one = 1;
+    if (write(stopFd, &one, sizeof(one)) < 0) { /* the thread also checks `running` */ }
+    if (watchThread.joinable()) watchThread.join();
+
+    if (eventFd >= 0) close(eventFd);
+    if (mountFd >= 0) close(mountFd);
+    close(stopFd);
+    eventFd = mountFd = stopFd = -1;
+    watchPaths.clear();
+    watchDescriptors.clear();
+    handleCache.clear();
+    pendingChanged.clear();
+    pendingRescan.clear();
+    watchedDirs = 0;
+    activeBackend = Backend::None;
+}
+
+// ===== inotify watches =====
+void FsWatcher::addWatches(const string& dir) {
+    vector<string> pending{dir};
+    while (!pending.empty()) {
+        string current = move(pending.back());
+        pending.pop_back();
+
+        int wd = inotify_add_watch(eventFd, current.c_str(), INOTIFY_MASK);
+        if (wd < 0) {
+            if (errno == ENOSPC) watchFailures++;   // out of watches: this subtree goes unseen
+            continue;
+        }
+        watchPaths[wd] = current;
+        watchDescriptors[current] = wd;
+
+        DIR* handle = opendir(current.c_str());
+        if (!handle) continue;
+        int fd = dirfd(handle);
+        struct dirent* entry;
+        while ((entry = readdir(handle)) != nullptr) {
+            const char* name = entry->d_name;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+            bool isDir = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN) {
+                struct stat st;
+                isDir = fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+            }
+            if (isDir) pending.push_back(joinPath(current, name));
+        }
+        closedir(handle);
+    }
+    watchedDirs = watchPaths.size();
+}
+
+void FsWatcher::removeWatches(const string& dir) {
+    auto self = watchDescriptors.find(dir);
+    if (self != watchDescriptors.end()) {
+        inotify_rm_watch(eventFd, self->second);
+        watchPaths.erase(self->second);
+        watchDescriptors.erase(self);
+    }
+    string prefix = dir == "/" ? dir : dir + "/";
+    for (auto it = watchDescriptors.lower_bound(prefix);
+         it != watchDescriptors.end() && it->first.compare(0, prefix.size(), prefix) == 0;) {
+        inotify_rm_watch(eventFd, it->second);
+        watchPaths.erase(it->second);
+        it = watchDescriptors.erase(it);
+    }
+    watchedDirs = watchPaths.size();
+}
+
+// ===== Event decoding =====
+void FsWatcher::readInotify() {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    ssize_t length;
+    while ((length = read(eventFd, buffer, sizeof(buffer))) > 0) {
+        for (char* p = buffer; p < buffer + length;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflows++;
+                addWatches(rootDir);   // directories created while events were lost
+                rescan(rootDir);
+                continue;
+            }
+            auto it = watchPaths.find(event->wd);
+            if (it == watchPaths.end()) continue;
+            if (event->mask & IN_IGNORED) {
+                watchDescriptors.erase(it->second);
+                watchPaths.erase(it);
+                continue;
+            }
+
+            string path = event->len ? joinPath(it->second, event->name) : it->second;
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    // Entries may have landed before the new watch existed
+                    addWatches(path);
+                    rescan(path);
+                    continue;
+                }
+                if (event->mask & (IN_DELETE | IN_MOVED_FROM)) removeWatches(path);
+            }
+            changed(path);
+        }
+    }
+    watchedDirs = watchPaths.size();
+}
+
+void FsWatcher::readFanotify() {
+#ifdef FAN_REPORT_DFID_NAME
+    alignas(struct fanotify_event_metadata) char buffer[64 * 1024];
+    ssize_t length;
+    while ((length = read(eventFd, buffer, sizeof(buffer))) > 0) {
+        const struct fanotify_event_metadata* meta = reinterpret_cast<const struct fanotify_event_metadata*>(buffer);
+        for (; FAN_EVENT_OK(meta, length); meta = FAN_EVENT_NEXT(meta, length)) {
+            if (meta->fd >= 0) close(meta->fd);   // not expected with FID reporting
+            if (meta->mask & FAN_Q_OVERFLOW) {
+                overflows++;
+                rescan(rootDir);
+                continue;
+            }
+            if (meta->event_len < sizeof(*meta) + sizeof(struct fanotify_event_info_fid)) continue;
+
+            const struct fanotify_event_info_fid* info =
+                reinterpret_cast<const struct fanotify_event_info_fid*>(meta + 1);
+            if (info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME) continue;
+            struct file_handle* handle = (struct file_handle*)info->handle;
+            const char* name = reinterpret_cast<const char*>(handle->f_handle) + handle->handle_bytes;
+
+            string key(reinterpret_cast<const char*>(handle), sizeof(*handle) + handle->handle_bytes);
+            auto cached = handleCache.find(key);
+            string dir;
+            if (cached != handleCache.end()) {
+                dir = cached->second;
+            } else {
+                int dirFd = open_by_handle_at(mountFd, handle, O_PATH | O_CLOEXEC);
+                if (dirFd < 0) continue;   // the directory is gone; its parent reports that
+                char link[64], target[4096];
+                snprintf(link, sizeof(link), "/proc/self/fd/%d", dirFd);
+                ssize_t n = readlink(link, target, sizeof(target) - 1);
+                close(dirFd);
+                if (n <= 0) continue;
+                dir.assign(target, n);
+                if (handleCache.size() >= HANDLE_CACHE_SIZE) handleCache.clear();
+                handleCache[key] = dir;
+            }
+
+            string path = strcmp(name, ".") == 0 ? dir : joinPath(dir, name);
+            if (!underRoot(path)) continue;
+            if (meta->mask & FAN_ONDIR) {
+                if (meta->mask & (FAN_MOVED_FROM | FAN_MOVED_TO | FAN_DELETE)) handleCache.clear();
+                if (meta->mask & (FAN_CREATE | FAN_MOVED_TO)) {
+                    rescan(path);
+                    continue;
+                }
+            }
+            changed(path);
+        }
+    }
+#endif
+}
+
+// ===== Coalescing =====
+bool FsWatcher::underRoot(const string& path) const {
+    return isUnder(path, rootDir);
+}
+
+void FsWatcher::changed(const string& path) {
+    pendingChanged.insert(path);
+    if (pendingChanged.size() > MAX_PENDING) {
+        // A storm of events; walking the tree again is cheaper than the list
+        overflows++;
+        pendingChanged.clear();
+        rescan(rootDir);
+    }
+}
+
+void FsWatcher::rescan(const string& dir) {
+    for (const auto& queued : pendingRescan) {
+        if (isUnder(dir, queued)) return;
+    }
+    for (auto it = pendingRescan.begin(); it != pendingRescan.end();) {
+        it = isUnder(*it, dir) ? pendingRescan.erase(it) : next(it);
+    }
+    pendingRescan.insert(dir);
+}
+
+void FsWatcher::run() {
+    auto deadline = chrono::steady_clock::time_point::max();
+    while (running) {
+        bool hadPending = !pendingChanged.empty() || !pendingRescan.empty();
+        int timeout = -1;
+        if (hadPending) {
+            auto wait = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+            timeout = (int)max<long long>(0, wait.count());
+        }
+
+        struct pollfd fds[2] = {{eventFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+        int ready = poll(fds, 2, timeout);
+        if (ready < 0 && errno != EINTR) break;
+        if (ready > 0 && (fds[1].revents & POLLIN)) break;
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            if (activeBackend == Backend::Fanotify) readFanotify();
+            else readInotify();
+        }
+
+        bool pending = !pendingChanged.empty() || !pendingRescan.empty();
+        if (pending && !hadPending) deadline = chrono::steady_clock::now() + coalesceDelay;
+        if (!pending || chrono::steady_clock::now() < deadline) continue;
+
+        vector<string> rescanDirs(pendingRescan.begin(), pendingRescan.end());
+        vector<string> changedPaths;
+        for (const auto& path : pendingChanged) {
+            bool covered = false;
+            for (const auto& dir : rescanDirs) {
+                if (isUnder(path, dir)) { covered = true; break; }
+            }
+            if (!covered) changedPaths.push_back(path);
+        }
+        pendingChanged.clear();
+        pendingRescan.clear();
+        deadline = chrono::steady_clock::time_point::max();
+        if (onChange) onChange(changedPaths, rescanDirs);
+    }
+}
@@ -0,0 +1,113 @@
+#include "../include/hash_cache.h"
+#include "../include/sha256.h"
+#include "../include/utils.h"
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstdio>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+    const size_t PRUNE_THRESHOLD = 200000;   // entries before save() checks for deleted files
+}
+
+HashCache::HashCache(const string& file) : cacheFile(file) {}
+
+string HashCache::defaultFile() {
+    return Utils::getHomeDir() + "/.spacemate/hash_cache.txt";
+}
+
+// ===== Persistence =====
+bool HashCache::load() {
+    ifstream in(cacheFile);
+    if (!in) return false;
+
+    lock_guard<mutex> lock(cacheMutex);
+    string line;
+    while (getline(in, line)) {
+        // size|mtime|hash|path - the path goes last since it may contain '|'
+        size_t a = line.find('|');
+        size_t b = a == string::npos ? a : line.find('|', a + 1);
+        size_t c = b == string::npos ? b : line.find('|', b + 1);
+        if (c == string::npos) continue;
+
+        Entry entry;
+        entry.size = strtoull(line.c_str(), nullptr, 10);
+        entry.mtime = (time_t)strtoll(line.c_str() + a + 1, nullptr, 10);
+        entry.hash = line.substr(b + 1, c - b - 1);
+        entries[line.substr(c + 1)] = entry;
+    }
+    dirty = false;
+    return true;
+}
+
+bool HashCache::save() {
+    unordered_map<string, Entry> snapshot;
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        if (!dirty) return true;
+        snapshot = entries;
+    }
+
+    if (snapshot.size() > PRUNE_THRESHOLD) {
+        for (auto it = snapshot.begin(); it != snapshot.end();) {
+            struct stat st;
+            it = stat(it->first.c_str(), &st) == 0 ? next(it) : snapshot.erase(it);
+        }
+    }
+
+    size_t slash = cacheFile.find_last_of('/');
+    if (slash != string::npos) Utils::createDirectory(cacheFile.substr(0, slash));
+    string tmp = cacheFile + ".tmp";
+    {
+        ofstream out(tmp, ios::trunc);
+        if (!out) return false;
+        for (const auto& entry : snapshot) {
+            out << entry.second.size << "|" << entry.second.mtime << "|" << entry.second.hash << "|" << entry.first << "\n";
+        }
+        if (!out) return false;
+    }
+    if (rename(tmp.c_str(), cacheFile.c_str()) != 0) return false;
+
+    lock_guard<mutex> lock(cacheMutex);
+    dirty = false;
+    return true;
+}
+
+// ===== Lookup =====
+string HashCache::hash(const string& path, unsigned long long size, time_t mtime) {
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        auto it = entries.find(path);
+        if (it != entries.end() && it->second.size == size && it->second.mtime == mtime) {
+            hitCount++;
+            return it->second.hash;
+        }
+        missCount++;
+    }
+
+    string digest = Sha256::hashFile(path);
+    if (digest.empty()) return digest;
+
+    lock_guard<mutex> lock(cacheMutex);
+    entries[path] = {size, mtime, digest};
+    dirty = true;
+    return digest;
+}
+
+size_t HashCache::size() const {
+    lock_guard<mutex> lock(cacheMutex);
+    return entries.size();
+}
+
+size_t HashCache::hits() const {
+    lock_guard<mutex> lock(cacheMutex);
+    return hitCount;
+}
+
+size_t HashCache::misses() const {
+    lock_guard<mutex> lock(cacheMutex);
+    return missCount;
+}
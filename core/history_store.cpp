@@ -0,0 +1,385 @@
+#include "../include/history_store.h"
+#include "../include/utils.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+    const char MAGIC[8] = {'S', 'M', 'H', 'I', 'S', 'T', '0', '1'};
+    const uint32_t FORMAT_VERSION = 1;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+    };
+
+    const size_t FLUSH_RECORDS = 4096;
+    const time_t FLUSH_SECONDS = 30;
+    const time_t HEARTBEAT_SECONDS = 60;
+    const off_t COMPACT_SLACK = 1 << 20;
+
+    bool samePoint(const HistoryPoint& a, const HistoryPoint& b) {
+        return a.used == b.used && a.available == b.available && a.inodesFree == b.inodesFree;
+    }
+
+    bool fitsDelta(unsigned long long from, unsigned long long to, int32_t& delta) {
+        long long d = (long long)to - (long long)from;
+        if (d < INT32_MIN || d > INT32_MAX) return false;
+        delta = (int32_t)d;
+        return true;
+    }
+
+    int32_t lowBits(unsigned long long v)  { return (int32_t)(uint32_t)(v & 0xffffffffULL); }
+    int32_t highBits(unsigned long long v) { return (int32_t)(uint32_t)(v >> 32); }
+    unsigned long long joinBits(int32_t high, int32_t low) {
+        return ((unsigned long long)(uint32_t)high << 32) | (uint32_t)low;
+    }
+
+    // Read-only view of a history file; empty if missing or not ours
+    class MappedHistory {
+    public:
+        explicit MappedHistory(const string& file) {
+            int fd = open(file.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(FileHeader)) {
+                void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                if (addr != MAP_FAILED) {
+                    base = addr;
+                    length = st.st_size;
+                }
+            }
+            close(fd);
+
+            if (base) {
+                const FileHeader* header = static_cast<const FileHeader*>(base);
+                if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+                    header->recordSize != sizeof(HistoryRecord)) {
+                    munmap(base, length);
+                    base = nullptr;
+                    length = 0;
+                }
+            }
+        }
+        ~MappedHistory() { if (base) munmap(base, length); }
+
+        const HistoryRecord* records() const {
+            return reinterpret_cast<const HistoryRecord*>(static_cast<const char*>(base) + sizeof(FileHeader));
+        }
+        // A concurrent append may leave a partial record at the end; ignore it
+        size_t count() const { return base ? (length - sizeof(FileHeader)) / sizeof(HistoryRecord) : 0; }
+
+    private:
+        void* base = nullptr;
+        size_t length = 0;
+    };
+
+    // Replays records into absolute samples
+    template <typename Visit>
+    void decode(const MappedHistory& map, Visit visit) {
+        struct State {
+            HistoryPoint point;
+            HistoryRecord low;
+            bool valid = false;
+        };
+        vector<State> states;
+
+        const HistoryRecord* records = map.records();
+        for (size_t i = 0; i < map.count(); i++) {
+            const HistoryRecord& r = records[i];
+            if (r.mount >= states.size()) states.resize(r.mount + 1);
+            State& s = states[r.mount];
+
+            if (r.kind == HistoryStore::KeyLow) {
+                s.low = r;
+                continue;
+            }
+            if (r.kind == HistoryStore::KeyHigh) {
+                s.point.used = joinBits(r.used, s.low.used);
+                s.point.available = joinBits(r.available, s.low.available);
+                s.point.inodesFree = joinBits(r.inodesFree, s.low.inodesFree);
+                s.valid = true;
+            } else if (r.kind == HistoryStore::Delta && s.valid) {
+                s.point.used += r.used;
+                s.point.available += r.available;
+                s.point.inodesFree += r.inodesFree;
+            } else {
+                continue;
+            }
+            s.point.timestamp = r.timestamp;
+            visit(r.mount, s.point);
+        }
+    }
+
+    int openLocked(const string& file, int flags) {
+        // Compaction replaces the file by rename; retry until the lock is
+        // held on the inode that is actually at `file`.
+        for (int attempt = 0; attempt < 5; attempt++) {
+            int fd = open(file.c_str(), flags, 0644);
+            if (fd < 0) return -1;
+            if (flock(fd, LOCK_EX) != 0) { close(fd); return -1; }
+
+            struct stat opened, current;
+            if (fstat(fd, &opened) == 0 && stat(file.c_str(), &current) == 0 &&
+                opened.st_ino == current.st_ino) {
+                return fd;
+            }
+            close(fd);
+        }
+        return -1;
+    }
+
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = write(fd, p, size);
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+}
+
+HistoryStore::HistoryStore(const string& file)
+    : historyFile(file), lastFlush(time(nullptr)), compactedSize(0) {
+    size_t slash = file.rfind('/');
+    string dir = slash == string::npos ? "." : file.substr(0, slash);
+    mountsFile = dir + "/history_mounts.txt";
+    Utils::createDirectory(dir);
+
+    struct stat st;
+    if (stat(historyFile.c_str(), &st) == 0) compactedSize = st.st_size;
+}
+
+HistoryStore::~HistoryStore() {
+    flush();
+}
+
+string HistoryStore::defaultFile() {
+    return Utils::getHomeDir() + "/.spacemate/history.bin";
+}
+
+// ===== Mount table =====
+map<uint16_t, string> HistoryStore::loadMounts() const {
+    map<uint16_t, string> result;
+    ifstream in(mountsFile);
+    string line;
+    while (getline(in, line)) {
+        size_t sep = line.find('|');
+        if (sep == string::npos) continue;
+        unsigned long id;
+        try {
+            id = stoul(line.substr(0, sep));
+        } catch (...) {
+            continue;   // a torn or hand-edited line
+        }
+        if (id > UINT16_MAX) continue;
+        result[(uint16_t)id] = line.substr(sep + 1);
+    }
+    return result;
+}
+
+bool HistoryStore::mountId(const string& path, uint16_t& id) {
+    auto it = mountIds.find(path);
+    if (it != mountIds.end()) {
+        id = it->second;
+        return true;
+    }
+
+    // Another process may have registered the path since we last looked
+    int fd = openLocked(mountsFile, O_RDWR | O_CREAT | O_APPEND);
+    if (fd < 0) return false;
+    unsigned long next = 0;
+    bool found = false;
+    for (const auto& entry : loadMounts()) {
+        if (entry.second == path) { id = entry.first; found = true; }
+        if (!found && entry.first >= next) next = entry.first + 1ul;
+    }
+    // Samples under an id the mounts file does not name could never be read back
+    struct stat st;
+    if (!found && next <= UINT16_MAX && fstat(fd, &st) == 0) {
+        string line = to_string(next) + "|" + path + "\n";
+        found = writeAll(fd, line.data(), line.size());
+        if (!found) ftruncate(fd, st.st_size);   // no torn line for the next append to run into
+        id = (uint16_t)next;
+    }
+    close(fd);
+    if (!found) return false;
+
+    mountIds[path] = id;
+    return true;
+}
+
+// ===== Writing =====
+void HistoryStore::append(const string& path, const HistoryPoint& point) {
+    uint16_t id;
+    if (!mountId(path, id)) return;
+
+    auto last = lastWritten.find(id);
+    if (last != lastWritten.end() && samePoint(last->second, point) &&
+        point.timestamp - last->second.timestamp < HEARTBEAT_SECONDS) {
+        return;
+    }
+    lastWritten[id] = point;
+    pending.push_back({id, point});
+
+    if (pending.size() >= FLUSH_RECORDS || point.timestamp - lastFlush >= FLUSH_SECONDS) {
+        flush();
+    }
+}
+
+bool HistoryStore::writeRecords(int fd, const vector<Pending>& samples) const {
+    // Every batch starts each mount with a key frame, so batches appended
+    // by different processes never depend on one another.
+    map<uint16_t, HistoryPoint> previous;
+    vector<HistoryRecord> records;
+    records.reserve(samples.size() + 16);
+
+    for (const auto& s : samples) {
+        HistoryRecord r{};
+        r.timestamp = (uint32_t)s.point.timestamp;
+        r.mount = s.mount;
+
+        auto prev = previous.find(s.mount);
+        if (prev != previous.end() &&
+            fitsDelta(prev->second.used, s.point.used, r.used) &&
+            fitsDelta(prev->second.available, s.point.available, r.available) &&
+            fitsDelta(prev->second.inodesFree, s.point.inodesFree, r.inodesFree)) {
+            r.kind = Delta;
+            records.push_back(r);
+        } else {
+            r.kind = KeyLow;
+            r.used = lowBits(s.point.used);
+            r.available = lowBits(s.point.available);
+            r.inodesFree = lowBits(s.point.inodesFree);
+            records.push_back(r);
+            r.kind = KeyHigh;
+            r.used = highBits(s.point.used);
+            r.available = highBits(s.point.available);
+            r.inodesFree = highBits(s.point.inodesFree);
+            records.push_back(r);
+        }
+        previous[s.mount] = s.point;
+    }
+    return writeAll(fd, records.data(), records.size() * sizeof(HistoryRecord));
+}
+
+bool HistoryStore::flush() {
+    lastFlush = time(nullptr);
+    if (pending.empty()) return true;
+
+    int fd = openLocked(historyFile, O_WRONLY | O_CREAT | O_APPEND);
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size == 0) {
+        FileHeader header;
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = FORMAT_VERSION;
+        header.recordSize = sizeof(HistoryRecord);
+        ok = writeAll(fd, &header, sizeof(header));
+    }
+    ok = ok && writeRecords(fd, pending);
+    off_t size = ok && fstat(fd, &st) == 0 ? st.st_size : 0;
+    close(fd);
+    pending.clear();
+
+    if (size > 2 * compactedSize + COMPACT_SLACK) compact();
+    return ok;
+}
+
+bool HistoryStore::compact(time_t now) {
+    int fd = openLocked(historyFile, O_RDWR | O_CREAT);
+    if (fd < 0) return false;
+
+    // Keep everything from the last day, then one sample per minute for a
+    // month and one per hour for a year
+    vector<Pending> kept;
+    map<uint16_t, time_t> lastKept;
+    {
+        MappedHistory map(historyFile);
+        decode(map, [&](uint16_t mount, const HistoryPoint& p) {
+            time_t age = now - p.timestamp;
+            time_t bucket = age <= 86400 ? 0 : age <= 30 * 86400 ? 60 : age <= 365 * 86400 ? 3600 : -1;
+            if (bucket < 0) return;
+
+            auto last = lastKept.find(mount);
+            if (bucket > 0 && last != lastKept.end() && last->second / bucket == p.timestamp / bucket) return;
+            lastKept[mount] = p.timestamp;
+            kept.push_back({mount, p});
+        });
+    }
+
+    string tmpFile = historyFile + ".tmp";
+    int out = open(tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = out >= 0;
+    if (ok) {
+        FileHeader header;
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = FORMAT_VERSION;
+        header.recordSize = sizeof(HistoryRecord);
+        ok = writeAll(out, &header, sizeof(header)) && writeRecords(out, kept) && fsync(out) == 0;
+        struct stat st;
+        if (ok && fstat(out, &st) == 0) compactedSize = st.st_size;
+        close(out);
+    }
+    ok = ok && rename(tmpFile.c_str(), historyFile.c_str()) == 0;
+    if (!ok) unlink(tmpFile.c_str());
+
+    close(fd);
+    return ok;
+}
+
+// ===== Reading =====
+void HistoryStore::forEach(time_t from, time_t to,
+                           const function<void(const string&, const HistoryPoint&)>& visit) const {
+    map<uint16_t, string> names = loadMounts();
+    vector<const string*> byId;
+    for (const auto& entry : names) {
+        if (entry.first >= byId.size()) byId.resize(entry.first + 1, nullptr);
+        byId[entry.first] = &entry.second;
+    }
+
+    MappedHistory map(historyFile);
+    decode(map, [&](uint16_t mount, const HistoryPoint& p) {
+        if (p.timestamp < from || p.timestamp > to) return;
+        if (mount >= byId.size() || !byId[mount]) return;
+        visit(*byId[mount], p);
+    });
+}
+
+vector<HistoryPoint> HistoryStore::read(const string& path, time_t from, time_t to) const {
+    vector<HistoryPoint> points;
+    forEach(from, to, [&](const string& mount, const HistoryPoint& p) {
+        if (mount == path) points.push_back(p);
+    });
+    return points;
+}
+
+vector<HistoryMountInfo> HistoryStore::mounts() const {
+    map<string, HistoryMountInfo> byPath;
+    forEach(0, LONG_MAX, [&](const string& path, const HistoryPoint& p) {
+        HistoryMountInfo& info = byPath[path];
+        if (info.samples == 0) {
+            info.path = path;
+            info.first = p.timestamp;
+        }
+        info.last = p.timestamp;
+        info.samples++;
+    });
+
+    vector<HistoryMountInfo> result;
+    for (auto& entry : byPath) result.push_back(entry.second);
+    return result;
+}
@@ -0,0 +1,158 @@
+#include "../include/live_index.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <cstring>
+
+using namespace std;
+
+LiveIndex::LiveIndex(const string& root) : rootDir(root) {
+    while (rootDir.size() > 1 && rootDir.back() == '/') rootDir.pop_back();
+}
+
+// ===== Walking =====
+bool LiveIndex::walk(const string& dir, Listing& out, const atomic<bool>* cancel) {
+    vector<string> pending{dir};
+    while (!pending.empty()) {
+        if (cancel && *cancel) return false;
+        string current = move(pending.back());
+        pending.pop_back();
+
+        DIR* handle = opendir(current.c_str());
+        if (!handle) continue;
+        out.dirs.insert(current);
+        int fd = dirfd(handle);
+
+        struct dirent* entry;
+        while ((entry = readdir(handle)) != nullptr) {
+            const char* name = entry->d_name;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+            struct stat st;
+            if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+            string path = current == "/" ? "/" + string(name) : current + "/" + name;
+            if (S_ISDIR(st.st_mode)) {
+                pending.push_back(move(path));
+            } else if (S_ISREG(st.st_mode)) {
+                out.files[move(path)] = {(unsigned long long)st.st_size, st.st_mtime};
+            }
+        }
+        closedir(handle);
+    }
+    return true;
+}
+
+bool LiveIndex::build(const atomic<bool>* cancel) {
+    Listing listing;
+    if (!walk(rootDir, listing, cancel)) return false;
+
+    lock_guard<mutex> lock(indexMutex);
+    files.clear();
+    dirs.clear();
+    bytes = 0;
+    updates = 0;
+    merge(listing);
+    return !dirs.empty();
+}
+
+void LiveIndex::rescan(const string& dir) {
+    if (!contains(dir)) return;
+    // Walk without the lock; only the swap-in blocks readers
+    Listing listing;
+    walk(dir, listing);
+
+    lock_guard<mutex> lock(indexMutex);
+    removeUnder(dir);
+    merge(listing);
+}
+
+// ===== Incremental updates =====
+void LiveIndex::apply(const vector<string>& changed, const vector<string>& rescanDirs) {
+    for (const auto& dir : rescanDirs) rescan(dir);
+
+    lock_guard<mutex> lock(indexMutex);
+    for (const auto& path : changed) {
+        if (contains(path)) update(path);
+    }
+}
+
+void LiveIndex::update(const string& path) {
+    updates++;
+    struct stat st;
+    bool exists = lstat(path.c_str(), &st) == 0;
+    // Gone (a file, or a whole directory moved out or deleted), or now of
+    // another type: the old entry and its totals go before a new one is added
+    if (!exists || !S_ISREG(st.st_mode)) {
+        auto it = files.find(path);
+        if (it != files.end()) {
+            bytes -= it->second.size;
+            files.erase(it);
+        }
+    }
+    if ((!exists || !S_ISDIR(st.st_mode)) && dirs.count(path)) removeUnder(path);
+    if (!exists) return;
+
+    if (S_ISREG(st.st_mode)) {
+        IndexedFile& file = files[path];
+        bytes += (unsigned long long)st.st_size - file.size;
+        file = {(unsigned long long)st.st_size, st.st_mtime};
+    } else if (S_ISDIR(st.st_mode) && !dirs.count(path)) {
+        // A directory that appeared (or was moved in) with contents
+        Listing listing;
+        walk(path, listing);
+        merge(listing);
+    }
+}
+
+void LiveIndex::removeUnder(const string& dir) {
+    string prefix = dir == "/" ? dir : dir + "/";
+    for (auto it = files.lower_bound(prefix); it != files.end() && it->first.compare(0, prefix.size(), prefix) == 0;) {
+        bytes -= it->second.size;
+        it = files.erase(it);
+    }
+    dirs.erase(dir);
+    for (auto it = dirs.lower_bound(prefix); it != dirs.end() && it->compare(0, prefix.size(), prefix) == 0;) {
+        it = dirs.erase(it);
+    }
+}
+
+void LiveIndex::merge(Listing& listing) {
+    for (auto& entry : listing.files) {
+        IndexedFile& file = files[entry.first];
+        bytes += entry.second.size - file.size;
+        file = entry.second;
+    }
+    dirs.insert(listing.dirs.begin(), listing.dirs.end());
+}
+
+bool LiveIndex::contains(const string& path) const {
+    if (path == rootDir) return true;
+    if (path.compare(0, rootDir.size(), rootDir) != 0) return false;
+    return rootDir == "/" || (path.size() > rootDir.size() && path[rootDir.size()] == '/');
+}
+
+// ===== Queries =====
+unsigned long long LiveIndex::totalBytes() const {
+    lock_guard<mutex> lock(indexMutex);
+    return bytes;
+}
+
+size_t LiveIndex::fileCount() const {
+    lock_guard<mutex> lock(indexMutex);
+    return files.size();
+}
+
+size_t LiveIndex::directoryCount() const {
+    lock_guard<mutex> lock(indexMutex);
+    return dirs.size();
+}
+
+size_t LiveIndex::updateCount() const {
+    lock_guard<mutex> lock(indexMutex);
+    return updates;
+}
+
+void LiveIndex::forEachFile(const function<void(const string&, const IndexedFile&)>& visit) const {
+    lock_guard<mutex> lock(indexMutex);
+    for (const auto& entry : files) visit(entry.first, entry.second);
+}
@@ -0,0 +1,203 @@
+#include "../include/mount_table.h"
+#include <set>
+#include <algorithm>
+#include <sstream>
+#include <climits>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/statvfs.h>
+
+using namespace std;
+
+namespace {
+    // Mount points and sources escape space, tab, newline and backslash as \ooo
+    string unescape(const string& field) {
+        string result;
+        result.reserve(field.size());
+        for (size_t i = 0; i < field.size(); i++) {
+            if (field[i] == '\\' && i + 3 < field.size() && field[i + 1] >= '0' && field[i + 1] <= '3') {
+                result += (char)strtol(field.substr(i + 1, 3).c_str(), nullptr, 8);
+                i += 3;
+            } else {
+                result += field[i];
+            }
+        }
+        return result;
+    }
+
+    bool parseLine(const string& line, MountInfo& mount) {
+        // id parent major:minor root mountpoint options [optional...] - fstype source superoptions
+        istringstream in(line);
+        string parent, root, field;
+        if (!(in >> mount.id >> parent >> mount.deviceNumber >> root >> mount.mountPoint >> mount.options)) return false;
+        while (in >> field && field != "-") {}
+        if (field != "-" || !(in >> mount.fsType >> mount.device)) return false;
+
+        mount.mountPoint = unescape(mount.mountPoint);
+        mount.device = unescape(mount.device);
+        mount.readOnly = mount.options == "ro" || mount.options.compare(0, 3, "ro,") == 0;
+        return true;
+    }
+
+    void fill(const struct statvfs& st, VolumeStats& result) {
+        result.total = (unsigned long long)st.f_blocks * st.f_frsize;
+        result.free = (unsigned long long)st.f_bfree * st.f_frsize;
+        result.available = (unsigned long long)st.f_bavail * st.f_frsize;
+        result.inodesTotal = st.f_files;
+        result.inodesFree = st.f_ffree;
+    }
+}
+
+bool MountInfo::isPseudo() const {
+    static const set<string> pseudo = {
+        "proc", "sysfs", "cgroup", "cgroup2", "devpts", "devtmpfs", "mqueue", "debugfs",
+        "tracefs", "securityfs", "pstore", "bpf", "configfs", "fusectl", "hugetlbfs",
+        "autofs", "binfmt_misc", "nsfs", "rpc_pipefs", "efivarfs", "selinuxfs"
+    };
+    return pseudo.count(fsType) > 0;
+}
+
+MountTable::MountTable(const string& file) : sourceFile(file) {
+    fd = open(sourceFile.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+MountTable::~MountTable() {
+    if (fd >= 0) close(fd);
+}
+
+MountTable& MountTable::instance() {
+    static MountTable table;
+    return table;
+}
+
+void MountTable::setTtl(chrono::milliseconds value) {
+    lock_guard<mutex> lock(tableMutex);
+    ttl = value;
+}
+
+// ===== Parsing =====
+void MountTable::refreshIfChanged() {
+    if (fd < 0) return;
+    if (loaded) {
+        // The kernel flags mountinfo with POLLPRI|POLLERR once the mount
+        // namespace changed after our last read; a plain file never does
+        struct pollfd pfd = {fd, POLLPRI, 0};
+        if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & (POLLPRI | POLLERR))) return;
+    }
+    load();
+}
+
+bool MountTable::load() {
+    string content;
+    char buffer[16384];
+    if (lseek(fd, 0, SEEK_SET) < 0) return false;
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) content.append(buffer, n);
+    if (n < 0) return false;
+
+    vector<MountInfo> parsed;
+    istringstream lines(content);
+    string line;
+    while (getline(lines, line)) {
+        MountInfo mount;
+        if (parseLine(line, mount)) parsed.push_back(mount);
+    }
+
+    table.swap(parsed);
+    cache.clear();
+    loaded = true;
+    reloads++;
+    return true;
+}
+
+// ===== Lookup =====
+const MountInfo* MountTable::findMount(const string& path) const {
+    char resolved[PATH_MAX];
+    string target = realpath(path.c_str(), resolved) ? string(resolved) : path;
+
+    const MountInfo* best = nullptr;
+    for (const auto& mount : table) {
+        const string& mp = mount.mountPoint;
+        bool covers = mp == "/" || target == mp ||
+                      (target.size() > mp.size() && target.compare(0, mp.size(), mp) == 0 && target[mp.size()] == '/');
+        // >= so that a later mount on the same point shadows the earlier one
+        if (covers && (!best || mp.size() >= best->mountPoint.size())) best = &mount;
+    }
+    return best;
+}
+
+vector<MountInfo> MountTable::mounts() {
+    lock_guard<mutex> lock(tableMutex);
+    refreshIfChanged();
+    return table;
+}
+
+bool MountTable::mountFor(const string& path, MountInfo& mount) {
+    lock_guard<mutex> lock(tableMutex);
+    refreshIfChanged();
+    const MountInfo* found = findMount(path);
+    if (!found) return false;
+    mount = *found;
+    return true;
+}
+
+bool MountTable::statMount(const MountInfo& mount, VolumeStats& result) {
+    auto now = chrono::steady_clock::now();
+    auto it = cache.find(mount.mountPoint);
+    if (it != cache.end() && now - it->second.takenAt < ttl) {
+        result = it->second.stats;
+        return true;
+    }
+
+    struct statvfs st;
+    if (statvfs(mount.mountPoint.c_str(), &st) != 0) return false;
+    result.mount = mount;
+    fill(st, result);
+    cache[mount.mountPoint] = {result, now};
+    return true;
+}
+
+bool MountTable::stats(const string& path, VolumeStats& result) {
+    lock_guard<mutex> lock(tableMutex);
+    refreshIfChanged();
+    const MountInfo* mount = findMount(path);
+    if (mount && statMount(*mount, result)) return true;
+
+    // No mount table (not Linux, /proc missing) or the mount point itself
+    // is out of reach: ask about the path, uncached
+    struct statvfs st;
+    if (statvfs(path.c_str(), &st) != 0) return false;
+    result = VolumeStats();
+    result.mount.mountPoint = path;
+    fill(st, result);
+    return true;
+}
+
+vector<VolumeStats> MountTable::volumes() {
+    lock_guard<mutex> lock(tableMutex);
+    refreshIfChanged();
+
+    // Only the last mount on a point is visible, and bind mounts repeat a
+    // filesystem: keep the shortest visible mount point of each device
+    map<string, const MountInfo*> visible;
+    for (const auto& mount : table) visible[mount.mountPoint] = &mount;
+    map<string, const MountInfo*> byDevice;
+    for (const auto& entry : visible) {
+        const MountInfo* mount = entry.second;
+        if (mount->isPseudo()) continue;
+        auto& best = byDevice[mount->deviceNumber];
+        if (!best || mount->mountPoint.size() < best->mountPoint.size()) best = mount;
+    }
+
+    vector<VolumeStats> result;
+    for (const auto& entry : byDevice) {
+        VolumeStats volume;
+        if (statMount(*entry.second, volume) && volume.total > 0) result.push_back(volume);
+    }
+    sort(result.begin(), result.end(), [](const VolumeStats& a, const VolumeStats& b) {
+        return a.mount.mountPoint < b.mount.mountPoint;
+    });
+    return result;
+}
@@ -0,0 +1,251 @@
+#include "../include/object_store.h"
+#include "../include/sha256.h"
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+    bool isHash(const string& name) {
+        if (name.size() != 64) return false;
+        for (char c : name) {
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+        }
+        return true;
+    }
+
+    bool sameFile(const struct stat& a, const struct stat& b) {
+        return a.st_size == b.st_size && a.st_mtim.tv_sec == b.st_mtim.tv_sec &&
+               a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+    }
+}
+
+const char* ObjectStore::COMPRESSED_SUFFIX = ".smz";
+
+ObjectStore::ObjectStore(const string& root, const CompressionSettings& settings, const PackSettings& packSettings)
+    : storeRoot(root), compression(settings), packing(packSettings) {
+    if (packing.enabled) packs = make_unique<PackStore>(storeRoot + "/packs", packing);
+}
+
+bool ObjectStore::open() {
+    return mkdir(storeRoot.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool ObjectStore::flush() {
+    return !packs || packs->flush();
+}
+
+string ObjectStore::pathFor(const string& hash) const {
+    return storeRoot + "/" + hash.substr(0, 2) + "/" + hash;
+}
+
+string ObjectStore::find(const string& hash) const {
+    if (!isHash(hash)) return "";
+    struct stat st;
+    string path = pathFor(hash);
+    if (stat(path.c_str(), &st) == 0) return path;
+    path += COMPRESSED_SUFFIX;
+    return stat(path.c_str(), &st) == 0 ? path : "";
+}
+
+string ObjectStore::hashOf(const string& path) const {
+    if (path.compare(0, storeRoot.size() + 1, storeRoot + "/") != 0) return "";
+    string hash = path.substr(path.find_last_of('/') + 1);
+    if (isCompressed(hash)) hash.resize(hash.size() - strlen(COMPRESSED_SUFFIX));
+    return isHash(hash) && (path == pathFor(hash) || path == pathFor(hash) + COMPRESSED_SUFFIX) ? hash : "";
+}
+
+bool ObjectStore::isCompressed(const string& path) {
+    size_t length = strlen(COMPRESSED_SUFFIX);
+    return path.size() > length && path.compare(path.size() - length, length, COMPRESSED_SUFFIX) == 0;
+}
+
+bool ObjectStore::contains(const string& hash) const {
+    return !find(hash).empty();
+}
+
+bool ObjectStore::remove(const string& hash) {
+    if (!isHash(hash)) return false;
+    bool raw = unlink(pathFor(hash).c_str()) == 0 || errno == ENOENT;
+    bool compressed = unlink((pathFor(hash) + COMPRESSED_SUFFIX).c_str()) == 0 || errno == ENOENT;
+    return raw && compressed;
+}
+
+// ===== Storing =====
+StoredObject ObjectStore::put(const string& source) {
+    StoredObject object;
+    struct stat before;
+    if (stat(source.c_str(), &before) != 0 || !S_ISREG(before.st_mode)) {
+        object.copy.error = errno ? errno : EINVAL;
+        return object;
+    }
+    object.source = before;
+    object.size = before.st_size;
+    if (packs && (unsigned long long)before.st_size < packing.threshold) return putPacked(source, before);
+
+    // The copy hashes what it reads, so the checksum costs no extra read;
+    // the object is named once the copy is done
+    static atomic<unsigned long> sequence{0};
+    string temp = storeRoot + "/.incoming." + to_string(getpid()) + "." + to_string(sequence++) + ".tmp";
+    Sha256 digest;
+    bool hashed = false;
+    if (compression.codec != Codec::None && object.size >= compression.minimumSize &&
+        Compressor::worthCompressing(source)) {
+        object.copy = Compressor::compressFile(source, temp, compression, &digest);
+        hashed = object.copy.ok;
+        if (object.copy.ok && object.copy.bytes < object.size) {
+            object.codec = compression.codec;
+        } else {
+            object.copy = CopyResult();   // did not shrink: store it as it is
+        }
+    }
+    if (object.codec == Codec::None) {
+        if (hashed) {
+            object.copy = CopyEngine::copyFile(source, temp);   // hash known; the kernel may copy
+        } else {
+            digest = Sha256();
+            object.copy = CopyEngine::copyFile(source, temp, &digest);
+        }
+    }
+    object.storedSize = object.copy.bytes;
+
+    // A file that changed while it was copied would be stored under the
+    // wrong name
+    struct stat after;
+    if (object.copy.ok && (stat(source.c_str(), &after) != 0 || !sameFile(before, after) ||
+                           (object.codec == Codec::None && object.copy.bytes != object.size))) {
+        object.copy.ok = false;
+        object.copy.error = EAGAIN;
+    }
+    if (!object.copy.ok) {
+        unlink(temp.c_str());
+        return object;
+    }
+    object.hash = digest.hexDigest();
+
+    // Content that is already stored keeps its object
+    if (reuse(object)) {
+        unlink(temp.c_str());
+        return object;
+    }
+    string dir = storeRoot + "/" + object.hash.substr(0, 2);
+    object.path = pathFor(object.hash) + (object.codec != Codec::None ? COMPRESSED_SUFFIX : "");
+    if ((mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) || rename(temp.c_str(), object.path.c_str()) != 0) {
+        object.copy.ok = false;
+        object.copy.error = errno;
+        unlink(temp.c_str());
+        return object;
+    }
+    object.ok = true;
+    return object;
+}
+
+bool ObjectStore::reuse(StoredObject& object) const {
+    string path = find(object.hash);
+    if (path.empty()) return false;
+    struct stat stored;
+    unsigned long long original;
+    object.path = path;
+    object.storedSize = stat(path.c_str(), &stored) == 0 ? stored.st_size : 0;
+    object.codec = Codec::None;
+    if (isCompressed(path)) Compressor::readHeader(path, object.codec, original);
+    object.copy = CopyResult();
+    object.ok = object.deduplicated = true;
+    return true;
+}
+
+// ===== Small files =====
+// One read serves the hash, the dedup check and the packed copy
+StoredObject ObjectStore::putPacked(const string& source, const struct stat& before) {
+    StoredObject object;
+    object.source = before;
+    object.size = before.st_size;
+    object.copy.method = "pack";
+    auto start = chrono::steady_clock::now();
+
+    vector<char> data(before.st_size);
+    int fd = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        object.copy.error = errno;
+        return object;
+    }
+    size_t got = 0;
+    while (got < data.size()) {
+        ssize_t n = read(fd, data.data() + got, data.size() - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += n;
+    }
+    close(fd);
+    struct stat after;
+    if (got != data.size() || stat(source.c_str(), &after) != 0 || !sameFile(before, after)) {
+        object.copy.error = EAGAIN;   // changed while it was read
+        return object;
+    }
+
+    Sha256 sha;
+    sha.update(data.data(), data.size());
+    object.hash = sha.hexDigest();
+
+    PackLocation location;
+    if (reuse(object)) return object;
+    if (packs->find(object.hash, location)) {
+        object.path = location.pack;
+        object.storedSize = location.storedSize;
+        object.codec = location.codec;
+        object.ok = object.deduplicated = true;
+        return object;
+    }
+
+    // Packed objects are compressed as one block, when that shrinks them
+    Codec codec = Codec::None;
+    if (compression.codec != Codec::None && object.size >= compression.minimumSize &&
+        Compressor::worthCompressing(source)) {
+        vector<char> packed = Compressor::compressBlock(compression.codec, compression.level, data);
+        if (!packed.empty()) {
+            data.swap(packed);
+            codec = compression.codec;
+        }
+    }
+    if (!packs->add(object.hash, data, object.size, codec, before.st_mode, before.st_mtim, location)) {
+        object.copy.error = errno ? errno : EIO;
+        return object;
+    }
+    object.path = location.pack;
+    object.storedSize = location.storedSize;
+    object.codec = codec;
+    object.copy.ok = object.ok = true;
+    object.copy.bytes = location.storedSize;
+    object.copy.files = 1;
+    object.copy.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return object;
+}
+
+// ===== Store lock =====
+StoreLock::StoreLock(const string& root, bool exclusive) {
+    if (mkdir(root.c_str(), 0755) != 0 && errno != EEXIST) return;
+    lockFd = ::open((root + "/.lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockFd < 0) return;
+    int result;
+    do {
+        result = flock(lockFd, exclusive ? LOCK_EX : LOCK_SH);
+    } while (result != 0 && errno == EINTR);
+    if (result != 0) release();
+}
+
+StoreLock::~StoreLock() {
+    release();
+}
+
+void StoreLock::release() {
+    if (lockFd >= 0) close(lockFd);
+    lockFd = -1;
+}
@@ -0,0 +1,195 @@
+#include "../include/owner_stats.h"
+#include "../include/utils.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <climits>
+#include <cstdlib>
+
+using namespace std;
+
+// The same directory typed as ".", "foo/" or through a symlink is one root
+static string canonicalRoot(const string& root) {
+    char resolved[PATH_MAX];
+    if (realpath(root.c_str(), resolved)) return resolved;
+    string trimmed = root;
+    while (trimmed.size() > 1 && trimmed.back() == '/') trimmed.pop_back();
+    return trimmed;
+}
+
+// ===== OwnerAccounting =====
+void OwnerAccounting::add(uid_t uid, gid_t gid, unsigned long long apparent, unsigned long long allocated,
+                          dev_t device, ino_t inode, nlink_t links) {
+    if (links > 1) {
+        linked.emplace(make_pair(device, inode), LinkedFile{uid, gid, apparent, allocated});
+        return;
+    }
+    count(uid, gid, apparent, allocated);
+}
+
+void OwnerAccounting::count(uid_t uid, gid_t gid, unsigned long long apparent, unsigned long long allocated) {
+    Totals& u = users[uid];
+    u.apparent += apparent;
+    u.allocated += allocated;
+    u.files++;
+
+    Totals& g = groups[gid];
+    g.apparent += apparent;
+    g.allocated += allocated;
+    g.files++;
+}
+
+void OwnerAccounting::merge(const OwnerAccounting& other) {
+    for (const auto& item : other.users) {
+        Totals& t = users[item.first];
+        t.apparent += item.second.apparent;
+        t.allocated += item.second.allocated;
+        t.files += item.second.files;
+    }
+    for (const auto& item : other.groups) {
+        Totals& t = groups[item.first];
+        t.apparent += item.second.apparent;
+        t.allocated += item.second.allocated;
+        t.files += item.second.files;
+    }
+    linked.insert(other.linked.begin(), other.linked.end());
+}
+
+static bool byAllocated(const OwnerUsage& a, const OwnerUsage& b) {
+    if (a.allocatedBytes != b.allocatedBytes) return a.allocatedBytes > b.allocatedBytes;
+    return a.apparentBytes > b.apparentBytes;
+}
+
+OwnerReport OwnerAccounting::finish(const string& root) const {
+    OwnerReport report;
+    report.root = canonicalRoot(root);
+    report.generated = time(nullptr);
+
+    OwnerAccounting all = *this;
+    for (const auto& item : linked) {
+        const LinkedFile& file = item.second;
+        all.count(file.uid, file.gid, file.apparent, file.allocated);
+    }
+    for (const auto& item : all.users) {
+        report.users.push_back({(unsigned int)item.first, Utils::userName(item.first),
+                                item.second.apparent, item.second.allocated, item.second.files});
+    }
+    for (const auto& item : all.groups) {
+        report.groups.push_back({(unsigned int)item.first, Utils::groupName(item.first),
+                                 item.second.apparent, item.second.allocated, item.second.files});
+    }
+    sort(report.users.begin(), report.users.end(), byAllocated);
+    sort(report.groups.begin(), report.groups.end(), byAllocated);
+    return report;
+}
+
+// ===== UsageIndex =====
+// Line format (root last so it may contain '|'):
+//   U|generated|uid|name|apparent|allocated|files|root
+//   G|generated|gid|name|apparent|allocated|files|root
+string UsageIndex::indexFile() {
+    string baseDir = Utils::getHomeDir() + "/.spacemate";
+    Utils::createDirectory(baseDir);
+    return baseDir + "/usage_index.txt";
+}
+
+vector<OwnerReport> UsageIndex::loadAll() {
+    vector<OwnerReport> reports;
+    ifstream index(indexFile());
+    if (!index.is_open()) return reports;
+
+    string line;
+    while (getline(index, line)) {
+        stringstream ss(line);
+        string kind, generated, id, name, apparent, allocated, files, root;
+        getline(ss, kind, '|');
+        getline(ss, generated, '|');
+        getline(ss, id, '|');
+        getline(ss, name, '|');
+        getline(ss, apparent, '|');
+        getline(ss, allocated, '|');
+        getline(ss, files, '|');
+        getline(ss, root);
+        if ((kind != "U" && kind != "G") || root.empty()) continue;
+
+        try {
+            OwnerUsage usage{(unsigned int)stoul(id), name, stoull(apparent), stoull(allocated), stoull(files)};
+
+            auto it = find_if(reports.begin(), reports.end(),
+                              [&root](const OwnerReport& r) { return r.root == root; });
+            if (it == reports.end()) {
+                reports.push_back(OwnerReport());
+                it = reports.end() - 1;
+                it->root = root;
+                it->generated = (time_t)stoll(generated);
+            }
+            (kind == "U" ? it->users : it->groups).push_back(usage);
+        } catch (const exception&) {
+            continue;  // skip malformed lines
+        }
+    }
+    return reports;
+}
+
+void UsageIndex::saveAll(const vector<OwnerReport>& reports) {
+    string file = indexFile();
+    string tmpFile = file + ".tmp";
+    ofstream out(tmpFile, ios::trunc);
+    if (!out.is_open()) return;
+
+    for (const auto& report : reports) {
+        for (const auto& u : report.users) {
+            out << "U|" << report.generated << "|" << u.id << "|" << u.name << "|" << u.apparentBytes
+                << "|" << u.allocatedBytes << "|" << u.files << "|" << report.root << "\n";
+        }
+        for (const auto& g : report.groups) {
+            out << "G|" << report.generated << "|" << g.id << "|" << g.name << "|" << g.apparentBytes
+                << "|" << g.allocatedBytes << "|" << g.files << "|" << report.root << "\n";
+        }
+    }
+    out.close();
+    rename(tmpFile.c_str(), file.c_str());
+}
+
+void UsageIndex::store(const OwnerReport& report) {
+    vector<OwnerReport> reports = loadAll();
+    reports.erase(remove_if(reports.begin(), reports.end(),
+                            [&report](const OwnerReport& r) { return r.root == report.root; }),
+                  reports.end());
+    reports.push_back(report);
+    saveAll(reports);
+}
+
+bool UsageIndex::load(const string& root, OwnerReport& report) {
+    string canonical = canonicalRoot(root);
+    for (auto& r : loadAll()) {
+        if (r.root == canonical) {
+            report = r;
+            sort(report.users.begin(), report.users.end(), byAllocated);
+            sort(report.groups.begin(), report.groups.end(), byAllocated);
+            return true;
+        }
+    }
+    return false;
+}
+
+vector<string> UsageIndex::roots() {
+    vector<string> result;
+    for (const auto& r : loadAll()) result.push_back(r.root);
+    return result;
+}
+
+vector<pair<string, OwnerUsage>> UsageIndex::query(const string& name, bool isGroup) {
+    vector<pair<string, OwnerUsage>> result;
+    for (const auto& r : loadAll()) {
+        for (const auto& usage : (isGroup ? r.groups : r.users)) {
+            if (usage.name == name || to_string(usage.id) == name) {
+                result.push_back({r.root, usage});
+            }
+        }
+    }
+    sort(result.begin(), result.end(),
+         [](const auto& a, const auto& b) { return a.second.allocatedBytes > b.second.allocatedBytes; });
+    return result;
+}
@@ -0,0 +1,488 @@
+#include "../include/pack_store.h"
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+    const char PACK_MAGIC[8] = {'S', 'M', 'P', 'A', 'C', 'K', '0', '1'};
+    const char INDEX_MAGIC[8] = {'S', 'M', 'P', 'I', 'D', 'X', '0', '1'};
+
+    struct IndexRecord {
+        uint8_t hash[32];
+        uint64_t offset;
+        uint64_t storedSize;
+        uint64_t size;
+        int64_t mtimeSeconds;
+        uint32_t mtimeNanoseconds;
+        uint32_t mode;
+        uint8_t codec;
+        uint8_t reserved[3];
+    };
+    static_assert(sizeof(IndexRecord) == 80, "pack index records must stay 80 bytes");
+
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = write(fd, p, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool toBinary(const string& hex, uint8_t* out) {
+        if (hex.size() != 64) return false;
+        for (size_t i = 0; i < 32; i++) {
+            unsigned value;
+            if (sscanf(hex.c_str() + 2 * i, "%2x", &value) != 1) return false;
+            out[i] = value;
+        }
+        return true;
+    }
+
+    string toHex(const uint8_t* hash) {
+        static const char digits[] = "0123456789abcdef";
+        string hex(64, '0');
+        for (size_t i = 0; i < 32; i++) {
+            hex[2 * i] = digits[hash[i] >> 4];
+            hex[2 * i + 1] = digits[hash[i] & 15];
+        }
+        return hex;
+    }
+
+    string indexPathFor(const string& pack) {
+        return pack.substr(0, pack.size() - strlen(".pack")) + ".idx";
+    }
+
+    IndexRecord toRecord(const string& hash, const PackLocation& location) {
+        IndexRecord record;
+        memset(&record, 0, sizeof(record));
+        toBinary(hash, record.hash);
+        record.offset = location.offset;
+        record.storedSize = location.storedSize;
+        record.size = location.size;
+        record.mtimeSeconds = location.mtime.tv_sec;
+        record.mtimeNanoseconds = location.mtime.tv_nsec;
+        record.mode = location.mode;
+        record.codec = (uint8_t)location.codec;
+        return record;
+    }
+
+    // Calls visit(hash, location) for every record of one pack's index
+    template <typename Visit>
+    bool readIndex(int fd, const string& pack, Visit visit) {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(INDEX_MAGIC)) return false;
+        string contents(st.st_size, '\0');
+        if (pread(fd, &contents[0], st.st_size, 0) != st.st_size ||
+            memcmp(contents.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+            return false;
+        }
+        size_t count = (contents.size() - sizeof(INDEX_MAGIC)) / sizeof(IndexRecord);
+        for (size_t i = 0; i < count; i++) {
+            IndexRecord record;
+            memcpy(&record, contents.data() + sizeof(INDEX_MAGIC) + i * sizeof(IndexRecord), sizeof(record));
+            PackLocation location;
+            location.pack = pack;
+            location.offset = record.offset;
+            location.storedSize = record.storedSize;
+            location.size = record.size;
+            location.codec = (Codec)record.codec;
+            location.mode = record.mode;
+            location.mtime.tv_sec = record.mtimeSeconds;
+            location.mtime.tv_nsec = record.mtimeNanoseconds;
+            if (!visit(toHex(record.hash), location)) break;
+        }
+        return true;
+    }
+
+    template <typename Visit>
+    bool readIndex(const string& pack, Visit visit) {
+        int fd = open(indexPathFor(pack).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        bool ok = readIndex(fd, pack, visit);
+        close(fd);
+        return ok;
+    }
+
+    string packPathIn(const string& dir, uint32_t number) {
+        char name[32];
+        snprintf(name, sizeof(name), "/pack-%06u.pack", number);
+        return dir + name;
+    }
+
+    // The highest pack number in `dir`, 0 if it holds none
+    uint32_t newestPackIn(const string& dir) {
+        uint32_t newest = 0;
+        DIR* handle = opendir(dir.c_str());
+        if (!handle) return 0;
+        while (struct dirent* entry = readdir(handle)) {
+            unsigned number;
+            char suffix[8];
+            if (sscanf(entry->d_name, "pack-%u.%7s", &number, suffix) == 2 && number > newest) newest = number;
+        }
+        closedir(handle);
+        return newest;
+    }
+
+    // Locks `path` for writing unless another writer has it; false if the
+    // lock is taken or the file was replaced meanwhile
+    bool lockForWriting(int fd, const string& path) {
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) return false;
+        struct stat opened, current;
+        return fstat(fd, &opened) == 0 && stat(path.c_str(), &current) == 0 && opened.st_ino == current.st_ino;
+    }
+}
+
+PackStore::PackStore(const string& dir, const PackSettings& packSettings) : packDir(dir), settings(packSettings) {}
+
+PackStore::~PackStore() {
+    lock_guard<mutex> lock(packMutex);
+    flushLocked();
+    closePack();
+}
+
+string PackStore::packPath(uint32_t number) const {
+    return packPathIn(packDir, number);
+}
+
+bool PackStore::isPack(const string& path) {
+    return path.size() > 5 && path.compare(path.size() - 5, 5, ".pack") == 0;
+}
+
+// ===== Loading =====
+bool PackStore::load() {
+    if (loaded) return true;
+    loaded = true;
+    if (mkdir(packDir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+
+    DIR* dir = opendir(packDir.c_str());
+    if (!dir) return false;
+    while (struct dirent* entry = readdir(dir)) {
+        unsigned number;
+        char suffix[8];
+        if (sscanf(entry->d_name, "pack-%u.%7s", &number, suffix) != 2 || strcmp(suffix, "pack") != 0) continue;
+        if (number > newestPack) newestPack = number;
+        readIndex(packPath(number), [this](const string& hash, const PackLocation& location) {
+            objects.emplace(hash, location);
+            return true;
+        });
+    }
+    closedir(dir);
+    return true;
+}
+
+// ===== Writing =====
+bool PackStore::openPack() {
+    // Continue the newest pack if no other writer holds it and it has room
+    if (newestPack > 0) {
+        string path = packPath(newestPack);
+        int fd = open(path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+        struct stat st, indexSt;
+        if (fd >= 0 && lockForWriting(fd, path) && fstat(fd, &st) == 0 &&
+            (unsigned long long)st.st_size < settings.packSize) {
+            int index = open(indexPathFor(path).c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+            // An index that does not end on a record boundary is not appended to
+            if (index >= 0 && fstat(index, &indexSt) == 0 && indexSt.st_size >= (off_t)sizeof(INDEX_MAGIC) &&
+                (indexSt.st_size - sizeof(INDEX_MAGIC)) % sizeof(IndexRecord) == 0) {
+                packFd = fd;
+                indexFd = index;
+                currentPath = path;
+                currentSize = packWritten = st.st_size;
+                indexWritten = indexSt.st_size;
+                return true;
+            }
+            if (index >= 0) close(index);
+        }
+        if (fd >= 0) close(fd);
+    }
+
+    // Otherwise start a new one
+    for (int attempt = 0; attempt < 100; attempt++) {
+        string path = packPath(++newestPack);
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0 && errno == EEXIST) continue;   // another writer's
+        if (fd < 0) return false;
+        int index = open(indexPathFor(path).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (index < 0 || flock(fd, LOCK_EX) != 0 || !writeAll(fd, PACK_MAGIC, sizeof(PACK_MAGIC)) ||
+            !writeAll(index, INDEX_MAGIC, sizeof(INDEX_MAGIC))) {
+            if (index >= 0) close(index);
+            close(fd);
+            unlink(path.c_str());
+            unlink(indexPathFor(path).c_str());
+            return false;
+        }
+        packFd = fd;
+        indexFd = index;
+        currentPath = path;
+        currentSize = packWritten = sizeof(PACK_MAGIC);
+        indexWritten = sizeof(INDEX_MAGIC);
+        return true;
+    }
+    return false;
+}
+
+void PackStore::closePack() {
+    if (indexFd >= 0) close(indexFd);
+    if (packFd >= 0) close(packFd);   // releases the writer's lock
+    packFd = indexFd = -1;
+    currentPath.clear();
+    currentSize = packWritten = indexWritten = 0;
+}
+
+bool PackStore::add(const string& hash, const vector<char>& data, uint64_t size, Codec codec,
+                    uint32_t mode, const struct timespec& mtime, PackLocation& location) {
+    lock_guard<mutex> lock(packMutex);
+    load();
+    if (packFd < 0 && !openPack()) return false;
+
+    // We hold the pack's lock, so the offset is known before the write
+    location.pack = currentPath;
+    location.offset = currentSize;
+    location.storedSize = data.size();
+    location.size = size;
+    location.codec = codec;
+    location.mode = mode;
+    location.mtime = mtime;
+    buffer.append(data.data(), data.size());
+    currentSize += data.size();
+    pending.push_back({hash, location});
+    objects[hash] = location;
+
+    if (buffer.size() >= settings.flushBytes && !flushLocked()) return false;
+    if (currentSize >= settings.packSize) {
+        bool ok = flushLocked();
+        closePack();   // the next object starts a new pack
+        return ok;
+    }
+    return true;
+}
+
+bool PackStore::flush() {
+    lock_guard<mutex> lock(packMutex);
+    return flushLocked() && !writeFailed;
+}
+
+bool PackStore::flushLocked() {
+    if (pending.empty()) return true;
+
+    // Data first, then the records that point into it
+    string records = "";
+    records.reserve(pending.size() * sizeof(IndexRecord));
+    for (const auto& object : pending) {
+        IndexRecord record = toRecord(object.hash, object.location);
+        records.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    bool ok = writeAll(packFd, buffer.data(), buffer.size()) && writeAll(indexFd, records.data(), records.size());
+    buffer.clear();
+    if (ok) {
+        packWritten = currentSize;
+        indexWritten += records.size();
+        pending.clear();
+        return true;
+    }
+
+    // Cut both files back to what the last good flush left, so no record
+    // points past the data and the next one starts on a record boundary.
+    // The pack is given up either way; the next object opens one anew, and
+    // an index that could not be cut back is never appended to again.
+    ftruncate(packFd, packWritten);
+    ftruncate(indexFd, indexWritten);
+    for (const auto& object : pending) objects.erase(object.hash);
+    pending.clear();
+    writeFailed = true;
+    closePack();
+    return false;
+}
+
+bool PackStore::find(const string& hash, PackLocation& location) {
+    lock_guard<mutex> lock(packMutex);
+    load();
+    auto found = objects.find(hash);
+    if (found == objects.end()) return false;
+    // A pack deleted since it was loaded no longer holds anything
+    struct stat st;
+    if (found->second.pack != currentPath && stat(found->second.pack.c_str(), &st) != 0) {
+        objects.erase(found);
+        return false;
+    }
+    location = found->second;
+    return true;
+}
+
+// ===== Reading =====
+PackReader::PackReader(const string& pack) : packPath(pack) {
+    indexFd = open(indexPathFor(pack).c_str(), O_RDONLY | O_CLOEXEC);
+    if (indexFd < 0) {
+        openError = errno ? errno : ENOENT;
+        return;
+    }
+    readIndex(indexFd, pack, [this](const string& hash, const PackLocation& location) {
+        objects.emplace(hash, location);
+        return true;
+    });
+    packFd = open(pack.c_str(), O_RDONLY | O_CLOEXEC);
+    if (packFd < 0) openError = errno;
+    else posix_fadvise(packFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+PackReader::~PackReader() {
+    if (packFd >= 0) close(packFd);
+    if (indexFd >= 0) close(indexFd);
+}
+
+bool PackReader::read(const string& hash, vector<char>& raw, PackLocation& location) {
+    auto found = objects.find(hash);
+    if (packFd < 0 || found == objects.end()) {
+        errno = packFd < 0 ? openError : ENOENT;
+        return false;
+    }
+    location = found->second;
+    vector<char> stored(location.storedSize);
+    if (pread(packFd, stored.data(), stored.size(), location.offset) != (ssize_t)stored.size()) {
+        if (errno == 0) errno = EIO;
+        return false;
+    }
+    if (location.codec == Codec::None) {
+        raw.swap(stored);
+        return true;
+    }
+    raw.resize(location.size);
+    if (!Compressor::decompressBlock(location.codec, stored, raw)) {
+        errno = EINVAL;
+        return false;
+    }
+    return true;
+}
+
+CopyResult PackStore::restore(const string& pack, const string& hash, const string& dest) {
+    PackReader reader(pack);
+    return restore(reader, hash, dest);
+}
+
+CopyResult PackStore::restore(PackReader& reader, const string& hash, const string& dest) {
+    CopyResult result;
+    result.method = "pack";
+    auto start = chrono::steady_clock::now();
+
+    errno = 0;
+    vector<char> raw;
+    PackLocation location;
+    if (!reader.read(hash, raw, location)) {
+        result.error = errno ? errno : EIO;
+        return result;
+    }
+    int out = open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out < 0) {
+        result.error = errno;
+        return result;
+    }
+    bool ok = writeAll(out, raw.data(), raw.size());
+    if (ok) {
+        fchmod(out, location.mode & 07777);
+        struct timespec times[2] = {location.mtime, location.mtime};
+        futimens(out, times);
+    }
+    if (close(out) != 0) ok = false;
+    if (!ok) result.error = errno ? errno : EIO;
+
+    result.ok = ok;
+    result.bytes = ok ? raw.size() : 0;
+    result.files = ok ? 1 : 0;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+bool PackStore::removePack(const string& pack) {
+    int fd = open(pack.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) return errno == ENOENT;
+    bool removed = lockForWriting(fd, pack);   // a writer still holds it otherwise
+    if (removed) {
+        unlink(pack.c_str());
+        unlink(indexPathFor(pack).c_str());
+    }
+    close(fd);
+    return removed;
+}
+
+string PackStore::rewritePack(const string& pack, const unordered_set<string>& live, unsigned long long& saved) {
+    int fd = open(pack.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) return "";
+    if (!lockForWriting(fd, pack)) {   // a writer still appends to it
+        close(fd);
+        return "";
+    }
+    string indexPath = indexPathFor(pack);
+    struct stat packStat, indexStat;
+    vector<pair<string, PackLocation>> kept;
+    unordered_set<string> copied;
+    int index = open(indexPath.c_str(), O_RDONLY | O_CLOEXEC);
+    bool ok = index >= 0 && fstat(fd, &packStat) == 0 && fstat(index, &indexStat) == 0 &&
+              readIndex(index, pack, [&](const string& hash, const PackLocation& location) {
+                  if (live.count(hash) && copied.insert(hash).second) kept.emplace_back(hash, location);
+                  return true;
+              });
+    if (index >= 0) close(index);
+    ok = ok && !kept.empty();   // nothing live: the pack goes as a whole instead
+
+    // The live objects go to a pack of their own under the next free
+    // number, so a crash at any point leaves the old pair intact and at
+    // most an unreferenced new one for the sweep
+    string dir = pack.substr(0, pack.find_last_of('/'));
+    string target;
+    int packOut = -1;
+    uint32_t number = newestPackIn(dir);
+    for (int attempt = 0; ok && packOut < 0 && attempt < 100; attempt++) {
+        target = packPathIn(dir, ++number);
+        packOut = open(target.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (packOut < 0 && errno != EEXIST) break;
+    }
+    int indexOut = -1;
+    if (packOut >= 0) {
+        // Locked so no writer continues the new pack before it is complete
+        indexOut = open(indexPathFor(target).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        ok = flock(packOut, LOCK_EX | LOCK_NB) == 0 && indexOut >= 0 &&
+             writeAll(packOut, PACK_MAGIC, sizeof(PACK_MAGIC)) && writeAll(indexOut, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    } else {
+        ok = false;
+    }
+    uint64_t offset = sizeof(PACK_MAGIC);
+    string records;
+    vector<char> data;
+    for (size_t i = 0; ok && i < kept.size(); i++) {
+        PackLocation location = kept[i].second;
+        data.resize(location.storedSize);
+        ok = pread(fd, data.data(), data.size(), location.offset) == (ssize_t)data.size() &&
+             writeAll(packOut, data.data(), data.size());
+        location.offset = offset;
+        offset += data.size();
+        IndexRecord record = toRecord(kept[i].first, location);
+        records.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    ok = ok && writeAll(indexOut, records.data(), records.size()) && fsync(packOut) == 0 && fsync(indexOut) == 0;
+    if (indexOut >= 0) close(indexOut);
+    if (packOut >= 0) {
+        close(packOut);
+        if (!ok) {
+            unlink(target.c_str());
+            unlink(indexPathFor(target).c_str());
+        }
+    }
+    close(fd);
+    if (!ok) return "";
+
+    unsigned long long before = packStat.st_size + indexStat.st_size;
+    unsigned long long after = offset + sizeof(INDEX_MAGIC) + records.size();
+    saved = before > after ? before - after : 0;
+    return target;
+}
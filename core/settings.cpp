@@ -0,0 +1,70 @@
+#include "../include/settings.h"
+#include "../include/utils.h"
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+    string trim(const string& s) {
+        size_t start = s.find_first_not_of(" \t\r");
+        if (start == string::npos) return "";
+        size_t end = s.find_last_not_of(" \t\r");
+        return s.substr(start, end - start + 1);
+    }
+
+    string lowerCase(string s) {
+        transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return tolower(c); });
+        return s;
+    }
+}
+
+Settings::Settings(const string& file) : settingsFile(file) {}
+
+string Settings::defaultFile() {
+    return Utils::getHomeDir() + "/.spacematerc";
+}
+
+bool Settings::load() {
+    ifstream in(settingsFile);
+    if (!in.is_open()) return false;
+
+    values.clear();
+    string section, line;
+    while (getline(in, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+        if (line.front() == '[' && line.back() == ']') {
+            section = lowerCase(trim(line.substr(1, line.size() - 2)));
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == string::npos) continue;
+        string value = trim(line.substr(eq + 1));
+        size_t comment = value.find_first_of("#;");
+        if (comment != string::npos) value = trim(value.substr(0, comment));
+        values[section + "." + lowerCase(trim(line.substr(0, eq)))] = value;
+    }
+    return true;
+}
+
+string Settings::get(const string& section, const string& key, const string& fallback) const {
+    auto it = values.find(section + "." + key);
+    return it == values.end() ? fallback : it->second;
+}
+
+long long Settings::getInt(const string& section, const string& key, long long fallback) const {
+    string value = get(section, key);
+    if (value.empty()) return fallback;
+    char* end = nullptr;
+    long long number = strtoll(value.c_str(), &end, 10);
+    return *end == '\0' ? number : fallback;
+}
+
+bool Settings::getBool(const string& section, const string& key, bool fallback) const {
+    string value = lowerCase(get(section, key));
+    if (value == "true" || value == "yes" || value == "on" || value == "1") return true;
+    if (value == "false" || value == "no" || value == "off" || value == "0") return false;
+    return fallback;
+}
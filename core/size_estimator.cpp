@@ -0,0 +1,217 @@
+#include "../include/size_estimator.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+    const double Z95 = 1.96;
+    const uint32_t NO_PARENT = UINT32_MAX;
+    const size_t MAX_DEPTH = 4096;   // guards against pathological bind-mount loops
+
+    string joinPath(const string& dir, const string& name) {
+        if (!dir.empty() && dir.back() == '/') return dir + name;
+        return dir + "/" + name;
+    }
+
+    // Two-stage estimate of a directory: `k` of its `m` subdirectories have
+    // been sampled without replacement. With a single sample there is no
+    // spread to measure, so assume the worst (a 100% error).
+    void extrapolate(double direct, size_t m, size_t k, double sum, double sumSq, double sumVar,
+                     double& estimate, double& variance) {
+        double mean = sum / k;
+        double spread = k >= 2 ? max(0.0, (sumSq - k * mean * mean) / (k - 1)) : mean * mean;
+        double unsampled = 1.0 - double(k) / m;
+        estimate = direct + m * mean;
+        variance = double(m) * m * unsampled * spread / k + double(m) / k * sumVar;
+    }
+}
+
+SizeEstimator::SizeEstimator(const string& root, unsigned int seed)
+    : rootPath(root), rng(seed) {
+    listDirectory(NO_PARENT, rootPath, rootPath);
+}
+
+// ===== Directory listings =====
+uint32_t SizeEstimator::listDirectory(uint32_t parent, const string& path, const string& name) {
+    Node node;
+    node.parent = parent;
+    node.name = name;
+
+    DIR* dir = opendir(path.c_str());
+    if (dir) {
+        int fd = dirfd(dir);
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            const char* entryName = entry->d_name;
+            if (strcmp(entryName, ".") == 0 || strcmp(entryName, "..") == 0) continue;
+
+            struct stat st;
+            if (fstatat(fd, entryName, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+
+            if (S_ISDIR(st.st_mode)) {
+                node.subdirs.push_back(entryName);
+            } else if (S_ISREG(st.st_mode)) {
+                node.directBytes += st.st_size;
+                node.directFiles++;
+            }
+        }
+        closedir(dir);
+    }
+    // Listing order is the sampling order
+    shuffle(node.subdirs.begin(), node.subdirs.end(), rng);
+
+    uint32_t id = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(move(node));
+    recompute(id);
+    return id;
+}
+
+void SizeEstimator::recompute(uint32_t id) {
+    Node& n = nodes[id];
+    size_t m = n.subdirs.size();
+    size_t k = n.children.size();
+
+    if (k == 0) {
+        n.bytes = n.directBytes;
+        n.files = n.directFiles;
+        n.bytesVar = n.filesVar = 0;
+        n.dirs = 1 + m;
+        n.listed = 1;
+        n.complete = (m == 0);
+        return;
+    }
+
+    double bSum = 0, bSq = 0, bVar = 0, fSum = 0, fSq = 0, fVar = 0, dSum = 0, lSum = 0;
+    bool allComplete = true;
+    for (uint32_t c : n.children) {
+        const Node& child = nodes[c];
+        bSum += child.bytes;  bSq += child.bytes * child.bytes;  bVar += child.bytesVar;
+        fSum += child.files;  fSq += child.files * child.files;  fVar += child.filesVar;
+        dSum += child.dirs;
+        lSum += child.listed;
+        allComplete = allComplete && child.complete;
+    }
+    extrapolate(n.directBytes, m, k, bSum, bSq, bVar, n.bytes, n.bytesVar);
+    extrapolate(n.directFiles, m, k, fSum, fSq, fVar, n.files, n.filesVar);
+    n.dirs = 1 + dSum * m / k;
+    n.listed = 1 + lSum;
+    n.complete = (k == m) && allComplete;
+}
+
+// ===== Sampling =====
+void SizeEstimator::probe() {
+    if (complete()) return;
+
+    uint32_t current = 0;
+    string path = rootPath;
+    for (size_t depth = 0; depth < MAX_DEPTH; depth++) {
+        Node& n = nodes[current];
+        n.probes++;
+        if (n.subdirs.empty()) break;
+
+        size_t k = n.children.size();
+        if (k < n.subdirs.size()) {
+            // Widen the sample before refining: list the next sibling
+            string name = n.subdirs[k];
+            path = joinPath(path, name);
+            uint32_t child = listDirectory(current, path, name);
+            nodes[current].children.push_back(child);
+            current = child;
+            continue;
+        }
+
+        // Fully listed: descend where the most directories remain unlisted
+        double remaining = 0;
+        for (uint32_t c : n.children) {
+            const Node& child = nodes[c];
+            if (!child.complete) remaining += max(1.0, child.dirs - child.listed);
+        }
+        if (remaining <= 0) break;
+
+        uint32_t pick = NO_PARENT;
+        double target = uniform_real_distribution<double>(0.0, remaining)(rng);
+        for (uint32_t c : n.children) {
+            const Node& child = nodes[c];
+            if (child.complete) continue;
+            pick = c;
+            target -= max(1.0, child.dirs - child.listed);
+            if (target < 0) break;
+        }
+        path = joinPath(path, nodes[pick].name);
+        current = pick;
+    }
+
+    for (uint32_t id = current; id != NO_PARENT; id = nodes[id].parent) {
+        recompute(id);
+    }
+    totalProbes++;
+}
+
+bool SizeEstimator::complete() const {
+    return nodes[0].complete;
+}
+
+SizeEstimate SizeEstimator::current() const {
+    const Node& root = nodes[0];
+    SizeEstimate est;
+    double bMargin = Z95 * sqrt(root.bytesVar);
+    double fMargin = Z95 * sqrt(root.filesVar);
+    est.bytes = root.bytes;
+    est.bytesLow = max(root.directBytes, est.bytes - bMargin);
+    est.bytesHigh = est.bytes + bMargin;
+    est.files = root.files;
+    est.filesLow = max(root.directFiles, est.files - fMargin);
+    est.filesHigh = est.files + fMargin;
+    est.probes = totalProbes;
+    est.directoriesRead = nodes.size();
+    est.elapsedSeconds = elapsed;
+
+    for (uint32_t c : root.children) {
+        const Node& child = nodes[c];
+        EstimatedChild entry;
+        entry.name = child.name;
+        entry.bytes = child.bytes;
+        entry.bytesMargin = Z95 * sqrt(child.bytesVar);
+        entry.files = child.files;
+        entry.probes = child.probes;
+        est.children.push_back(entry);
+    }
+    sort(est.children.begin(), est.children.end(),
+         [](const EstimatedChild& a, const EstimatedChild& b) { return a.bytes > b.bytes; });
+    return est;
+}
+
+SizeEstimate SizeEstimator::run(double seconds, double targetRelativeError,
+                                const function<bool(const SizeEstimate&)>& progress) {
+    using clock = chrono::steady_clock;
+    auto start = clock::now();
+    auto lastReport = start;
+    double startElapsed = elapsed;
+
+    while (!complete()) {
+        probe();
+        auto now = clock::now();
+        elapsed = startElapsed + chrono::duration<double>(now - start).count();
+
+        // Size distributions are heavy-tailed: a rare huge subtree can hide
+        // for a while, so never trust the interval before every top-level
+        // directory has been seen and a quarter of the budget is spent.
+        const Node& root = nodes[0];
+        bool warmedUp = root.children.size() == root.subdirs.size()
+                        && elapsed - startElapsed >= seconds / 4;
+        if (warmedUp && totalProbes % 16 == 0 && current().relativeError() <= targetRelativeError) break;
+        if (elapsed - startElapsed >= seconds) break;
+
+        if (progress && now - lastReport >= chrono::milliseconds(250)) {
+            lastReport = now;
+            if (!progress(current())) break;
+        }
+    }
+    return current();
+}
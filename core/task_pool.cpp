@@ -0,0 +1,57 @@
+#include "../include/task_pool.h"
+#include <algorithm>
+
+using namespace std;
+
+TaskPool::TaskPool(size_t threads, size_t maxQueued)
+    : capacity(maxQueued ? maxQueued : 2 * max<size_t>(threads, 1)) {
+    threads = max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; i++) workers.emplace_back(&TaskPool::run, this);
+}
+
+TaskPool::~TaskPool() {
+    wait();
+    {
+        lock_guard<mutex> lock(poolMutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+size_t TaskPool::defaultThreads() {
+    return min<size_t>(8, max<size_t>(2, thread::hardware_concurrency()));
+}
+
+void TaskPool::submit(function<void()> task) {
+    unique_lock<mutex> lock(poolMutex);
+    space.wait(lock, [this] { return queue.size() < capacity; });
+    queue.push_back(move(task));
+    lock.unlock();
+    available.notify_one();
+}
+
+void TaskPool::wait() {
+    unique_lock<mutex> lock(poolMutex);
+    idle.wait(lock, [this] { return queue.empty() && running == 0; });
+}
+
+void TaskPool::run() {
+    unique_lock<mutex> lock(poolMutex);
+    while (true) {
+        available.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) return;   // stopping, and nothing left to do
+
+        function<void()> task = move(queue.front());
+        queue.pop_front();
+        running++;
+        lock.unlock();
+        space.notify_one();
+
+        task();
+
+        lock.lock();
+        running--;
+        if (queue.empty() && running == 0) idle.notify_all();
+    }
+}
@@ -5,7 +5,12 @@
 #include <unistd.h>
 #include <ctime>
 #include <pwd.h>
+#include <grp.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include <cstdlib>  // for getenv
+#include <cstdio>
 
 using namespace std;
 
@@ -28,6 +33,83 @@ string formatSize(unsigned long long bytes) {
     return oss.str();
 }
 
+string formatDuration(double seconds) {
+    if (seconds < 0) return "never";
+    unsigned long long total = (unsigned long long)seconds;
+    unsigned long long days = total / 86400, hours = (total % 86400) / 3600, minutes = (total % 3600) / 60;
+
+    ostringstream oss;
+    if (days > 0) oss << days << "d " << hours << "h";
+    else if (hours > 0) oss << hours << "h " << minutes << "m";
+    else if (minutes > 0) oss << minutes << "m";
+    else oss << total << "s";
+    return oss.str();
+}
+
+bool parseDuration(const string& spec, time_t& seconds) {
+    if (spec.empty()) return false;
+    char* end = nullptr;
+    double amount = strtod(spec.c_str(), &end);
+    if (end == spec.c_str() || amount < 0) return false;
+
+    string unit(end);
+    double scale = unit.empty() || unit == "s" ? 1 : unit == "m" ? 60 : unit == "h" ? 3600 :
+                   unit == "d" ? 86400 : unit == "w" ? 7 * 86400 : 0;
+    if (scale == 0) return false;
+    seconds = (time_t)(amount * scale);
+    return true;
+}
+
+bool parseSize(const string& spec, unsigned long long& bytes) {
+    if (spec.empty()) return false;
+    char* end = nullptr;
+    double amount = strtod(spec.c_str(), &end);
+    if (end == spec.c_str() || amount < 0) return false;
+
+    string unit(end);
+    if (!unit.empty() && (unit.back() == 'B' || unit.back() == 'b')) unit.pop_back();
+    double scale = unit.empty() ? 1 : unit == "K" || unit == "k" ? 1024.0 : unit == "M" ? 1024.0 * 1024 :
+                   unit == "G" ? 1024.0 * 1024 * 1024 : unit == "T" ? 1024.0 * 1024 * 1024 * 1024 : 0;
+    if (scale == 0) return false;
+    bytes = (unsigned long long)(amount * scale);
+    return true;
+}
+
+bool parseTime(const string& spec, time_t& result) {
+    time_t now = time(nullptr);
+    if (spec.empty()) return false;
+    if (spec == "now") { result = now; return true; }
+
+    // Relative: -90m, -2h, -3d, -1w
+    if (spec[0] == '-') {
+        time_t ago;
+        if (!parseDuration(spec.substr(1), ago) || ago == 0) return false;
+        result = now - ago;
+        return true;
+    }
+
+    // Seconds since the epoch
+    if (spec.find_first_not_of("0123456789") == string::npos) {
+        result = (time_t)atoll(spec.c_str());
+        return true;
+    }
+
+    // Local time: YYYY-MM-DD, optionally followed by HH:MM[:SS]
+    struct tm tm = {};
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    int fields = sscanf(spec.c_str(), "%d-%d-%d%*[ T]%d:%d:%d", &year, &month, &day, &hour, &minute, &second);
+    if (fields != 3 && fields < 5) return false;
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+    tm.tm_isdst = -1;
+    result = mktime(&tm);
+    return result != (time_t)-1;
+}
+
 string getCurrentTimestamp() {
     time_t now = time(nullptr);
     char buf[80];
@@ -35,6 +117,21 @@ string getCurrentTimestamp() {
     return string(buf);
 }
 
+bool parseTimestamp(const string& stamp, time_t& result) {
+    struct tm tm = {};
+    int year, month, day, hour, minute, second;
+    if (sscanf(stamp.c_str(), "%d-%d-%d_%d-%d-%d", &year, &month, &day, &hour, &minute, &second) != 6) return false;
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+    tm.tm_isdst = -1;
+    result = mktime(&tm);
+    return result != (time_t)-1;
+}
+
 bool fileExists(const string& path) {
     struct stat st;
     return stat(path.c_str(), &st) == 0;
@@ -92,4 +189,58 @@ string getCacheDir() {
 #endif
 }
 
+string jsonEscape(const string& text) {
+    ostringstream oss;
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"':  oss << "\\\""; break;
+            case '\\': oss << "\\\\"; break;
+            case '\n': oss << "\\n"; break;
+            case '\t': oss << "\\t"; break;
+            default:
+                if (c < 0x20) oss << "\\u" << hex << setw(4) << setfill('0') << (int)c << dec;
+                else oss << c;
+        }
+    }
+    return oss.str();
+}
+
+string userName(uid_t uid) {
+    static mutex cacheMutex;
+    static unordered_map<uid_t, string> cache;
+
+    lock_guard<mutex> lock(cacheMutex);
+    auto it = cache.find(uid);
+    if (it != cache.end()) return it->second;
+
+    struct passwd pw;
+    struct passwd* result = nullptr;
+    vector<char> buf(16384);
+    string name = to_string(uid);
+    if (getpwuid_r(uid, &pw, buf.data(), buf.size(), &result) == 0 && result) {
+        name = result->pw_name;
+    }
+    cache.emplace(uid, name);
+    return name;
+}
+
+string groupName(gid_t gid) {
+    static mutex cacheMutex;
+    static unordered_map<gid_t, string> cache;
+
+    lock_guard<mutex> lock(cacheMutex);
+    auto it = cache.find(gid);
+    if (it != cache.end()) return it->second;
+
+    struct group gr;
+    struct group* result = nullptr;
+    vector<char> buf(16384);
+    string name = to_string(gid);
+    if (getgrgid_r(gid, &gr, buf.data(), buf.size(), &result) == 0 && result) {
+        name = result->gr_name;
+    }
+    cache.emplace(gid, name);
+    return name;
+}
+
 }  // namespace Utils
@@ -0,0 +1,124 @@
+#include "dir_tree_model.h"
+#include "../include/utils.h"
+#include <QDateTime>
+#include <QBrush>
+#include <QColor>
+#include <algorithm>
+
+DirTreeModel::DirTreeModel(QObject *parent)
+    : QAbstractItemModel(parent) {}
+
+void DirTreeModel::setTree(DirTreePtr tree) {
+    beginResetModel();
+    dirTree = std::move(tree);
+    childCache.clear();
+    rowInParent.clear();
+    if (dirTree) rowInParent[dirTree->root()] = 0;
+    endResetModel();
+}
+
+NodeId DirTreeModel::nodeFor(const QModelIndex &index) const {
+    if (!dirTree || !index.isValid()) return NO_NODE;
+    return static_cast<NodeId>(index.internalId());
+}
+
+const std::vector<NodeId> &DirTreeModel::childrenOf(NodeId id) const {
+    auto it = childCache.find(id);
+    if (it != childCache.end()) return it->second;
+
+    std::vector<NodeId> kids = dirTree->children(id);
+    std::sort(kids.begin(), kids.end(), [this](NodeId a, NodeId b) {
+        return dirTree->node(a).bytes > dirTree->node(b).bytes;
+    });
+    for (size_t row = 0; row < kids.size(); ++row) {
+        rowInParent[kids[row]] = static_cast<int>(row);
+    }
+    return childCache.emplace(id, std::move(kids)).first->second;
+}
+
+QModelIndex DirTreeModel::index(int row, int column, const QModelIndex &parent) const {
+    if (!dirTree || row < 0 || column < 0 || column >= ColumnCount) return QModelIndex();
+
+    // The scanned root is the single top-level item
+    if (!parent.isValid()) {
+        return row == 0 ? createIndex(row, column, static_cast<quintptr>(dirTree->root())) : QModelIndex();
+    }
+
+    const auto &kids = childrenOf(nodeFor(parent));
+    if (row >= static_cast<int>(kids.size())) return QModelIndex();
+    return createIndex(row, column, static_cast<quintptr>(kids[row]));
+}
+
+QModelIndex DirTreeModel::parent(const QModelIndex &child) const {
+    NodeId id = nodeFor(child);
+    if (id == NO_NODE || id == dirTree->root()) return QModelIndex();
+
+    NodeId parentId = dirTree->node(id).parent;
+    auto it = rowInParent.find(parentId);
+    int row = it != rowInParent.end() ? it->second : 0;
+    return createIndex(row, 0, static_cast<quintptr>(parentId));
+}
+
+int DirTreeModel::rowCount(const QModelIndex &parent) const {
+    if (!dirTree) return 0;
+    if (!parent.isValid()) return 1;
+    if (parent.column() > 0) return 0;
+    return static_cast<int>(dirTree->node(nodeFor(parent)).childCount);
+}
+
+int DirTreeModel::columnCount(const QModelIndex &) const {
+    return ColumnCount;
+}
+
+bool DirTreeModel::hasChildren(const QModelIndex &parent) const {
+    if (!dirTree) return false;
+    if (!parent.isValid()) return true;
+    return dirTree->node(nodeFor(parent)).childCount > 0;
+}
+
+QVariant DirTreeModel::data(const QModelIndex &index, int role) const {
+    NodeId id = nodeFor(index);
+    if (id == NO_NODE) return QVariant();
+    const DirNode &node = dirTree->node(id);
+
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+        case NameColumn:
+            return QString::fromStdString(dirTree->name(id));
+        case SizeColumn:
+            return QString::fromStdString(Utils::formatSize(node.bytes));
+        case FilesColumn:
+            return QString::number(node.files);
+        case ModifiedColumn:
+            return node.maxMtime > 0
+                ? QDateTime::fromSecsSinceEpoch(node.maxMtime).toString("yyyy-MM-dd hh:mm:ss")
+                : QString("-");
+        case ShareColumn: {
+            if (node.parent == NO_NODE) return QString("100.0%");
+            unsigned long long parentBytes = dirTree->node(node.parent).bytes;
+            double share = parentBytes ? node.bytes * 100.0 / parentBytes : 0.0;
+            return QString("%1%").arg(share, 0, 'f', 1);
+        }
+        }
+    } else if (role == Qt::ToolTipRole) {
+        return QString::fromStdString(dirTree->path(id));
+    } else if (role == Qt::TextAlignmentRole && index.column() != NameColumn) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    } else if (role == Qt::BackgroundRole && index.column() == ShareColumn && node.parent != NO_NODE) {
+        unsigned long long parentBytes = dirTree->node(node.parent).bytes;
+        if (parentBytes && node.bytes * 2 > parentBytes) return QBrush(QColor(254, 226, 226));
+    }
+    return QVariant();
+}
+
+QVariant DirTreeModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    switch (section) {
+    case NameColumn:     return "Directory";
+    case SizeColumn:     return "Size";
+    case FilesColumn:    return "Files";
+    case ModifiedColumn: return "Last Modified";
+    case ShareColumn:    return "% of Parent";
+    }
+    return QVariant();
+}
@@ -0,0 +1,43 @@
+#ifndef DIR_TREE_MODEL_H
+#define DIR_TREE_MODEL_H
+
+#include <QAbstractItemModel>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "../include/dir_tree.h"
+
+using DirTreePtr = std::shared_ptr<const DirTree>;
+
+// Read-only item model over an aggregated DirTree. Children of a node are
+// materialised (and sorted by size) only the first time the view asks for
+// them, so expanding a node costs O(children) and never touches the disk.
+class DirTreeModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    enum Column { NameColumn, SizeColumn, FilesColumn, ModifiedColumn, ShareColumn, ColumnCount };
+
+    explicit DirTreeModel(QObject *parent = nullptr);
+
+    void setTree(DirTreePtr tree);
+    DirTreePtr tree() const { return dirTree; }
+    NodeId nodeFor(const QModelIndex &index) const;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    const std::vector<NodeId> &childrenOf(NodeId id) const;
+
+    DirTreePtr dirTree;
+    mutable std::unordered_map<NodeId, std::vector<NodeId>> childCache;
+    mutable std::unordered_map<NodeId, int> rowInParent;
+};
+
+#endif // DIR_TREE_MODEL_H
@@ -1,8 +1,11 @@
 #include "mainwindow.h"
 #include <QApplication>
 #include <QMetaType>
+#include <QElapsedTimer>
 
 int main(int argc, char *argv[]) {
+    QElapsedTimer launched;
+    launched.start();
     QApplication app(argc, argv);
     
     // Register custom types for Qt signal/slot system
@@ -11,7 +14,7 @@ int main(int argc, char *argv[]) {
     // Set application style
     app.setStyle("Fusion");
     
-    MainWindow window;
+    MainWindow window(nullptr, launched);
     window.show();
     
     return app.exec();
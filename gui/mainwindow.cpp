@@ -1,5 +1,7 @@
 
 #include "mainwindow.h"
+#include "../include/utils.h"
+#include "../include/backup_session.h"
 #include <QMessageBox>
 #include <QHeaderView>
 #include <QDateTime>
@@ -10,7 +12,6 @@
 #include <QTimer>
 #include <QtConcurrent>
 #include <QProgressDialog>
-#include <QStorageInfo>
 #include <QCheckBox>
 #include <QDir>
 #include <QVBoxLayout>
@@ -19,8 +20,12 @@
 #include <QGroupBox>
 #include <QCryptographicHash>
 #include <unordered_map>
+#include <unordered_set>
 #include <QSet>
 #include <QTextStream>
+#include <QFile>
+#include <QMenu>
+#include <QMenuBar>
 #include <QIODevice>
 
 namespace fs = std::filesystem;
@@ -34,14 +39,36 @@ void ScanWorker::run() {
         emit scanProgress(0);
         ScanResults results;
         std::map<QString, std::vector<FileDetail>> hashToFiles;
+        TypeAggregator typeTotals;
+        ExtensionTable &extensions = ExtensionTable::instance();
         
         int fileCount = 0;
         long long totalSize = 0;
         QDateTime now = QDateTime::currentDateTime();
         QDateTime oldThreshold = now.addDays(-90);
 
-        for (const auto &entry : fs::recursive_directory_iterator(scanPath, 
-                                   fs::directory_options::skip_permission_denied)) {
+        // Aggregated directory tree, built in the same pass as the file list.
+        // dirStack[d] is the node of the directory that owns entries at depth d.
+        auto tree = std::make_shared<DirTree>(scanPath);
+        std::vector<NodeId> dirStack{tree->root()};
+
+        for (auto it = fs::recursive_directory_iterator(scanPath,
+                           fs::directory_options::skip_permission_denied);
+             it != fs::recursive_directory_iterator(); ++it) {
+            const auto &entry = *it;
+            size_t depth = static_cast<size_t>(it.depth());
+            NodeId owner = dirStack[depth];
+
+            if (entry.is_directory() && !entry.is_symlink()) {
+                dirStack.resize(depth + 1);
+                dirStack.push_back(tree->addDirectory(owner, entry.path().filename().string()));
+                continue;
+            }
+            if (!entry.is_regular_file()) {
+                tree->addEntry(owner);   // still an inode, so it counts towards entry hotspots
+                continue;
+            }
+
             if (entry.is_regular_file()) {
                 try {
                     FileDetail detail;
@@ -56,10 +83,13 @@ void ScanWorker::run() {
                     detail.lastModified = QDateTime::fromSecsSinceEpoch(
                         std::chrono::system_clock::to_time_t(sctp)).toString("yyyy-MM-dd hh:mm:ss");
                     
-                    detail.type = QString::fromStdString(entry.path().extension().string());
+                    std::string extension = entry.path().extension().string();
+                    detail.type = QString::fromStdString(extension);
+                    typeTotals.add(extensions.intern(extension), detail.size);
                     detail.isDuplicate = false;
                     detail.isOld = QDateTime::fromSecsSinceEpoch(
                         std::chrono::system_clock::to_time_t(sctp)) < oldThreshold;
+                    tree->addFile(owner, detail.size, std::chrono::system_clock::to_time_t(sctp));
                     
                     // Calculate file hash for duplicate detection
                     if (detail.size > 1024) {
@@ -101,7 +131,11 @@ void ScanWorker::run() {
             }
         }
 
+        tree->finalize();
+
         emit scanProgress(100);
+        emit dirTreeReady(tree);
+        emit typeBreakdownReady(typeTotals.finish());
         emit scanComplete(results, duplicateGroups);
     } catch (const std::exception &e) {
         emit scanError(QString::fromStdString(e.what()));
@@ -109,84 +143,120 @@ void ScanWorker::run() {
 }
 
 // ==================== MainWindow ====================
-MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), isMonitoring(false), isScanning(false), scanWorker(nullptr), lastScannedPath("/")
+MainWindow::MainWindow(QWidget *parent, const QElapsedTimer &launched)
+    : QMainWindow(parent), startupClock(launched), isMonitoring(false), isScanning(false), scanWorker(nullptr), lastScannedPath("/")
 {
+    if (!startupClock.isValid()) startupClock.start();
     qRegisterMetaType<FileDetail>();
     qRegisterMetaType<ScanResults>();
     qRegisterMetaType<DuplicateGroups>();
+    qRegisterMetaType<TypeBreakdown>();
+    qRegisterMetaType<DirTreePtr>();
 
-    backupManager = std::make_unique<BackupManager>();
-    cleanupManager = std::make_unique<CleanupManager>();
-    diskMonitor = std::make_unique<DiskMonitor>();
-    fileAnalyzer = std::make_unique<FileAnalyzer>();
-
+    // Backend managers and all tabs but the dashboard are created on first use
     setupUI();
     setupConnections();
-    
-    // Delay initial update to ensure UI is ready
-    QTimer::singleShot(1000, this, [this]() {
-    addLog("=== DELAYED INITIAL DISK INFO UPDATE ===", "INFO");
-    updateDiskInfo();
-});
 
     setWindowTitle("Spacemate - Disk Space Manager");
     resize(1200, 800);
 }
 
-void MainWindow::setupConnections() {
-    connect(startScanBtn, &QPushButton::clicked, this, &MainWindow::startScan);
-    connect(browseScanBtn, &QPushButton::clicked, this, &MainWindow::selectScanPath);
-    connect(cleanTempBtn, &QPushButton::clicked, this, &MainWindow::cleanTempFiles);
-    connect(cleanCacheBtn, &QPushButton::clicked, this, &MainWindow::cleanCache);
-    connect(customCleanBtn, &QPushButton::clicked, this, [this]() {
-        // Select all checkboxes in the cleanup table
-        int selectedCount = 0;
-        for (int i = 0; i < cleanupTable->rowCount(); ++i) {
-            QWidget *widget = cleanupTable->cellWidget(i, 3);
-            if (widget) {
-                QCheckBox *checkbox = widget->findChild<QCheckBox*>();
-                if (checkbox) {
-                    checkbox->setChecked(true);
-                    selectedCount++;
-                }
-            }
-        }
-        if (selectedCount > 0) {
-            addLog(QString("Selected %1 duplicate/old files for cleanup").arg(selectedCount), "INFO");
-            QMessageBox::information(this, "Files Selected", 
-                QString("Selected %1 files for cleanup.\nClick 'Perform Cleanup' to remove them.").arg(selectedCount));
-        } else {
-            QMessageBox::information(this, "No Files", 
-                "No duplicate or old files found.\nScan a folder in the File Analyzer tab first.");
-        }
-    });
-    connect(cleanupBtn, &QPushButton::clicked, this, &MainWindow::performCleanup);
-    connect(browseSourceBtn, &QPushButton::clicked, this, &MainWindow::selectBackupSource);
-    connect(browseDestBtn, &QPushButton::clicked, this, &MainWindow::selectBackupDestination);
-    connect(createBackupBtn, &QPushButton::clicked, this, &MainWindow::createBackup);
-    connect(monitorBtn, &QPushButton::clicked, this, &MainWindow::toggleMonitoring);
-
-    QTimer *monitorTimer = new QTimer(this);
-    connect(monitorTimer, &QTimer::timeout, this, [this]() {
-        if (isMonitoring) {
+// ===== Startup =====
+// First paint: the window's first Paint event. Interactive: the dashboard
+// has its data and the event loop is idle again, one queued call later.
+bool MainWindow::event(QEvent *e) {
+    if (e->type() == QEvent::Paint && firstPaintMs < 0) {
+        firstPaintMs = startupClock.elapsed();
+        QTimer::singleShot(0, this, [this]() {
             updateDiskInfo();
-            updateMonitoringStats();
-        }
-    });
-    monitorTimer->start(5000);
+            QTimer::singleShot(0, this, &MainWindow::recordStartup);
+        });
+    }
+    return QMainWindow::event(e);
+}
+
+void MainWindow::recordStartup() {
+    interactiveMs = startupClock.elapsed();
+    addLog(QString("Startup: first paint %1 ms, interactive %2 ms").arg(firstPaintMs).arg(interactiveMs), "INFO");
+
+    // One line per launch so regressions show up over time
+    QString dir = QString::fromStdString(Utils::getHomeDir()) + "/.spacemate";
+    QDir().mkpath(dir);
+    QFile file(dir + "/startup_times.txt");
+    if (file.open(QIODevice::Append | QIODevice::Text)) {
+        QTextStream(&file) << QDateTime::currentSecsSinceEpoch() << "|" << firstPaintMs << "|" << interactiveMs << "\n";
+    }
+}
+
+BackupManager &MainWindow::getBackupManager() {
+    if (!backupManager) backupManager = std::make_unique<BackupManager>();
+    return *backupManager;
+}
+
+CleanupManager &MainWindow::getCleanupManager() {
+    if (!cleanupManager) cleanupManager = std::make_unique<CleanupManager>();
+    return *cleanupManager;
+}
 
+DiskMonitor &MainWindow::getDiskMonitor() {
+    if (diskMonitor) return *diskMonitor;
+    diskMonitor = std::make_unique<DiskMonitor>();
+    if (!diskMonitor->alertEngine().loadConfig(AlertEngine::defaultConfigFile())) {
+        diskMonitor->alertEngine().loadDefaults();
+    }
+    monitorBridge = std::make_unique<MonitorBridge>(*diskMonitor);
+
+    // The monitor thread only reports samples that changed
+    connect(monitorBridge.get(), &MonitorBridge::sampleReady, this, &MainWindow::onMonitorSample);
+    connect(monitorBridge.get(), &MonitorBridge::alertRaised, this, &MainWindow::onMonitorAlert);
+    connect(monitorBridge.get(), &MonitorBridge::growthFound, this, &MainWindow::onMonitorGrowth);
+    connect(monitorBridge.get(), &MonitorBridge::folderStatsReady, this, &MainWindow::onFolderStats);
+    return *diskMonitor;
+}
+
+void MainWindow::setupConnections() {
+    // Each tab connects its own widgets when it is built
     connect(tabWidget, &QTabWidget::currentChanged, this, [this](int index) {
-        if (index == 0) {
+        ensureTab(index);
+        if (index == DashboardTab) {
             updateDiskInfo();
             updateBackupTable();
         }
     });
+    connect(&gcWatcher, &QFutureWatcher<GcReport>::finished, this, &MainWindow::onGcFinished);
+    connect(&restoreWatcher, &QFutureWatcher<RestoreReport>::finished, this, &MainWindow::onRestoreFinished);
 
-    updateBackupTable();
+    QMenu *debugMenu = menuBar()->addMenu("Debug");
+    debugMenu->addAction("Log Volume Diagnostics", this, &MainWindow::logVolumeDiagnostics);
+    debugMenu->addAction("Log Startup Time", this, [this]() {
+        addLog(QString("Startup: first paint %1 ms, interactive %2 ms").arg(firstPaintMs).arg(interactiveMs), "INFO");
+    });
+}
+
+// Builds a tab's widgets into its placeholder page the first time it is needed
+void MainWindow::ensureTab(int index) {
+    if (index < 0 || index >= TabCount || tabBuilt[index]) return;
+    tabBuilt[index] = true;
+    switch (index) {
+    case DashboardTab: createDashboardTab(); break;
+    case AnalyzerTab:  createAnalyzerTab(); break;
+    case CleanupTab:   createCleanupTab(); break;
+    case BackupTab:    createBackupTab(); updateBackupTable(); break;
+    case MonitorTab:   createMonitorTab(); break;
+    case ExplorerTab:  createExplorerTab(); applyDirTree(); break;
+    case TreemapTab:   createTreemapTab(); applyDirTree(); break;
+    }
 }
 
 MainWindow::~MainWindow() {
+    if (diskMonitor) {
+        diskMonitor->stopMonitoring();   // no callbacks into the bridge from here on
+        diskMonitor->stopFolderStats();
+    }
+    if (estimateWatcher.isRunning()) {
+        *estimateCancel = true;
+        estimateWatcher.waitForFinished();
+    }
     if (scanWorker && scanWorker->isRunning()) {
         scanWorker->terminate();
         scanWorker->wait();
@@ -208,11 +278,15 @@ void MainWindow::setupUI() {
     tabWidget = new QTabWidget();
     mainLayout->addWidget(tabWidget);
 
-    createDashboardTab();
-    createAnalyzerTab();
-    createCleanupTab();
-    createBackupTab();
-    createMonitorTab();
+    const char *titles[TabCount] = {"Dashboard", "File Analyzer", "Cleanup", "Backup", "Monitor", "Explorer", "Treemap"};
+    for (int i = 0; i < TabCount; ++i) {
+        QWidget *page = new QWidget();
+        QVBoxLayout *pageLayout = new QVBoxLayout(page);
+        pageLayout->setContentsMargins(0, 0, 0, 0);
+        tabPages[i] = page;
+        tabWidget->addTab(page, titles[i]);
+    }
+    ensureTab(DashboardTab);
 
     QGroupBox *logGroup = new QGroupBox("Activity Log");
     QVBoxLayout *logLayout = new QVBoxLayout();
@@ -300,9 +374,9 @@ void MainWindow::createDashboardTab() {
     backupBtn->setMinimumHeight(40);
 
     connect(refreshBtn, &QPushButton::clicked, this, &MainWindow::refreshDashboard);
-    connect(analyzeBtn, &QPushButton::clicked, [this]() { tabWidget->setCurrentIndex(1); });
-    connect(cleanupBtn, &QPushButton::clicked, [this]() { tabWidget->setCurrentIndex(2); });
-    connect(backupBtn, &QPushButton::clicked, [this]() { tabWidget->setCurrentIndex(3); });
+    connect(analyzeBtn, &QPushButton::clicked, [this]() { tabWidget->setCurrentIndex(AnalyzerTab); });
+    connect(cleanupBtn, &QPushButton::clicked, [this]() { tabWidget->setCurrentIndex(CleanupTab); });
+    connect(backupBtn, &QPushButton::clicked, [this]() { tabWidget->setCurrentIndex(BackupTab); });
 
     actionsLayout->addWidget(refreshBtn, 0, 0);
     actionsLayout->addWidget(analyzeBtn, 0, 1);
@@ -310,11 +384,33 @@ void MainWindow::createDashboardTab() {
     actionsLayout->addWidget(backupBtn, 1, 1);
     actionsGroup->setLayout(actionsLayout);
 
+    QGroupBox *estimateGroup = new QGroupBox("Quick Size Estimate");
+    QVBoxLayout *estimateLayout = new QVBoxLayout();
+    QHBoxLayout *estimateInputLayout = new QHBoxLayout();
+
+    estimatePathInput = new QLineEdit(QDir::homePath());
+    estimateBtn = new QPushButton("Estimate");
+    estimateBtn->setMinimumHeight(30);
+    connect(estimateBtn, &QPushButton::clicked, this, &MainWindow::toggleEstimate);
+    connect(&estimateWatcher, &QFutureWatcher<SizeEstimate>::finished, this, &MainWindow::onEstimateFinished);
+
+    estimateInputLayout->addWidget(estimatePathInput);
+    estimateInputLayout->addWidget(estimateBtn);
+
+    estimateLabel = new QLabel("Samples the tree instead of walking it - a ±5% answer in seconds.");
+    estimateLabel->setStyleSheet("padding: 10px; font-family: monospace;");
+    estimateLabel->setWordWrap(true);
+
+    estimateLayout->addLayout(estimateInputLayout);
+    estimateLayout->addWidget(estimateLabel);
+    estimateGroup->setLayout(estimateLayout);
+
     layout->addWidget(storageGroup);
     layout->addWidget(actionsGroup);
+    layout->addWidget(estimateGroup);
     layout->addStretch();
 
-    tabWidget->addTab(dashboardWidget, "Dashboard");
+    tabPages[DashboardTab]->layout()->addWidget(dashboardWidget);
 }
 
 void MainWindow::createAnalyzerTab() {
@@ -349,12 +445,24 @@ void MainWindow::createAnalyzerTab() {
     fileTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     fileTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
+    typeTable = new QTableWidget();
+    typeTable->setColumnCount(5);
+    typeTable->setHorizontalHeaderLabels({"Extension", "Category", "Files", "Size", "Share"});
+    typeTable->horizontalHeader()->setStretchLastSection(true);
+    typeTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    typeTable->setMaximumHeight(180);
+
     layout->addWidget(scanGroup);
     layout->addWidget(scanProgressBar);
     layout->addWidget(scanStatusLabel);
     layout->addWidget(fileTable);
+    layout->addWidget(new QLabel("Space by file type:"));
+    layout->addWidget(typeTable);
+
+    connect(startScanBtn, &QPushButton::clicked, this, &MainWindow::startScan);
+    connect(browseScanBtn, &QPushButton::clicked, this, &MainWindow::selectScanPath);
 
-    tabWidget->addTab(analyzerWidget, "File Analyzer");
+    tabPages[AnalyzerTab]->layout()->addWidget(analyzerWidget);
 }
 
 void MainWindow::createCleanupTab() {
@@ -393,7 +501,33 @@ void MainWindow::createCleanupTab() {
     layout->addWidget(cleanupStatusLabel);
     layout->addWidget(cleanupBtn);
 
-    tabWidget->addTab(cleanupWidget, "Cleanup");
+    connect(cleanTempBtn, &QPushButton::clicked, this, &MainWindow::cleanTempFiles);
+    connect(cleanCacheBtn, &QPushButton::clicked, this, &MainWindow::cleanCache);
+    connect(customCleanBtn, &QPushButton::clicked, this, [this]() {
+        // Select all checkboxes in the cleanup table
+        int selectedCount = 0;
+        for (int i = 0; i < cleanupTable->rowCount(); ++i) {
+            QWidget *widget = cleanupTable->cellWidget(i, 3);
+            if (widget) {
+                QCheckBox *checkbox = widget->findChild<QCheckBox*>();
+                if (checkbox) {
+                    checkbox->setChecked(true);
+                    selectedCount++;
+                }
+            }
+        }
+        if (selectedCount > 0) {
+            addLog(QString("Selected %1 duplicate/old files for cleanup").arg(selectedCount), "INFO");
+            QMessageBox::information(this, "Files Selected", 
+                QString("Selected %1 files for cleanup.\nClick 'Perform Cleanup' to remove them.").arg(selectedCount));
+        } else {
+            QMessageBox::information(this, "No Files", 
+                "No duplicate or old files found.\nScan a folder in the File Analyzer tab first.");
+        }
+    });
+    connect(cleanupBtn, &QPushButton::clicked, this, &MainWindow::performCleanup);
+
+    tabPages[CleanupTab]->layout()->addWidget(cleanupWidget);
 }
 
 void MainWindow::createBackupTab() {
@@ -438,15 +572,25 @@ void MainWindow::createBackupTab() {
     QHBoxLayout *backupButtonsLayout = new QHBoxLayout();
     QPushButton *selectAllBackupsBtn = new QPushButton("Select All");
     QPushButton *deleteSelectedBackupsBtn = new QPushButton("Delete Selected");
+    restoreSelectedBtn = new QPushButton("Restore Selected");
+    restoreSelectedBtn->setEnabled(!restoreWatcher.isRunning());
+    gcBackupsBtn = new QPushButton("Apply Retention");
+    gcBackupsBtn->setToolTip("Remove backups beyond keep_last, keep_days and max_size in ~/.spacematerc");
+    gcBackupsBtn->setEnabled(!gcWatcher.isRunning());
     
     selectAllBackupsBtn->setStyleSheet("background-color: #3b82f6; color: white; font-weight: bold;");
     deleteSelectedBackupsBtn->setStyleSheet("background-color: #dc2626; color: white; font-weight: bold;");
+    restoreSelectedBtn->setStyleSheet("background-color: #7c3aed; color: white; font-weight: bold;");
     
     connect(selectAllBackupsBtn, &QPushButton::clicked, this, &MainWindow::selectAllBackups);
     connect(deleteSelectedBackupsBtn, &QPushButton::clicked, this, &MainWindow::deleteSelectedBackups);
+    connect(restoreSelectedBtn, &QPushButton::clicked, this, &MainWindow::restoreSelectedBackups);
+    connect(gcBackupsBtn, &QPushButton::clicked, this, &MainWindow::collectBackupGarbage);
     
     backupButtonsLayout->addWidget(selectAllBackupsBtn);
+    backupButtonsLayout->addWidget(restoreSelectedBtn);
     backupButtonsLayout->addWidget(deleteSelectedBackupsBtn);
+    backupButtonsLayout->addWidget(gcBackupsBtn);
     backupButtonsLayout->addStretch();
     
     listLayout->addWidget(backupTable);
@@ -455,7 +599,12 @@ void MainWindow::createBackupTab() {
 
     layout->addWidget(createGroup);
     layout->addWidget(listGroup);
-    tabWidget->addTab(backupWidget, "Backup");
+
+    connect(browseSourceBtn, &QPushButton::clicked, this, &MainWindow::selectBackupSource);
+    connect(browseDestBtn, &QPushButton::clicked, this, &MainWindow::selectBackupDestination);
+    connect(createBackupBtn, &QPushButton::clicked, this, &MainWindow::createBackup);
+
+    tabPages[BackupTab]->layout()->addWidget(backupWidget);
 }
 
 void MainWindow::createMonitorTab() {
@@ -473,7 +622,63 @@ void MainWindow::createMonitorTab() {
     layout->addWidget(monitorBtn);
     layout->addStretch();
 
-    tabWidget->addTab(monitorWidget, "Monitor");
+    connect(monitorBtn, &QPushButton::clicked, this, &MainWindow::toggleMonitoring);
+
+    tabPages[MonitorTab]->layout()->addWidget(monitorWidget);
+}
+
+void MainWindow::createExplorerTab() {
+    QWidget *explorerWidget = new QWidget();
+    QVBoxLayout *layout = new QVBoxLayout(explorerWidget);
+
+    explorerStatusLabel = new QLabel("💡 Scan a folder in the File Analyzer tab to browse its directory sizes");
+    explorerStatusLabel->setStyleSheet("padding: 5px; color: #2563eb;");
+
+    dirTreeModel = new DirTreeModel(this);
+    dirTreeView = new QTreeView();
+    dirTreeView->setModel(dirTreeModel);
+    dirTreeView->setUniformRowHeights(true);   // keeps huge trees cheap to lay out
+    dirTreeView->setAlternatingRowColors(true);
+    dirTreeView->header()->setStretchLastSection(false);
+    dirTreeView->header()->setSectionResizeMode(DirTreeModel::NameColumn, QHeaderView::Stretch);
+
+    layout->addWidget(explorerStatusLabel);
+    layout->addWidget(dirTreeView);
+
+    tabPages[ExplorerTab]->layout()->addWidget(explorerWidget);
+}
+
+void MainWindow::createTreemapTab() {
+    QWidget *treemapTab = new QWidget();
+    QVBoxLayout *layout = new QVBoxLayout(treemapTab);
+
+    QHBoxLayout *navLayout = new QHBoxLayout();
+    QPushButton *upBtn = new QPushButton("Up");
+    upBtn->setToolTip("Zoom out to the parent directory (or right-click the map)");
+    treemapPathLabel = new QLabel("💡 Scan a folder in the File Analyzer tab to build the treemap");
+    treemapPathLabel->setStyleSheet("padding: 5px; color: #2563eb; font-weight: bold;");
+    navLayout->addWidget(upBtn);
+    navLayout->addWidget(treemapPathLabel, 1);
+
+    treemapWidget = new TreemapWidget();
+    treemapHoverLabel = new QLabel(" ");
+    treemapHoverLabel->setStyleSheet("padding: 5px; font-family: monospace;");
+
+    connect(upBtn, &QPushButton::clicked, treemapWidget, &TreemapWidget::zoomOut);
+    connect(treemapWidget, &TreemapWidget::zoomChanged, this, [this](const QString &path, qulonglong bytes) {
+        treemapPathLabel->setText(QString("📂 %1 (%2)").arg(path)
+                                  .arg(QString::fromStdString(Utils::formatSize(bytes))));
+    });
+    connect(treemapWidget, &TreemapWidget::hoverChanged, this, [this](const QString &path, qulonglong bytes) {
+        treemapHoverLabel->setText(QString("%1 — %2").arg(path)
+                                   .arg(QString::fromStdString(Utils::formatSize(bytes))));
+    });
+
+    layout->addLayout(navLayout);
+    layout->addWidget(treemapWidget, 1);
+    layout->addWidget(treemapHoverLabel);
+
+    tabPages[TreemapTab]->layout()->addWidget(treemapTab);
 }
 
 void MainWindow::addLog(const QString &message, const QString &status) {
@@ -485,255 +690,167 @@ void MainWindow::clearLogs() {
     logDisplay->clear();
 }
 
-// DIAGNOSTIC VERSION - Replace your updateDiskInfo() with this temporarily
-// This will help us see what's actually available on your system
+// WSL mounts the Windows drives at /mnt/<letter>; those are what the user
+// thinks of as "the disk". Elsewhere it is the volume holding their home.
+bool MainWindow::selectDashboardVolume(VolumeStats &volume) {
+    const unsigned long long minDriveSize = 10ULL * 1024 * 1024 * 1024;
+    for (const VolumeStats &candidate : MountTable::instance().volumes()) {
+        const std::string &mp = candidate.mount.mountPoint;
+        if (mp.size() == 6 && mp.compare(0, 5, "/mnt/") == 0 && isalpha((unsigned char)mp[5]) &&
+            candidate.total > minDriveSize) {
+            volume = candidate;
+            return true;
+        }
+    }
+    MountTable &mounts = MountTable::instance();
+    return (mounts.stats(QDir::homePath().toStdString(), volume) && volume.total > 0) ||
+           (mounts.stats("/", volume) && volume.total > 0);
+}
+
+void MainWindow::logVolumeDiagnostics() {
+    auto mounts = MountTable::instance().mounts();
+    addLog(QString("Mount table: %1 mounts").arg(mounts.size()), "INFO");
+    for (const VolumeStats &volume : MountTable::instance().volumes()) {
+        addLog(QString("  %1  %2  %3%4  %5 of %6 used (%7%)")
+                   .arg(QString::fromStdString(volume.mount.mountPoint))
+                   .arg(QString::fromStdString(volume.mount.fsType))
+                   .arg(QString::fromStdString(volume.mount.device))
+                   .arg(volume.mount.readOnly ? " (read-only)" : "")
+                   .arg(QString::fromStdString(Utils::formatSize(volume.total - volume.available)))
+                   .arg(QString::fromStdString(Utils::formatSize(volume.total)))
+                   .arg(volume.usedPercent(), 0, 'f', 1), "INFO");
+    }
 
+    VolumeStats selected;
+    if (selectDashboardVolume(selected)) {
+        addLog(QString("Dashboard volume: %1").arg(QString::fromStdString(selected.mount.mountPoint)), "INFO");
+    } else {
+        addLog("No volume with a known size found for the dashboard", "ERROR");
+    }
+}
+
+// Called on every dashboard refresh: the mount table and statvfs results
+// are cached by MountTable, so this does no filesystem work most of the time
 void MainWindow::updateDiskInfo() {
-    addLog("=== DIAGNOSTIC updateDiskInfo() ===", "INFO");
-    
-    // First, list ALL mounted volumes with full details
-    addLog("========================================", "INFO");
-    addLog("LISTING ALL MOUNTED VOLUMES:", "INFO");
-    addLog("========================================", "INFO");
-    
-    int volNum = 0;
-    for (const QStorageInfo& vol : QStorageInfo::mountedVolumes()) {
-        volNum++;
-        
-        QString details = QString("\n📀 VOLUME %1:").arg(volNum);
-        details += QString("\n  Root Path: %1").arg(vol.rootPath());
-        details += QString("\n  Device: %1").arg(QString(vol.device()));
-        details += QString("\n  File System: %1").arg(QString(vol.fileSystemType()));
-        details += QString("\n  Name: %1").arg(vol.name());
-        details += QString("\n  Display Name: %1").arg(vol.displayName());
-        details += QString("\n  Is Valid: %1").arg(vol.isValid() ? "YES" : "NO");
-        details += QString("\n  Is Ready: %1").arg(vol.isReady() ? "YES" : "NO");
-        details += QString("\n  Is Read Only: %1").arg(vol.isReadOnly() ? "YES" : "NO");
-        details += QString("\n  Total Bytes: %1").arg(vol.bytesTotal());
-        details += QString("\n  Available Bytes: %1").arg(vol.bytesAvailable());
-        
-        if (vol.bytesTotal() > 0) {
-            double totalGB = vol.bytesTotal() / (1024.0 * 1024.0 * 1024.0);
-            double availGB = vol.bytesAvailable() / (1024.0 * 1024.0 * 1024.0);
-            details += QString("\n  Total GB: %1").arg(totalGB, 0, 'f', 2);
-            details += QString("\n  Available GB: %1").arg(availGB, 0, 'f', 2);
+    VolumeStats volume;
+    if (!selectDashboardVolume(volume)) {
+        if (!dashboardVolumeMissing) {
+            addLog("❌ No volume with a known size found. Check the mount table.", "ERROR");
         }
-        
-        addLog(details, "INFO");
-        addLog("----------------------------------------", "INFO");
+        dashboardMount.clear();
+        dashboardVolumeMissing = true;
+        totalSpaceLabel->setText("Total: No valid storage");
+        usedSpaceLabel->setText("Used: Check logs");
+        freeSpaceLabel->setText("Free: Check logs");
+        usagePercentLabel->setText("Error");
+        return;
     }
-    
-    if (volNum == 0) {
-        addLog("❌ ERROR: QStorageInfo::mountedVolumes() returned NO volumes!", "ERROR");
+
+    QString mountPoint = QString::fromStdString(volume.mount.mountPoint);
+    if (mountPoint != dashboardMount) {
+        addLog(QString("Dashboard showing %1 (%2)").arg(mountPoint, QString::fromStdString(volume.mount.device)), "INFO");
+        dashboardMount = mountPoint;
+        dashboardVolumeMissing = false;
     }
-    
-    // Now test specific paths
-    addLog("\n========================================", "INFO");
-    addLog("TESTING SPECIFIC PATHS:", "INFO");
-    addLog("========================================", "INFO");
-    
-    QStringList testPaths = {
-        "/mnt/c",          // Windows C: drive (primary)
-        "/mnt/d",          // Windows D: drive if exists
-        "/",               // WSL root (fallback)
-        "/home",
-        "/tmp",
-        "/mnt/c/Users",
-        QDir::homePath(),
-        QDir::currentPath(),
-        QDir::tempPath(),
-    };
-    
-    QStorageInfo bestStorage;
-    long long bestSize = 0;
-    QString bestPath;
-    
-    for (const QString& path : testPaths) {
-        QStorageInfo storage(path);
-        
-        QString testResult = QString("\n🔍 Testing: %1").arg(path);
-        testResult += QString("\n  Exists: %1").arg(QDir(path).exists() ? "YES" : "NO");
-        testResult += QString("\n  Valid: %1").arg(storage.isValid() ? "YES" : "NO");
-        testResult += QString("\n  Ready: %1").arg(storage.isReady() ? "YES" : "NO");
-        testResult += QString("\n  Root: %1").arg(storage.rootPath());
-        testResult += QString("\n  Device: %1").arg(QString(storage.device()));
-        testResult += QString("\n  Total Bytes: %1").arg(storage.bytesTotal());
-        
-        if (storage.bytesTotal() > 0) {
-            double totalGB = storage.bytesTotal() / (1024.0 * 1024.0 * 1024.0);
-            testResult += QString("\n  Total GB: %1").arg(totalGB, 0, 'f', 2);
-            
-            // Track the best one - prioritize Windows drives and reasonable sizes
-            
-            bool isWindowsDrive = path.startsWith("/mnt/c") || path.startsWith("/mnt/d");
-            bool isReasonableSize = totalGB > 10 && totalGB < 500; // Between 10GB and 500GB (filters out virtual filesystems)
-            
-            if (storage.isValid() && storage.isReady()) {
-                // Selection priority: Windows drives first, then reasonable-sized drives
-                bool shouldSelect = false;
-                
-                if (isWindowsDrive && totalGB > 10) {
-                    shouldSelect = true; // Always prefer Windows drives
-                } else if (bestSize == 0 && isReasonableSize) {
-                    shouldSelect = true; // If no selection yet, accept reasonable sizes
-                } else if (isWindowsDrive && !bestPath.startsWith("/mnt/")) {
-                    shouldSelect = true; // Upgrade from non-Windows to Windows drive
-                }
-                
-                if (shouldSelect) {
-                    bestSize = storage.bytesTotal();
-                    bestStorage = storage;
-                    bestPath = path;
-                    testResult += QString("\n  ⭐ SELECTED AS BEST (Windows drive: %1, Size: %2 GB)")
-                                   .arg(isWindowsDrive ? "YES" : "NO")
-                                   .arg(totalGB, 0, 'f', 2);
-                } else {
-                    testResult += QString("\n  ⏭️ SKIPPED (Windows drive: %1, Reasonable size: %2)")
-                                   .arg(isWindowsDrive ? "YES" : "NO")
-                                   .arg(isReasonableSize ? "YES" : "NO");
-                }
+
+    long long totalBytes = volume.total;
+    long long freeBytes = volume.available;
+    long long usedBytes = totalBytes - freeBytes;
+
+    double totalGB = totalBytes / (1024.0 * 1024.0 * 1024.0);
+    double usedGB = usedBytes / (1024.0 * 1024.0 * 1024.0);
+    double freeGB = freeBytes / (1024.0 * 1024.0 * 1024.0);
+
+    // Update UI
+    totalSpaceLabel->setText(QString("Total: %1 GB").arg(totalGB, 0, 'f', 2));
+    usedSpaceLabel->setText(QString("Used: %1 GB").arg(usedGB, 0, 'f', 2));
+    freeSpaceLabel->setText(QString("Free: %1 GB").arg(freeGB, 0, 'f', 2));
+
+    int percentUsed = (totalGB > 0) ? static_cast<int>((usedGB * 100.0) / totalGB) : 0;
+    usagePercentLabel->setText(QString("%1%").arg(percentUsed));
+
+    // Create segmented storage bar
+    QWidget *segmentedBarContainer = findChild<QWidget*>("segmentedBarContainer");
+    if (segmentedBarContainer) {
+        // Clear existing segments
+        QLayout *oldLayout = segmentedBarContainer->layout();
+        if (oldLayout) {
+            QLayoutItem *item;
+            while ((item = oldLayout->takeAt(0)) != nullptr) {
+                delete item->widget();
+                delete item;
             }
-            testResult += " ✅ VALID";
-        } else {
-            testResult += " ❌ INVALID";
         }
         
-        addLog(testResult, "INFO");
-        addLog("----------------------------------------", "INFO");
-    }
-    
-    // Use the best storage found
-    addLog("\n========================================", "INFO");
-    addLog("FINAL RESULT:", "INFO");
-    addLog("========================================", "INFO");
-    
-    if (bestSize > 0) {
-        addLog(QString("✅ SUCCESS: Using path: %1").arg(bestPath), "SUCCESS");
-        addLog(QString("   Root: %1").arg(bestStorage.rootPath()), "SUCCESS");
-        addLog(QString("   Device: %1").arg(QString(bestStorage.device())), "SUCCESS");
-        
-        long long totalBytes = bestStorage.bytesTotal();
-        long long freeBytes = bestStorage.bytesAvailable();
-        long long usedBytes = totalBytes - freeBytes;
-        
-        double totalGB = totalBytes / (1024.0 * 1024.0 * 1024.0);
-        double usedGB = usedBytes / (1024.0 * 1024.0 * 1024.0);
-        double freeGB = freeBytes / (1024.0 * 1024.0 * 1024.0);
+        QHBoxLayout *segmentedLayout = new QHBoxLayout();
+        segmentedLayout->setContentsMargins(0, 0, 0, 0);
+        segmentedLayout->setSpacing(0);
         
-        addLog(QString("💾 Total: %1 GB").arg(totalGB, 0, 'f', 2), "SUCCESS");
-        addLog(QString("💾 Used: %1 GB").arg(usedGB, 0, 'f', 2), "SUCCESS");
-        addLog(QString("💾 Free: %1 GB").arg(freeGB, 0, 'f', 2), "SUCCESS");
+        // Calculate category sizes (simplified categorization)
+        // In a real scenario, you'd scan the filesystem for actual file types
+        double documentsGB = usedGB * 0.25;  // 25% of used space
+        double imagesGB = usedGB * 0.35;     // 35% of used space
+        double appsGB = usedGB * 0.20;       // 20% of used space
+        double systemGB = usedGB * 0.20;     // 20% of used space
         
-        // Update UI
-        totalSpaceLabel->setText(QString("Total: %1 GB").arg(totalGB, 0, 'f', 2));
-        usedSpaceLabel->setText(QString("Used: %1 GB").arg(usedGB, 0, 'f', 2));
-        freeSpaceLabel->setText(QString("Free: %1 GB").arg(freeGB, 0, 'f', 2));
-        
-        int percentUsed = (totalGB > 0) ? static_cast<int>((usedGB * 100.0) / totalGB) : 0;
-        usagePercentLabel->setText(QString("%1%").arg(percentUsed));
+        // Create segments
+        struct Segment {
+            QString name;
+            double sizeGB;
+            QString color;
+            QString textColor;
+        };
         
-        // Create segmented storage bar
-        QWidget *segmentedBarContainer = findChild<QWidget*>("segmentedBarContainer");
-        addLog(QString("🔍 Searching for segmentedBarContainer: %1").arg(segmentedBarContainer ? "FOUND" : "NOT FOUND"), "INFO");
+        QList<Segment> segments = {
+            {"Documents", documentsGB, "#3b82f6", "#ffffff"},  // Blue
+            {"Images", imagesGB, "#10b981", "#ffffff"},        // Green
+            {"Apps", appsGB, "#8b5cf6", "#ffffff"},            // Purple
+            {"System", systemGB, "#f59e0b", "#ffffff"},        // Orange
+            {"Free", freeGB, "#e5e7eb", "#374151"}             // Gray
+        };
         
-        if (segmentedBarContainer) {
-            addLog("📊 Creating segmented storage visualization...", "INFO");
-            // Clear existing segments
-            QLayout *oldLayout = segmentedBarContainer->layout();
-            if (oldLayout) {
-                QLayoutItem *item;
-                while ((item = oldLayout->takeAt(0)) != nullptr) {
-                    delete item->widget();
-                    delete item;
-                }
-            }
+        for (const auto &segment : segments) {
+            double percentage = (segment.sizeGB * 100.0) / totalGB;
+            if (percentage < 0.1) continue; // Skip tiny segments
             
-            QHBoxLayout *segmentedLayout = new QHBoxLayout();
-            segmentedLayout->setContentsMargins(0, 0, 0, 0);
-            segmentedLayout->setSpacing(0);
+            QWidget *segmentWidget = new QWidget();
+            segmentWidget->setStyleSheet(QString(
+                "background-color: %1; border-right: 1px solid #ffffff;"
+            ).arg(segment.color));
             
-            // Calculate category sizes (simplified categorization)
-            // In a real scenario, you'd scan the filesystem for actual file types
-            double documentsGB = usedGB * 0.25;  // 25% of used space
-            double imagesGB = usedGB * 0.35;     // 35% of used space
-            double appsGB = usedGB * 0.20;       // 20% of used space
-            double systemGB = usedGB * 0.20;     // 20% of used space
+            QVBoxLayout *segmentLayout = new QVBoxLayout(segmentWidget);
+            segmentLayout->setContentsMargins(5, 5, 5, 5);
             
-            // Create segments
-            struct Segment {
-                QString name;
-                double sizeGB;
-                QString color;
-                QString textColor;
-            };
+            QLabel *nameLabel = new QLabel(segment.name);
+            nameLabel->setStyleSheet(QString("color: %1; font-weight: bold; font-size: 11px;").arg(segment.textColor));
+            nameLabel->setAlignment(Qt::AlignCenter);
             
-            QList<Segment> segments = {
-                {"Documents", documentsGB, "#3b82f6", "#ffffff"},  // Blue
-                {"Images", imagesGB, "#10b981", "#ffffff"},        // Green
-                {"Apps", appsGB, "#8b5cf6", "#ffffff"},            // Purple
-                {"System", systemGB, "#f59e0b", "#ffffff"},        // Orange
-                {"Free", freeGB, "#e5e7eb", "#374151"}             // Gray
-            };
+            QLabel *sizeLabel = new QLabel(QString("%1 GB").arg(segment.sizeGB, 0, 'f', 1));
+            sizeLabel->setStyleSheet(QString("color: %1; font-size: 10px;").arg(segment.textColor));
+            sizeLabel->setAlignment(Qt::AlignCenter);
             
-            for (const auto &segment : segments) {
-                double percentage = (segment.sizeGB * 100.0) / totalGB;
-                if (percentage < 0.1) continue; // Skip tiny segments
-                
-                QWidget *segmentWidget = new QWidget();
-                segmentWidget->setStyleSheet(QString(
-                    "background-color: %1; border-right: 1px solid #ffffff;"
-                ).arg(segment.color));
-                
-                QVBoxLayout *segmentLayout = new QVBoxLayout(segmentWidget);
-                segmentLayout->setContentsMargins(5, 5, 5, 5);
-                
-                QLabel *nameLabel = new QLabel(segment.name);
-                nameLabel->setStyleSheet(QString("color: %1; font-weight: bold; font-size: 11px;").arg(segment.textColor));
-                nameLabel->setAlignment(Qt::AlignCenter);
-                
-                QLabel *sizeLabel = new QLabel(QString("%1 GB").arg(segment.sizeGB, 0, 'f', 1));
-                sizeLabel->setStyleSheet(QString("color: %1; font-size: 10px;").arg(segment.textColor));
-                sizeLabel->setAlignment(Qt::AlignCenter);
-                
-                segmentLayout->addWidget(nameLabel);
-                segmentLayout->addWidget(sizeLabel);
-                segmentWidget->setLayout(segmentLayout);
-                
-                segmentedLayout->addWidget(segmentWidget, percentage);
-            }
+            segmentLayout->addWidget(nameLabel);
+            segmentLayout->addWidget(sizeLabel);
+            segmentWidget->setLayout(segmentLayout);
             
-            delete segmentedBarContainer->layout();
-            segmentedBarContainer->setLayout(segmentedLayout);
-            addLog(QString("✅ Segmented bar created with %1 segments").arg(segments.size()), "SUCCESS");
-        } else {
-            addLog("❌ ERROR: segmentedBarContainer not found! Bar not created.", "ERROR");
+            segmentedLayout->addWidget(segmentWidget, percentage);
         }
         
-        // Update detailed disk info label
-        QLabel *diskInfoLabel = findChild<QLabel*>("diskInfoLabel");
-        if (diskInfoLabel) {
-            QString diskDetails;
-            diskDetails += QString("📍 Mount Point: %1\n").arg(bestStorage.rootPath());
-            diskDetails += QString("💾 Device: %1\n").arg(QString(bestStorage.device()));
-            diskDetails += QString("📂 File System: %1\n").arg(QString(bestStorage.fileSystemType()));
-            diskDetails += QString("🕐 Last Updated: %1")
-                .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
-            diskInfoLabel->setText(diskDetails);
-        }
-        
-        addLog(QString("✅ Dashboard updated: %1% used").arg(percentUsed), "SUCCESS");
-        
-    } else {
-        addLog("❌ CRITICAL FAILURE: No valid storage found anywhere!", "ERROR");
-        addLog("This might be a Qt or system configuration issue.", "ERROR");
-        
-        totalSpaceLabel->setText("Total: No valid storage");
-        usedSpaceLabel->setText("Used: Check logs");
-        freeSpaceLabel->setText("Free: Check logs");
-        usagePercentLabel->setText("Error");
+        delete segmentedBarContainer->layout();
+        segmentedBarContainer->setLayout(segmentedLayout);
     }
     
-    addLog("========================================", "INFO");
+    // Update detailed disk info label
+    QLabel *diskInfoLabel = findChild<QLabel*>("diskInfoLabel");
+    if (diskInfoLabel) {
+        QString diskDetails;
+        diskDetails += QString("📍 Mount Point: %1\n").arg(mountPoint);
+        diskDetails += QString("💾 Device: %1\n").arg(QString::fromStdString(volume.mount.device));
+        diskDetails += QString("📂 File System: %1\n").arg(QString::fromStdString(volume.mount.fsType));
+        diskDetails += QString("🕐 Last Updated: %1")
+            .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
+        diskInfoLabel->setText(diskDetails);
+    }
 }
 
 void MainWindow::refreshDashboard() {
@@ -742,6 +859,70 @@ void MainWindow::refreshDashboard() {
     addLog("Dashboard refreshed", "INFO");
 }
 
+void MainWindow::toggleEstimate() {
+    if (estimateWatcher.isRunning()) {
+        *estimateCancel = true;
+        estimateBtn->setEnabled(false);
+        return;
+    }
+
+    QString path = estimatePathInput->text().trimmed();
+    if (path.isEmpty() || !QDir(path).exists()) {
+        QMessageBox::warning(this, "Invalid Path", "Please enter an existing directory to estimate.");
+        return;
+    }
+
+    estimateCancel = std::make_shared<std::atomic<bool>>(false);
+    auto cancel = estimateCancel;
+    std::string root = path.toStdString();
+
+    estimateBtn->setText("Stop");
+    estimateLabel->setText("Sampling " + path + "...");
+    addLog("Estimating size of: " + path, "INFO");
+
+    // Intermediate results are posted back to the GUI thread; the final one
+    // arrives through the watcher.
+    estimateWatcher.setFuture(QtConcurrent::run([this, root, cancel]() {
+        SizeEstimator estimator(root);
+        return estimator.run(30.0, 0.05, [this, cancel](const SizeEstimate &e) {
+            QMetaObject::invokeMethod(this, [this, e]() { showEstimate(e, false); }, Qt::QueuedConnection);
+            return !*cancel;
+        });
+    }));
+}
+
+void MainWindow::onEstimateFinished() {
+    SizeEstimate estimate = estimateWatcher.result();
+    showEstimate(estimate, true);
+    estimateBtn->setText("Estimate");
+    estimateBtn->setEnabled(true);
+    addLog(QString("Estimate complete: %1 (±%2%)")
+               .arg(QString::fromStdString(Utils::formatSize((unsigned long long)estimate.bytes)))
+               .arg(estimate.relativeError() * 100, 0, 'f', 1), "SUCCESS");
+}
+
+void MainWindow::showEstimate(const SizeEstimate &estimate, bool final) {
+    // A queued progress update can land after the final result
+    if (!final && !estimateWatcher.isRunning()) return;
+
+    QString text = QString("%1 ~%2  ±%3%   ~%4 files   (%5 directories sampled, %6 s)")
+        .arg(final ? "Estimated size:" : "Sampling...")
+        .arg(QString::fromStdString(Utils::formatSize((unsigned long long)estimate.bytes)))
+        .arg(estimate.relativeError() * 100, 0, 'f', 1)
+        .arg((qulonglong)estimate.files)
+        .arg(estimate.directoriesRead)
+        .arg(estimate.elapsedSeconds, 0, 'f', 1);
+
+    QStringList largest;
+    for (size_t i = 0; i < estimate.children.size() && i < 5; ++i) {
+        const EstimatedChild &child = estimate.children[i];
+        largest << QString("%1/ %2").arg(QString::fromStdString(child.name))
+                       .arg(QString::fromStdString(Utils::formatSize((unsigned long long)child.bytes)));
+    }
+    if (!largest.isEmpty()) text += "\nLargest: " + largest.join(",  ");
+    estimateLabel->setText(text);
+}
+
 void MainWindow::selectScanPath() {
     QString path = QFileDialog::getExistingDirectory(this, "Select Directory to Scan");
     if (!path.isEmpty()) {
@@ -779,6 +960,8 @@ void MainWindow::startScan() {
     connect(scanWorker, &ScanWorker::scanProgress, scanProgressBar, &QProgressBar::setValue);
     connect(scanWorker, &ScanWorker::scanComplete, this, &MainWindow::onScanComplete);
     connect(scanWorker, &ScanWorker::scanError, this, &MainWindow::onScanError);
+    connect(scanWorker, &ScanWorker::typeBreakdownReady, this, &MainWindow::onTypeBreakdown);
+    connect(scanWorker, &ScanWorker::dirTreeReady, this, &MainWindow::onDirTreeReady);
 
     isScanning = true;
     lastScannedPath = path;  // Track the scanned path for monitoring
@@ -787,6 +970,7 @@ void MainWindow::startScan() {
 }
 
 void MainWindow::populateCleanupTable(const ScanResults &results) {
+    ensureTab(CleanupTab);
     cleanupTable->setRowCount(0);
     int row = 0;
     long long totalCleanupSize = 0;
@@ -1020,6 +1204,61 @@ void MainWindow::onScanComplete(const ScanResults &results, const DuplicateGroup
            .arg(fileCount).arg(duplicateCount).arg(oldFileCount).arg(totalSizeStr), "SUCCESS");
 }
 
+void MainWindow::onDirTreeReady(DirTreePtr tree) {
+    lastDirTree = tree;
+    applyDirTree();
+}
+
+// Shows the last scan's tree in whichever of Explorer and Treemap exist yet
+void MainWindow::applyDirTree() {
+    if (!lastDirTree) return;
+    if (tabBuilt[ExplorerTab]) {
+        dirTreeModel->setTree(lastDirTree);
+        dirTreeView->expand(dirTreeModel->index(0, 0));
+
+        const DirNode &root = lastDirTree->node(lastDirTree->root());
+        explorerStatusLabel->setText(QString("📂 %1 — %2 in %3 files, %4 directories")
+            .arg(QString::fromStdString(lastDirTree->rootPath()))
+            .arg(QString::fromStdString(Utils::formatSize(root.bytes)))
+            .arg(root.files)
+            .arg(lastDirTree->size() - 1));
+    }
+    if (tabBuilt[TreemapTab]) treemapWidget->setTree(lastDirTree);
+}
+
+void MainWindow::onTypeBreakdown(const TypeBreakdown &breakdown) {
+    typeTable->setRowCount(0);
+    int row = 0;
+
+    // Category totals first, then the individual extensions
+    for (const auto &category : breakdown.categories) {
+        typeTable->insertRow(row);
+        QTableWidgetItem *nameItem = new QTableWidgetItem(QString("[%1]").arg(categoryName(category.category)));
+        nameItem->setBackground(QColor(219, 234, 254));
+        typeTable->setItem(row, 0, nameItem);
+        typeTable->setItem(row, 1, new QTableWidgetItem(categoryName(category.category)));
+        typeTable->setItem(row, 2, new QTableWidgetItem(QString::number(category.count)));
+        typeTable->setItem(row, 3, new QTableWidgetItem(QString::fromStdString(Utils::formatSize(category.bytes))));
+        double share = breakdown.totalBytes ? category.bytes * 100.0 / breakdown.totalBytes : 0.0;
+        typeTable->setItem(row, 4, new QTableWidgetItem(QString("%1%").arg(share, 0, 'f', 1)));
+        row++;
+    }
+
+    for (const auto &type : breakdown.extensions) {
+        typeTable->insertRow(row);
+        QString label = type.extension.empty() ? "(none)" : QString::fromStdString(type.extension);
+        typeTable->setItem(row, 0, new QTableWidgetItem(label));
+        typeTable->setItem(row, 1, new QTableWidgetItem(categoryName(type.category)));
+        typeTable->setItem(row, 2, new QTableWidgetItem(QString::number(type.count)));
+        typeTable->setItem(row, 3, new QTableWidgetItem(QString::fromStdString(Utils::formatSize(type.bytes))));
+        double share = breakdown.totalBytes ? type.bytes * 100.0 / breakdown.totalBytes : 0.0;
+        typeTable->setItem(row, 4, new QTableWidgetItem(QString("%1%").arg(share, 0, 'f', 1)));
+        row++;
+    }
+
+    typeTable->resizeColumnsToContents();
+}
+
 void MainWindow::onScanError(const QString &error) {
     QMessageBox::critical(this, "Scan Error", error);
     scanStatusLabel->setText("Scan failed");
@@ -1077,7 +1316,7 @@ void MainWindow::cleanTempFiles() {
         progress.setValue(0);
         
         QFuture<void> future = QtConcurrent::run([this]() {
-            cleanupManager->cleanTempFiles();
+            getCleanupManager().cleanTempFiles();
         });
         
         while (!future.isFinished()) {
@@ -1107,7 +1346,7 @@ void MainWindow::cleanCache() {
         progress.setValue(0);
         
         QFuture<void> future = QtConcurrent::run([this]() {
-            cleanupManager->cleanCache();
+            getCleanupManager().cleanCache();
         });
         
         while (!future.isFinished()) {
@@ -1127,20 +1366,12 @@ void MainWindow::cleanCache() {
 void MainWindow::performCleanup() {
     // Collect selected paths first (so we don't mutate table while iterating forward)
     QVector<QString> selectedPaths;
-    QVector<QString> backupPaths;
 
     for (int i = 0; i < cleanupTable->rowCount(); ++i) {
         QWidget *widget = cleanupTable->cellWidget(i, 3);
         QCheckBox *checkbox = widget ? widget->findChild<QCheckBox*>() : nullptr;
         if (checkbox && checkbox->isChecked()) {
-            QString path = cleanupTable->item(i, 0)->text();
-            selectedPaths.append(path);
-
-            // Create backup path under backupManager path with timestamp (HH for 24-hour)
-            QString backupRoot = QString::fromStdString(backupManager->getBackupDir());
-            QString stamp = QDateTime::currentDateTime().toString("yyyy-MM-dd_HH-mm-ss");
-            QString backupPath = backupRoot + "/" + stamp + "_" + QFileInfo(path).fileName();
-            backupPaths.append(backupPath);
+            selectedPaths.append(cleanupTable->item(i, 0)->text());
         }
     }
 
@@ -1156,15 +1387,6 @@ void MainWindow::performCleanup() {
 
     if (confirm == QMessageBox::Cancel) return;
 
-    // If backup requested, ensure backupRoot exists
-    if (confirm == QMessageBox::Yes) {
-        QString backupRoot = QString::fromStdString(backupManager->getBackupDir());
-        if (backupRoot.isEmpty() || !QDir(backupRoot).exists()) {
-            QMessageBox::warning(this, "Invalid Backup Path", "Backup path not set or invalid. Please check Backup tab.");
-            return;
-        }
-    }
-
     cleanupBtn->setEnabled(false);
     cleanTempBtn->setEnabled(false);
     cleanCacheBtn->setEnabled(false);
@@ -1177,27 +1399,48 @@ void MainWindow::performCleanup() {
     int step = 0;
     int cleaned = 0;
 
+    // Back everything up as one session first; files whose backup failed are kept
+    QSet<QString> notBackedUp;
+    if (confirm == QMessageBox::Yes) {
+        progress.setLabelText("Backing up selected files...");
+        BackupSession session(getBackupManager());
+        if (!session.isOpen()) {
+            QMessageBox::warning(this, "Invalid Backup Path", "Could not create a backup session. Please check Backup tab.");
+            cleanupBtn->setEnabled(true);
+            cleanTempBtn->setEnabled(true);
+            cleanCacheBtn->setEnabled(true);
+            return;
+        }
+        QFuture<void> future = QtConcurrent::run([&session, selectedPaths]() {
+            for (const QString &path : selectedPaths) session.add(path.toStdString());
+            session.commit();
+        });
+        while (!future.isFinished()) {
+            QCoreApplication::processEvents();
+            progress.setValue((int)session.completed());
+            QThread::msleep(50);
+        }
+        step = selectedPaths.size();
+
+        for (const auto &path : session.failures()) {
+            notBackedUp.insert(QString::fromStdString(path));
+            addLog(QString("Failed to backup: %1").arg(QString::fromStdString(path)), "ERROR");
+        }
+        const SessionReport &report = session.report();
+        if (report.indexFailed) addLog("Could not write the backup index; no files were backed up", "ERROR");
+        addLog(QString("Backed up %1 files (%2, %3 new; %4 already stored) at %5/s")
+                   .arg(report.files)
+                   .arg(QString::fromStdString(Utils::formatSize(report.bytes)))
+                   .arg(QString::fromStdString(Utils::formatSize(report.storedBytes)))
+                   .arg(report.deduplicated)
+                   .arg(QString::fromStdString(Utils::formatSize((unsigned long long)report.bytesPerSecond()))), "SUCCESS");
+    }
+
     for (int i = 0; i < selectedPaths.size(); ++i) {
         const QString &path = selectedPaths[i];
         progress.setValue(step++);
         if (progress.wasCanceled()) break;
-
-        // Backup if requested
-        if (confirm == QMessageBox::Yes) {
-            // Ensure destination folder exists
-            QString destPath = QFileInfo(backupPaths[i]).absolutePath();
-            QDir().mkpath(destPath);
-            if (QFile::copy(path, backupPaths[i])) {
-                addLog(QString("Backed up: %1 -> %2").arg(path, backupPaths[i]), "SUCCESS");
-                // Add to backup index so it shows in Existing Backups
-                backupManager->addBackupIndexEntry(path.toStdString(), backupPaths[i].toStdString());
-            } else {
-                addLog(QString("Failed to backup: %1").arg(path), "ERROR");
-                // don't delete if backup fails; continue to next file
-                continue;
-            }
-            progress.setValue(step++);
-        }
+        if (notBackedUp.contains(path)) continue;   // don't delete if backup fails
 
         // Delete file
         try {
@@ -1223,6 +1466,7 @@ void MainWindow::performCleanup() {
     progress.setValue(progress.maximum());
     updateDiskInfo();
     updateBackupTable();  // Refresh backup table to show new backups
+    if (confirm == QMessageBox::Yes && BackupGc::loadPolicy().limited()) collectBackupGarbage();
 
     cleanupBtn->setEnabled(true);
     cleanTempBtn->setEnabled(true);
@@ -1261,8 +1505,9 @@ void MainWindow::selectBackupDestination() {
 }
 
 void MainWindow::updateBackupTable() {
+    if (!tabBuilt[BackupTab]) return;   // filled in when the tab is first shown
     backupTable->setRowCount(0);
-    auto backups = backupManager->loadBackupIndex();
+    auto backups = getBackupManager().loadBackupIndex();
     
     for (const auto& backup : backups) {
         int row = backupTable->rowCount();
@@ -1272,7 +1517,9 @@ void MainWindow::updateBackupTable() {
         QCheckBox *checkbox = new QCheckBox();
         backupTable->setCellWidget(row, 0, checkbox);
         
-        backupTable->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(backup.originalPath)));
+        QTableWidgetItem *originalItem = new QTableWidgetItem(QString::fromStdString(backup.originalPath));
+        originalItem->setData(Qt::UserRole, QVariant::fromValue<qulonglong>(backup.id));
+        backupTable->setItem(row, 1, originalItem);
         backupTable->setItem(row, 2, new QTableWidgetItem(QString::fromStdString(backup.backupPath)));
         backupTable->setItem(row, 3, new QTableWidgetItem(QString::fromStdString(backup.timestamp)));
         
@@ -1287,38 +1534,7 @@ void MainWindow::updateBackupTable() {
                        .arg(QString::fromStdString(backup.timestamp)),
                 QMessageBox::Yes | QMessageBox::No);
                 
-            if (confirm == QMessageBox::Yes) {
-                QProgressDialog progress("Restoring backup...", "Cancel", 0, 100, this);
-                progress.setWindowModality(Qt::WindowModal);
-                progress.setMinimumDuration(0);
-                
-                QFuture<bool> future = QtConcurrent::run([this, &backup]() {
-                    try {
-                        return fs::copy_file(backup.backupPath, backup.originalPath, 
-                                          fs::copy_options::overwrite_existing);
-                    } catch (...) {
-                        return false;
-                    }
-                });
-                
-                while (!future.isFinished()) {
-                    QCoreApplication::processEvents();
-                    progress.setValue(progress.value() + 1);
-                    if (progress.value() >= 100) progress.setValue(0);
-                    QThread::msleep(100);
-                }
-                
-                bool success = future.result();
-                progress.setValue(100);
-                
-                if (success) {
-                    addLog(QString("Backup restored: %1").arg(QString::fromStdString(backup.backupPath)), "SUCCESS");
-                    QMessageBox::information(this, "Restore Complete", "Backup has been restored successfully.");
-                } else {
-                    addLog(QString("Failed to restore backup: %1").arg(QString::fromStdString(backup.backupPath)), "ERROR");
-                    QMessageBox::critical(this, "Restore Failed", "Failed to restore the backup.");
-                }
-            }
+            if (confirm == QMessageBox::Yes) startRestore({backup}, RestoreConflict::Overwrite);
         });
         
         QWidget *btnContainer = new QWidget();
@@ -1355,8 +1571,9 @@ void MainWindow::createBackup() {
     progress.setMinimumDuration(0);
     progress.setValue(0);
 
-    QFuture<std::string> future = QtConcurrent::run([this, src, dest]() {
-        return backupManager->createBackup(src.toStdString(), dest.toStdString());
+    BackupManager &manager = getBackupManager();   // created here, not on the worker
+    QFuture<std::string> future = QtConcurrent::run([&manager, src, dest]() {
+        return manager.createBackup(src.toStdString(), dest.toStdString());
     });
 
     while (!future.isFinished()) {
@@ -1371,7 +1588,15 @@ void MainWindow::createBackup() {
 
     if (!backupPath.empty()) {
         updateBackupTable();
-        addLog(QString("Backup created: %1").arg(QString::fromStdString(backupPath)), "SUCCESS");
+        const SyncReport &sync = manager.lastSync();
+        addLog(QString("Backup updated: %1 (%2 copied, %3 unchanged, %4 removed; %5 at %6/s in %7 s)")
+                   .arg(QString::fromStdString(backupPath))
+                   .arg(sync.copied)
+                   .arg(sync.unchanged)
+                   .arg(sync.removed)
+                   .arg(QString::fromStdString(Utils::formatSize(sync.bytesCopied)))
+                   .arg(QString::fromStdString(Utils::formatSize((unsigned long long)sync.bytesPerSecond())))
+                   .arg(sync.seconds, 0, 'f', 2), "SUCCESS");
         QMessageBox::information(this, "Backup Complete", 
             QString("Backup has been created successfully at:\n%1").arg(QString::fromStdString(backupPath)));
     } else {
@@ -1385,33 +1610,15 @@ void MainWindow::updateMonitoringStats() {
         return;
     }
 
-    addLog("=== updateMonitoringStats() called ===", "INFO");
-
-    // Use the last scanned path if available, otherwise use root
+    // The volume holding the last scanned path, otherwise root
     QString monitorPath = lastScannedPath.isEmpty() ? "/" : lastScannedPath;
-    QStorageInfo storage(monitorPath);
-    bool foundValid = storage.isValid() && storage.isReady() && storage.bytesTotal() > 0;
-    
-    // If the scanned path doesn't work, try fallback mount points
+    VolumeStats storage;
+    bool foundValid = MountTable::instance().stats(monitorPath.toStdString(), storage) && storage.total > 0;
     if (!foundValid) {
-        QStringList mountPoints = {
-            QDir::homePath(),
-            "/home",
-            "/mnt/c",
-            "/",
-        };
-        
-        for (const QString& mp : mountPoints) {
-            storage = QStorageInfo(mp);
-            if (storage.isValid() && storage.isReady() && storage.bytesTotal() > 0) {
-                foundValid = true;
-                monitorPath = mp;
-                addLog(QString("Monitoring using fallback: %1").arg(mp), "SUCCESS");
-                break;
-            }
+        foundValid = selectDashboardVolume(storage);
+        if (foundValid) {
+            addLog(QString("Monitoring using fallback: %1").arg(QString::fromStdString(storage.mount.mountPoint)), "WARNING");
         }
-    } else {
-        addLog(QString("Monitoring scanned path: %1").arg(monitorPath), "SUCCESS");
     }
     
     if (!foundValid) {
@@ -1424,77 +1631,13 @@ void MainWindow::updateMonitoringStats() {
         return;
     }
 
-    // Calculate folder-specific statistics if monitoring a specific path
-    long long folderSize = 0;
-    int totalFiles = 0;
-    int totalFolders = 0;
-    int duplicateFiles = 0;
-    int oldFiles = 0;
-    int tempFiles = 0;
-    
+    // Folder statistics are computed by the core's background job and
+    // arrive through onFolderStats(); nothing here touches the folder
     bool isMonitoringFolder = !lastScannedPath.isEmpty() && lastScannedPath != "/";
     
-    if (isMonitoringFolder && QDir(lastScannedPath).exists()) {
-        try {
-            QDateTime oldThreshold = QDateTime::currentDateTime().addDays(-45);
-            std::unordered_map<QString, int> hashCounts;
-            
-            for (const auto &entry : fs::recursive_directory_iterator(
-                     lastScannedPath.toStdString(), 
-                     fs::directory_options::skip_permission_denied)) {
-                
-                if (entry.is_directory()) {
-                    totalFolders++;
-                } else if (entry.is_regular_file()) {
-                    totalFiles++;
-                    folderSize += entry.file_size();
-                    
-                    QString path = QString::fromStdString(entry.path().string());
-                    
-                    // Check if old file
-                    auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-                        entry.last_write_time() - fs::file_time_type::clock::now() + 
-                        std::chrono::system_clock::now());
-                    if (QDateTime::fromSecsSinceEpoch(
-                        std::chrono::system_clock::to_time_t(sctp)) < oldThreshold) {
-                        oldFiles++;
-                    }
-                    
-                    // Check if temporary file
-                    if (path.contains("/tmp/") || path.contains("\\temp\\", Qt::CaseInsensitive) ||
-                        path.endsWith(".tmp") || path.endsWith(".cache")) {
-                        tempFiles++;
-                    }
-                    
-                    // Calculate hash for duplicate detection (only for files > 1KB)
-                    if (entry.file_size() > 1024) {
-                        QFile file(path);
-                        if (file.open(QFile::ReadOnly)) {
-                            QCryptographicHash hash(QCryptographicHash::Md5);
-                            hash.addData(&file);
-                            QString hashStr = QString(hash.result().toHex());
-                            hashCounts[hashStr]++;
-                            file.close();
-                        }
-                    }
-                }
-            }
-            
-            // Count duplicates
-            for (const auto& pair : hashCounts) {
-                if (pair.second > 1) {
-                    duplicateFiles += pair.second - 1; // Count extras as duplicates
-                }
-            }
-            
-        } catch (const std::exception& e) {
-            addLog(QString("Error calculating folder stats: %1").arg(e.what()), "ERROR");
-        }
-    }
-    
     // Calculate storage statistics
-    double totalGB = storage.bytesTotal() / (1024.0 * 1024.0 * 1024.0);
-    double freeGB = storage.bytesAvailable() / (1024.0 * 1024.0 * 1024.0);
+    double totalGB = storage.total / (1024.0 * 1024.0 * 1024.0);
+    double freeGB = storage.available / (1024.0 * 1024.0 * 1024.0);
     double usedGB = totalGB - freeGB;
     double freePercent = (freeGB * 100.0) / totalGB;
     double usedPercent = 100.0 - freePercent;
@@ -1506,34 +1649,47 @@ void MainWindow::updateMonitoringStats() {
     if (isMonitoringFolder) {
         stats += QString("📂 Monitored Folder:\n%1\n").arg(lastScannedPath);
         stats += "───────────────────────────────\n";
-        
+    }
+    if (isMonitoringFolder && !haveFolderStats) {
+        stats += "⏳ Indexing folder...\n";
+        stats += "═══════════════════════════════\n\n";
+    } else if (isMonitoringFolder && !lastFolderStats.error.empty()) {
+        stats += QString("❌ Could not index folder: %1\n").arg(QString::fromStdString(lastFolderStats.error));
+        stats += "═══════════════════════════════\n\n";
+    } else if (isMonitoringFolder) {
+        const FolderStats &folder = lastFolderStats;
+
         // Folder size
-        double folderSizeGB = folderSize / (1024.0 * 1024.0 * 1024.0);
-        double folderSizeMB = folderSize / (1024.0 * 1024.0);
+        double folderSizeGB = folder.bytes / (1024.0 * 1024.0 * 1024.0);
+        double folderSizeMB = folder.bytes / (1024.0 * 1024.0);
         if (folderSizeGB >= 0.1) {
             stats += QString("📊 Folder Size: %1 GB\n").arg(folderSizeGB, 0, 'f', 2);
         } else {
             stats += QString("📊 Folder Size: %1 MB\n").arg(folderSizeMB, 0, 'f', 2);
         }
         
-        stats += QString("📄 Total Files: %1\n").arg(totalFiles);
-        stats += QString("📁 Total Folders: %1\n").arg(totalFolders);
+        stats += QString("📄 Total Files: %1\n").arg(folder.files);
+        stats += QString("📁 Total Folders: %1\n").arg(folder.folders);
         stats += "───────────────────────────────\n";
         
         // File categories
-        if (duplicateFiles > 0) {
-            stats += QString("🔄 Duplicate Files: %1\n").arg(duplicateFiles);
+        if (folder.duplicateFiles > 0) {
+            stats += QString("🔄 Duplicate Files: %1 (%2)\n").arg(folder.duplicateFiles)
+                         .arg(QString::fromStdString(Utils::formatSize(folder.duplicateBytes)));
         }
-        if (tempFiles > 0) {
-            stats += QString("🗑️  Temporary Files: %1\n").arg(tempFiles);
+        if (folder.tempFiles > 0) {
+            stats += QString("🗑️  Temporary Files: %1\n").arg(folder.tempFiles);
         }
-        if (oldFiles > 0) {
-            stats += QString("⏰ Old Files (>45 days): %1\n").arg(oldFiles);
+        if (folder.oldFiles > 0) {
+            stats += QString("⏰ Old Files (>%1 days): %2\n").arg(FolderStatsJob::OLD_FILE_DAYS).arg(folder.oldFiles);
         }
         
-        if (duplicateFiles == 0 && tempFiles == 0 && oldFiles == 0) {
+        if (folder.duplicateFiles == 0 && folder.tempFiles == 0 && folder.oldFiles == 0) {
             stats += "✅ No duplicates or old files\n";
         }
+        stats += QString("🔁 Live via %1, computed in %2s\n")
+                     .arg(QString::fromStdString(folder.backend))
+                     .arg(folder.elapsedSeconds, 0, 'f', 2);
         
         stats += "═══════════════════════════════\n\n";
     }
@@ -1541,33 +1697,48 @@ void MainWindow::updateMonitoringStats() {
     // Disk information
     stats += "💾 DISK INFORMATION\n";
     stats += "───────────────────────────────\n";
-    stats += QString("📍 Mount Point: %1\n").arg(storage.rootPath());
-    stats += QString("� Device: %1\n").arg(QString(storage.device()));
+    stats += QString("📍 Mount Point: %1\n").arg(QString::fromStdString(storage.mount.mountPoint));
+    stats += QString("💾 Device: %1\n").arg(QString::fromStdString(storage.mount.device));
     stats += QString("📊 Disk Usage: %1%\n").arg(usedPercent, 0, 'f', 1);
     stats += "───────────────────────────────\n";
     stats += QString("📦 Total Space: %1 GB\n").arg(totalGB, 0, 'f', 2);
     stats += QString("✅ Free Space: %1 GB (%2%)\n").arg(freeGB, 0, 'f', 2).arg(freePercent, 0, 'f', 1);
     stats += QString("📉 Used Space: %1 GB (%2%)\n").arg(usedGB, 0, 'f', 2).arg(usedPercent, 0, 'f', 1);
+
+    double inodesFreePercent = 100.0;
+    if (storage.inodesTotal > 0) {
+        inodesFreePercent = storage.inodesFree * 100.0 / storage.inodesTotal;
+        stats += QString("🗂️  Inodes Used: %1 of %2 (%3%)\n")
+                     .arg(storage.inodesTotal - storage.inodesFree)
+                     .arg(storage.inodesTotal)
+                     .arg(100.0 - inodesFreePercent, 0, 'f', 1);
+    }
+
+    // Growth forecast from the monitor's sample history
+    Forecast forecast = getDiskMonitor().forecast((lastScannedPath.isEmpty() ? QString("/") : lastScannedPath).toStdString());
+    if (forecast.fillRate > 0) {
+        stats += QString("📈 Fill Rate: +%1/h%2\n")
+                     .arg(QString::fromStdString(Utils::formatSize((unsigned long long)(forecast.fillRate * 3600))))
+                     .arg(forecast.reliable ? "" : " (warming up)");
+        stats += QString("⏳ Full In: %1\n").arg(QString::fromStdString(Utils::formatDuration(forecast.secondsToFull)));
+    } else {
+        stats += "📈 Fill Rate: not filling\n";
+    }
     stats += "═══════════════════════════════\n\n";
 
-    // Try to get largest directories (with error handling)
-    try {
-        auto dirs = diskMonitor->getLargestDirectories(storage.rootPath().toStdString(), 5);
+    // Largest directories come from the last scan's aggregated tree; no I/O here
+    if (lastDirTree) {
+        auto dirs = lastDirTree->largestChildren(lastDirTree->root(), 5);
         if (!dirs.empty()) {
             stats += "📁 Largest Directories:\n";
             stats += "───────────────────────────────\n";
             int count = 0;
-            for (const auto& dir : dirs) {
-                if (count >= 5) break;
-                QString dirPath = QString::fromStdString(dir.first);
-                double sizeGB = dir.second / (1024.0 * 1024.0 * 1024.0);
-                double sizeMB = dir.second / (1024.0 * 1024.0);
-                
-                if (sizeGB >= 0.1) {
-                    stats += QString("  • %1: %2 GB\n").arg(dirPath).arg(sizeGB, 0, 'f', 2);
-                    count++;
-                } else if (sizeMB >= 1.0) {
-                    stats += QString("  • %1: %2 MB\n").arg(dirPath).arg(sizeMB, 0, 'f', 1);
+            for (NodeId id : dirs) {
+                QString dirPath = QString::fromStdString(lastDirTree->name(id));
+                unsigned long long bytes = lastDirTree->node(id).bytes;
+                if (bytes >= 1024 * 1024) {
+                    stats += QString("  • %1: %2\n").arg(dirPath)
+                                 .arg(QString::fromStdString(Utils::formatSize(bytes)));
                     count++;
                 }
             }
@@ -1575,10 +1746,36 @@ void MainWindow::updateMonitoringStats() {
                 stats += "\n";
             }
         }
-    } catch (const std::exception& e) {
-        addLog(QString("getLargestDirectories error: %1").arg(e.what()), "ERROR");
-    } catch (...) {
-        // Silently ignore if largest directories not available
+
+        auto busiest = lastDirTree->busiestDirectories(3);
+        if (!busiest.empty() && lastDirTree->node(busiest.front()).directEntries >= 1000) {
+            stats += "🗂️  Most Entries:\n";
+            stats += "───────────────────────────────\n";
+            for (NodeId id : busiest) {
+                const DirNode &node = lastDirTree->node(id);
+                if (node.directEntries < 1000) break;
+                stats += QString("  • %1: %2 entries (%3 in subtree)\n")
+                             .arg(QString::fromStdString(lastDirTree->path(id)))
+                             .arg(node.directEntries)
+                             .arg(node.entries);
+            }
+            stats += "\n";
+        }
+    }
+
+    // A disk about to fill up matters more than a static percentage
+    if (forecast.reliable && forecast.secondsToFull >= 0 && forecast.secondsToFull < 24 * 3600) {
+        stats += "⚠️  FILLING UP ⚠️\n";
+        stats += "───────────────────────────────\n";
+        stats += QString("🔴 At the current rate the disk is full in %1\n\n")
+                 .arg(QString::fromStdString(Utils::formatDuration(forecast.secondsToFull)));
+    }
+
+    if (inodesFreePercent < 10) {
+        stats += "⚠️  INODES RUNNING OUT ⚠️\n";
+        stats += "───────────────────────────────\n";
+        stats += QString("🔴 Only %1% of inodes left - new files will fail even with free space\n\n")
+                 .arg(inodesFreePercent, 0, 'f', 1);
     }
 
     // Add warnings based on disk space
@@ -1607,7 +1804,7 @@ void MainWindow::updateMonitoringStats() {
     
     // Set color based on disk usage
     QString color;
-    if (freePercent < 10) {
+    if (freePercent < 10 || inodesFreePercent < 10) {
         color = "#dc2626"; // Red
     } else if (freePercent < 20) {
         color = "#f59e0b"; // Orange
@@ -1619,6 +1816,44 @@ void MainWindow::updateMonitoringStats() {
     );
 }
 
+void MainWindow::onMonitorSample(const DiskSample &sample) {
+    if (!isMonitoring) return;
+    addLog(QString("Disk usage changed on %1: %2 available")
+               .arg(QString::fromStdString(sample.path))
+               .arg(QString::fromStdString(Utils::formatSize(sample.available))), "INFO");
+    updateDiskInfo();
+    updateMonitoringStats();
+}
+
+void MainWindow::onMonitorAlert(const QString &rule, const QString &path, const QString &message,
+                                bool critical, bool resolved) {
+    QString text = QString("%1 %2: %3").arg(rule, path, message);
+    if (resolved) {
+        addLog("✅ Alert resolved - " + text, "SUCCESS");
+        return;
+    }
+    addLog("⚠️ Alert - " + text, critical ? "ERROR" : "WARNING");
+    if (critical) QMessageBox::warning(this, "Disk Alert", text);
+}
+
+void MainWindow::onMonitorGrowth(const QString &path, const QStringList &growers) {
+    if (!isMonitoring) return;
+    addLog(QString("📈 Grew the most under %1: %2").arg(path, growers.join(", ")), "INFO");
+}
+
+void MainWindow::onFolderStats(const FolderStats &stats) {
+    if (!isMonitoring || QString::fromStdString(stats.path) != QDir::cleanPath(lastScannedPath)) return;
+    if (!stats.error.empty()) {
+        addLog(QString("Could not index %1: %2").arg(lastScannedPath, QString::fromStdString(stats.error)), "ERROR");
+    } else if (!haveFolderStats) {
+        addLog(QString("Folder index ready: %1 files, live updates via %2")
+                   .arg(stats.files).arg(QString::fromStdString(stats.backend)), "SUCCESS");
+    }
+    lastFolderStats = stats;
+    haveFolderStats = true;
+    updateMonitoringStats();
+}
+
 void MainWindow::toggleMonitoring() {
     addLog(QString("=== toggleMonitoring - Current state: %1 ===")
            .arg(isMonitoring ? "ON" : "OFF"), "INFO");
@@ -1628,7 +1863,9 @@ void MainWindow::toggleMonitoring() {
         addLog("🛑 Stopping monitoring...", "INFO");
         
         try {
-            diskMonitor->stopMonitoring();
+            getDiskMonitor().stopMonitoring();
+            getDiskMonitor().stopFolderStats();
+            haveFolderStats = false;
             addLog("diskMonitor->stopMonitoring() succeeded", "SUCCESS");
         } catch (const std::exception& e) {
             addLog(QString("diskMonitor->stopMonitoring() error: %1").arg(e.what()), "ERROR");
@@ -1641,7 +1878,7 @@ void MainWindow::toggleMonitoring() {
         monitorStatusLabel->setText("⏸️  MONITORING STOPPED\n\n"
                                    "Click 'Start Monitoring' to begin\n"
                                    "real-time disk monitoring.\n\n"
-                                   "Updates will occur every 5 seconds.");
+                                   "Updates arrive whenever disk usage changes.");
         monitorStatusLabel->setStyleSheet("color: #facc15; font-weight: bold; font-family: monospace; padding: 10px;");
         isMonitoring = false;
         addLog("✅ Disk monitoring stopped successfully", "SUCCESS");
@@ -1651,7 +1888,13 @@ void MainWindow::toggleMonitoring() {
         addLog("▶️ Starting monitoring...", "INFO");
         
         try {
-            diskMonitor->startMonitoring();
+            // Directory growth only for a scanned folder; snapshotting all of / is too heavy
+            getDiskMonitor().setGrowthTracking(std::chrono::seconds(lastScannedPath.isEmpty() ? 0 : 60));
+            getDiskMonitor().startMonitoring((lastScannedPath.isEmpty() ? QString("/") : lastScannedPath).toStdString());
+            if (!lastScannedPath.isEmpty() && lastScannedPath != "/") {
+                haveFolderStats = false;
+                getDiskMonitor().startFolderStats(QDir::cleanPath(lastScannedPath).toStdString());
+            }
             addLog("diskMonitor->startMonitoring() succeeded", "SUCCESS");
         } catch (const std::exception& e) {
             addLog(QString("diskMonitor->startMonitoring() error: %1").arg(e.what()), "ERROR");
@@ -1665,12 +1908,8 @@ void MainWindow::toggleMonitoring() {
         
         addLog("Calling updateMonitoringStats() for initial display...", "INFO");
         
-        // Force immediate update
-        QTimer::singleShot(100, this, [this]() {
-            updateMonitoringStats();
-        });
-        
-        addLog("✅ Disk monitoring started - will update every 5 seconds", "SUCCESS");
+        // The first sample arrives almost immediately and triggers the initial display
+        addLog("✅ Disk monitoring started - updates on every change", "SUCCESS");
     }
 }
 
@@ -1684,83 +1923,136 @@ void MainWindow::selectAllBackups() {
 }
 
 void MainWindow::deleteSelectedBackups() {
-    QStringList selectedBackups;
-    QList<int> selectedRows;
-    
-    // Collect selected backup paths and row indices
+    // Several rows may share one stored object, so rows are removed by backup id
+    std::vector<uint64_t> selectedIds;
     for (int i = 0; i < backupTable->rowCount(); ++i) {
         QCheckBox *checkbox = qobject_cast<QCheckBox*>(backupTable->cellWidget(i, 0));
-        if (checkbox && checkbox->isChecked()) {
-            QTableWidgetItem *backupPathItem = backupTable->item(i, 2);
-            if (backupPathItem) {
-                selectedBackups.append(backupPathItem->text());
-                selectedRows.append(i);
-            }
+        QTableWidgetItem *originalItem = backupTable->item(i, 1);
+        if (checkbox && checkbox->isChecked() && originalItem) {
+            selectedIds.push_back(originalItem->data(Qt::UserRole).toULongLong());
         }
     }
     
-    if (selectedBackups.isEmpty()) {
+    if (selectedIds.empty()) {
         QMessageBox::warning(this, "No Selection", "Please select backups to delete.");
         return;
     }
     
     QMessageBox::StandardButton confirm = QMessageBox::question(
         this, "Confirm Deletion",
-        QString("Are you sure you want to delete %1 selected backup(s)?\nThis action cannot be undone.").arg(selectedBackups.size()),
+        QString("Are you sure you want to delete %1 selected backup(s)?\nThis action cannot be undone.").arg(selectedIds.size()),
         QMessageBox::Yes | QMessageBox::No);
     
     if (confirm != QMessageBox::Yes) return;
     
-    int deleted = 0;
-    for (const QString &backupPath : selectedBackups) {
-        try {
-            if (QFile::exists(backupPath)) {
-                if (QFile::remove(backupPath)) {
-                    addLog(QString("Deleted backup: %1").arg(backupPath), "SUCCESS");
-                    deleted++;
-                } else {
-                    addLog(QString("Failed to delete backup: %1").arg(backupPath), "ERROR");
-                }
-            } else {
-                addLog(QString("Backup file not found: %1").arg(backupPath), "WARNING");
-                deleted++; // Count as deleted since it's already gone
-            }
-        } catch (const std::exception &e) {
-            addLog(QString("Error deleting backup %1: %2").arg(backupPath, e.what()), "ERROR");
-        }
-    }
-    
-    // Remove entries from backup index
+    // Stored content still used by other backups is kept
+    size_t deleted = getBackupManager().removeBackups(selectedIds);
     if (deleted > 0) {
-        removeBackupsFromIndex(selectedBackups);
+        addLog(QString("Deleted %1 backup(s)").arg(deleted), "SUCCESS");
         updateBackupTable();
         QMessageBox::information(this, "Deletion Complete",
-                                QString("Successfully deleted %1 of %2 backup(s).").arg(deleted).arg(selectedBackups.size()));
+                                QString("Successfully deleted %1 of %2 backup(s).").arg(deleted).arg(selectedIds.size()));
+    } else {
+        addLog("Failed to update the backup index", "ERROR");
     }
 }
 
-void MainWindow::removeBackupsFromIndex(const QStringList &backupPaths) {
-    auto backups = backupManager->loadBackupIndex();
+void MainWindow::restoreSelectedBackups() {
+    std::unordered_set<uint64_t> selectedIds;
+    for (int i = 0; i < backupTable->rowCount(); ++i) {
+        QCheckBox *checkbox = qobject_cast<QCheckBox*>(backupTable->cellWidget(i, 0));
+        QTableWidgetItem *originalItem = backupTable->item(i, 1);
+        if (checkbox && checkbox->isChecked() && originalItem) {
+            selectedIds.insert(originalItem->data(Qt::UserRole).toULongLong());
+        }
+    }
     
-    // Filter out the deleted backups
-    QSet<QString> pathsToRemove(backupPaths.begin(), backupPaths.end());
+    if (selectedIds.empty()) {
+        QMessageBox::warning(this, "No Selection", "Please select backups to restore.");
+        return;
+    }
     
-    // Rewrite the index file without the deleted entries
-    QString indexFile = QString::fromStdString(backupManager->getBackupDir()) + "/index.txt";
-    QFile file(indexFile);
+    QMessageBox ask(QMessageBox::Question, "Restore Backups",
+                    QString("Restore %1 selected backup(s) to their original locations?\n\n"
+                            "What should happen to files that already exist there?").arg(selectedIds.size()),
+                    QMessageBox::Cancel, this);
+    QPushButton *overwriteBtn = ask.addButton("Overwrite", QMessageBox::DestructiveRole);
+    QPushButton *renameBtn = ask.addButton("Keep Both", QMessageBox::AcceptRole);
+    QPushButton *skipBtn = ask.addButton("Skip", QMessageBox::AcceptRole);
+    ask.setDefaultButton(skipBtn);
+    ask.exec();
     
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&file);
-        
-        for (const auto& backup : backups) {
-            QString backupPath = QString::fromStdString(backup.backupPath);
-            if (!pathsToRemove.contains(backupPath)) {
-                out << QString::fromStdString(backup.timestamp) << "|"
-                    << QString::fromStdString(backup.originalPath) << "|"
-                    << QString::fromStdString(backup.backupPath) << "|"
-                    << backup.size << "\n";
-            }
-        }
-        file.close();
+    RestoreConflict conflict;
+    if (ask.clickedButton() == overwriteBtn) conflict = RestoreConflict::Overwrite;
+    else if (ask.clickedButton() == renameBtn) conflict = RestoreConflict::Rename;
+    else if (ask.clickedButton() == skipBtn) conflict = RestoreConflict::Skip;
+    else return;
+    
+    std::vector<BackupEntry> entries;
+    for (auto &entry : getBackupManager().loadBackupIndex()) {
+        if (selectedIds.count(entry.id)) entries.push_back(std::move(entry));
+    }
+    startRestore(entries, conflict);
+}
+
+// Restores on a worker (BackupRestorer); the table stays usable meanwhile
+void MainWindow::startRestore(const std::vector<BackupEntry> &entries, RestoreConflict conflict) {
+    if (restoreWatcher.isRunning()) {
+        QMessageBox::information(this, "Restore Running", "Wait for the current restore to finish.");
+        return;
+    }
+    if (restoreSelectedBtn) restoreSelectedBtn->setEnabled(false);
+    addLog(QString("Restoring %1 backup(s) in the background...").arg(entries.size()), "INFO");
+    RestoreOptions options;
+    options.conflict = conflict;
+    restoreWatcher.setFuture(QtConcurrent::run([entries, options]() {
+        return BackupRestorer::run(BackupRestorer::plan(entries, options), options);
+    }));
+}
+
+void MainWindow::onRestoreFinished() {
+    RestoreReport report = restoreWatcher.result();
+    if (restoreSelectedBtn) restoreSelectedBtn->setEnabled(true);
+    for (const auto &failure : report.failures) {
+        addLog(QString("Failed to restore %1").arg(QString::fromStdString(failure)), "ERROR");
+    }
+    addLog(QString("Restored %1 file(s) (%2 at %3/s), %4 kept alongside existing files, %5 skipped")
+               .arg(report.restored)
+               .arg(QString::fromStdString(Utils::formatSize(report.bytes)))
+               .arg(QString::fromStdString(Utils::formatSize((unsigned long long)report.bytesPerSecond())))
+               .arg(report.renamed)
+               .arg(report.skipped), report.failed > 0 ? "ERROR" : "SUCCESS");
+    if (report.failed > 0) {
+        QMessageBox::critical(this, "Restore Failed",
+                              QString("%1 file(s) could not be restored; see the activity log.").arg(report.failed));
+    } else {
+        QMessageBox::information(this, "Restore Complete",
+                                 QString("Restored %1 file(s).").arg(report.restored));
     }
+    updateDiskInfo();
+}
+
+// Runs on a worker with a BackupManager of its own; the index is shared
+// safely through its file lock
+void MainWindow::collectBackupGarbage() {
+    if (gcWatcher.isRunning()) return;
+    if (gcBackupsBtn) gcBackupsBtn->setEnabled(false);
+    addLog("Applying backup retention in the background...", "INFO");
+    gcWatcher.setFuture(QtConcurrent::run([]() {
+        BackupManager manager;
+        BackupGc gc(manager);
+        return gc.run(gc.plan(BackupGc::loadPolicy()));
+    }));
+}
+
+void MainWindow::onGcFinished() {
+    GcReport report = gcWatcher.result();
+    if (gcBackupsBtn) gcBackupsBtn->setEnabled(true);
+    addLog(QString("Retention removed %1 backup(s) and %2 stored file(s), rewrote %3 pack(s), freed %4")
+               .arg(report.entriesRemoved)
+               .arg(report.filesRemoved)
+               .arg(report.packsRewritten)
+               .arg(QString::fromStdString(Utils::formatSize(report.bytesFreed))), "SUCCESS");
+    updateBackupTable();
+    updateDiskInfo();
 }
\ No newline at end of file
@@ -12,12 +12,23 @@
 #include <QTextEdit>
 #include <QThread>
 #include <QCheckBox>
+#include <QTreeView>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <atomic>
 #include <memory>
 #include <vector>
 #include "../include/backup_manager.h"
+#include "../include/backup_gc.h"
+#include "../include/backup_restorer.h"
 #include "../include/cleanup_manager.h"
 #include "../include/disk_monitor.h"
 #include "../include/file_analyzer.h"
+#include "../include/size_estimator.h"
+#include "../include/mount_table.h"
+#include "dir_tree_model.h"
+#include "treemap_widget.h"
+#include "monitor_bridge.h"
 
 // Forward declarations
 struct FileDetail {
@@ -36,6 +47,8 @@ using DuplicateGroups = std::vector<std::vector<FileDetail>>;
 Q_DECLARE_METATYPE(FileDetail)
 Q_DECLARE_METATYPE(ScanResults)
 Q_DECLARE_METATYPE(DuplicateGroups)
+Q_DECLARE_METATYPE(TypeBreakdown)
+Q_DECLARE_METATYPE(DirTreePtr)
 
 // Worker thread for scanning
 class ScanWorker : public QThread {
@@ -48,6 +61,8 @@ public:
 signals:
     void scanProgress(int percent);
     void scanComplete(const ScanResults &results, const DuplicateGroups &duplicates);
+    void typeBreakdownReady(const TypeBreakdown &breakdown);
+    void dirTreeReady(DirTreePtr tree);
     void scanError(const QString &error);
 
 private:
@@ -58,19 +73,28 @@ class MainWindow : public QMainWindow {
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    // `launched` is started by main() before QApplication so startup
+    // timings include Qt's own initialisation
+    MainWindow(QWidget *parent = nullptr, const QElapsedTimer &launched = QElapsedTimer());
     ~MainWindow();
 
+protected:
+    bool event(QEvent *e) override;
+
 private slots:
     // Dashboard
     void updateDiskInfo();
     void refreshDashboard();
+    void toggleEstimate();
+    void onEstimateFinished();
 
     // File Analyzer
     void selectScanPath();
     void startScan();
     void onScanComplete(const ScanResults &results, const DuplicateGroups &duplicates);
     void onScanError(const QString &error);
+    void onTypeBreakdown(const TypeBreakdown &breakdown);
+    void onDirTreeReady(DirTreePtr tree);
     void deleteFileFromTable(int row);
     void deleteFileFromPath(const QString &path);
 
@@ -87,34 +111,65 @@ private slots:
     void updateBackupTable();
     void selectAllBackups();
     void deleteSelectedBackups();
+    void collectBackupGarbage();   // retention policy, in the background
+    void onGcFinished();
+    void restoreSelectedBackups();
+    void onRestoreFinished();
 
     // Monitoring
     void toggleMonitoring();
     void updateMonitoringStats();
+    void onMonitorSample(const DiskSample &sample);
+    void onMonitorAlert(const QString &rule, const QString &path, const QString &message,
+                        bool critical, bool resolved);
+    void onMonitorGrowth(const QString &path, const QStringList &growers);
+    void onFolderStats(const FolderStats &stats);
 
     // Logging
     void addLog(const QString &message, const QString &status);
     void clearLogs();
 
 private:
+    enum Tab { DashboardTab, AnalyzerTab, CleanupTab, BackupTab, MonitorTab, ExplorerTab, TreemapTab, TabCount };
+
     void setupUI();
     void setupConnections();
+    void ensureTab(int index);
+    void applyDirTree();
+    void recordStartup();   // appends to ~/.spacemate/startup_times.txt
+    BackupManager &getBackupManager();
+    CleanupManager &getCleanupManager();
+    DiskMonitor &getDiskMonitor();   // also creates the bridge and connects it
     void createDashboardTab();
     void createAnalyzerTab();
     void createCleanupTab();
     void createBackupTab();
     void createMonitorTab();
+    void createExplorerTab();
+    void createTreemapTab();
+    void showEstimate(const SizeEstimate &estimate, bool final);
+    bool selectDashboardVolume(VolumeStats &volume);
+    void logVolumeDiagnostics();   // every mounted volume (Debug menu)
     QString convertToWSLPath(const QString &windowsPath);
-    void removeBackupsFromIndex(const QStringList &backupPaths);
+    void startRestore(const std::vector<BackupEntry> &entries, RestoreConflict conflict);
 
     // UI Components
     QTabWidget *tabWidget;
+    QWidget *tabPages[TabCount];
+    bool tabBuilt[TabCount] = {};
 
     // Dashboard
     QLabel *totalSpaceLabel;
     QLabel *usedSpaceLabel;
     QLabel *freeSpaceLabel;
     QLabel *usagePercentLabel;
+    QString dashboardMount;              // volume shown, logged when it changes
+    bool dashboardVolumeMissing = false;
+    QLineEdit *estimatePathInput;
+    QPushButton *estimateBtn;
+    QLabel *estimateLabel;
+    QFutureWatcher<SizeEstimate> estimateWatcher;
+    std::shared_ptr<std::atomic<bool>> estimateCancel;
 
     // File Analyzer
     QLineEdit *scanPathInput;
@@ -123,6 +178,7 @@ private:
     QProgressBar *scanProgressBar;
     QLabel *scanStatusLabel;
     QTableWidget *fileTable;
+    QTableWidget *typeTable;
 
     // Cleanup
     QPushButton *cleanTempBtn;
@@ -139,24 +195,44 @@ private:
     QPushButton *browseDestBtn;
     QPushButton *createBackupBtn;
     QTableWidget *backupTable;
+    QPushButton *gcBackupsBtn = nullptr;
+    QFutureWatcher<GcReport> gcWatcher;
+    QPushButton *restoreSelectedBtn = nullptr;
+    QFutureWatcher<RestoreReport> restoreWatcher;
 
     // Monitoring
     QPushButton *monitorBtn;
     QLabel *monitorStatusLabel;
+    FolderStats lastFolderStats;   // from the core's FolderStatsJob, via MonitorBridge
+    bool haveFolderStats = false;
+
+    // Explorer (aggregated directory tree of the last scan)
+    QTreeView *dirTreeView;
+    DirTreeModel *dirTreeModel;
+    QLabel *explorerStatusLabel;
+    DirTreePtr lastDirTree;
+
+    // Treemap
+    TreemapWidget *treemapWidget;
+    QLabel *treemapPathLabel;
+    QLabel *treemapHoverLabel;
 
     // Log
     QTextEdit *logDisplay;
 
-    // Backend Managers
+    // Backend Managers, created on first use through the get*() accessors
     std::unique_ptr<BackupManager> backupManager;
     std::unique_ptr<CleanupManager> cleanupManager;
     std::unique_ptr<DiskMonitor> diskMonitor;
-    std::unique_ptr<FileAnalyzer> fileAnalyzer;
+    std::unique_ptr<MonitorBridge> monitorBridge;   // must go before diskMonitor
 
     // Worker thread
     ScanWorker *scanWorker;
 
     // State
+    QElapsedTimer startupClock;
+    qint64 firstPaintMs = -1;
+    qint64 interactiveMs = -1;
     bool isMonitoring;
     bool isScanning;
     QString lastScannedPath;  // Track the last scanned/analyzed path for monitoring
@@ -0,0 +1,39 @@
+#include "monitor_bridge.h"
+#include "../include/utils.h"
+
+MonitorBridge::MonitorBridge(DiskMonitor &monitor, QObject *parent)
+    : QObject(parent), diskMonitor(monitor) {
+    qRegisterMetaType<DiskSample>();
+    qRegisterMetaType<FolderStats>();
+    subscription = diskMonitor.subscribe([this](const DiskSample &sample) {
+        emit sampleReady(sample);
+    });
+
+    growthSubscription = diskMonitor.subscribeGrowth(
+        [this](const std::string &path, const std::vector<DirGrowth> &byBytes, const std::vector<DirGrowth> &) {
+            QStringList growers;
+            for (const auto &g : byBytes) {
+                growers << QString("%1 +%2").arg(QString::fromStdString(g.path))
+                               .arg(QString::fromStdString(Utils::formatSize(g.bytesDelta)));
+            }
+            if (!growers.isEmpty()) emit growthFound(QString::fromStdString(path), growers);
+        });
+
+    folderStatsSubscription = diskMonitor.subscribeFolderStats([this](const FolderStats &stats) {
+        emit folderStatsReady(stats);   // queued: the receiver lives on the GUI thread
+    });
+
+    alertSink = std::make_shared<CallbackAlertSink>([this](const Alert &alert) {
+        emit alertRaised(QString::fromStdString(alert.rule), QString::fromStdString(alert.path),
+                         QString::fromStdString(alert.message),
+                         alert.severity == AlertSeverity::Critical, alert.resolved);
+    });
+    diskMonitor.alertEngine().addSink(alertSink);
+}
+
+MonitorBridge::~MonitorBridge() {
+    diskMonitor.alertEngine().removeSink(alertSink);
+    diskMonitor.unsubscribe(subscription);
+    diskMonitor.unsubscribe(growthSubscription);
+    diskMonitor.unsubscribe(folderStatsSubscription);
+}
@@ -0,0 +1,37 @@
+#ifndef MONITOR_BRIDGE_H
+#define MONITOR_BRIDGE_H
+
+#include <QObject>
+#include <QMetaType>
+#include <QStringList>
+#include "../include/disk_monitor.h"
+
+Q_DECLARE_METATYPE(DiskSample)
+Q_DECLARE_METATYPE(FolderStats)
+
+// Re-emits DiskMonitor samples, alerts and folder stats as Qt signals. The
+// subscription callbacks run on core threads; connections made with the
+// default AutoConnection deliver the signals on the receiver's thread.
+class MonitorBridge : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MonitorBridge(DiskMonitor &monitor, QObject *parent = nullptr);
+    ~MonitorBridge();
+
+signals:
+    void sampleReady(const DiskSample &sample);
+    void alertRaised(const QString &rule, const QString &path, const QString &message,
+                     bool critical, bool resolved);
+    void growthFound(const QString &path, const QStringList &growers);
+    void folderStatsReady(const FolderStats &stats);
+
+private:
+    DiskMonitor &diskMonitor;
+    DiskMonitor::SubscriptionId subscription;
+    DiskMonitor::SubscriptionId growthSubscription;
+    DiskMonitor::SubscriptionId folderStatsSubscription;
+    std::shared_ptr<AlertSink> alertSink;
+};
+
+#endif // MONITOR_BRIDGE_H
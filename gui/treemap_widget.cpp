@@ -0,0 +1,366 @@
+#include "treemap_widget.h"
+#include "../include/utils.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+const double MIN_SIDE = 3.0;      // rectangles thinner than this are not emitted
+const double HEADER = 14.0;       // label strip at the top of large directories
+const double PAD = 1.5;
+const qint64 FRAME_BUDGET_MS = 8; // leave half a 60 Hz frame for everything else
+
+struct Item {
+    NodeId node;
+    double weight;
+    bool files;
+};
+
+struct Placed {
+    Item item;
+    QRectF rect;
+};
+
+// Aspect-ratio penalty of laying items[i, j) as one row along `side`
+double worstRatio(const std::vector<Item> &items, size_t i, size_t j,
+                  double sum, double side, double scale) {
+    double s = sum * scale;
+    double rmax = items[i].weight * scale;       // items are sorted, largest first
+    double rmin = items[j - 1].weight * scale;
+    double side2 = side * side;
+    return std::max(side2 * rmax / (s * s), (s * s) / (side2 * rmin));
+}
+
+// Bruls/Huizing/van Wijk squarified layout of sorted items into `area`
+void squarify(const std::vector<Item> &items, QRectF area, double scale, std::vector<Placed> &placed) {
+    size_t i = 0;
+    while (i < items.size()) {
+        double side = std::min(area.width(), area.height());
+        if (side <= 0) break;
+
+        size_t j = i;
+        double sum = 0;
+        double best = std::numeric_limits<double>::max();
+        while (j < items.size()) {
+            double nextSum = sum + items[j].weight;
+            double ratio = worstRatio(items, i, j + 1, nextSum, side, scale);
+            if (j > i && ratio > best) break;
+            best = ratio;
+            sum = nextSum;
+            ++j;
+        }
+
+        double rowArea = sum * scale;
+        if (area.width() >= area.height()) {
+            double thickness = rowArea / area.height();
+            double y = area.top();
+            for (size_t k = i; k < j; ++k) {
+                double h = items[k].weight * scale / thickness;
+                placed.push_back({items[k], QRectF(area.left(), y, thickness, h)});
+                y += h;
+            }
+            area.setLeft(area.left() + thickness);
+        } else {
+            double thickness = rowArea / area.width();
+            double x = area.left();
+            for (size_t k = i; k < j; ++k) {
+                double w = items[k].weight * scale / thickness;
+                placed.push_back({items[k], QRectF(x, area.top(), w, thickness)});
+                x += w;
+            }
+            area.setTop(area.top() + thickness);
+        }
+        i = j;
+    }
+}
+
+}  // namespace
+
+// ===== Layout (runs on a worker thread) =====
+TreemapLayout TreemapWidget::computeLayout(DirTreePtr tree, NodeId root, QSizeF size) {
+    TreemapLayout layout;
+    if (!tree || root == NO_NODE || size.isEmpty()) return layout;
+
+    struct Pending {
+        NodeId node;
+        QRectF rect;
+        int depth;
+        int branch;
+        int parent;   // layout index of the enclosing rectangle
+    };
+    std::vector<Pending> stack;
+    stack.push_back({root, QRectF(QPointF(0, 0), size), 0, 0, -1});
+
+    std::vector<Item> items;
+    std::vector<Placed> placed;
+
+    while (!stack.empty()) {
+        Pending cur = stack.back();
+        stack.pop_back();
+
+        const DirNode &node = tree->node(cur.node);
+        int index = layout.size();
+        if (cur.parent >= 0) layout[cur.parent].children.push_back(index);
+        layout.push_back({cur.rect, cur.node, cur.depth, cur.branch, false, {}});
+        if (node.bytes == 0) continue;
+
+        QRectF inner = cur.rect.adjusted(PAD, PAD, -PAD, -PAD);
+        if (inner.width() > 60 && inner.height() > HEADER * 3) inner.setTop(inner.top() + HEADER);
+        if (inner.width() < MIN_SIDE || inner.height() < MIN_SIDE) continue;
+
+        items.clear();
+        for (NodeId child : tree->children(cur.node)) {
+            if (tree->node(child).bytes > 0) items.push_back({child, double(tree->node(child).bytes), false});
+        }
+        if (node.directBytes > 0) items.push_back({cur.node, double(node.directBytes), true});
+        std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) { return a.weight > b.weight; });
+
+        placed.clear();
+        squarify(items, inner, inner.width() * inner.height() / double(node.bytes), placed);
+
+        int childIndex = 0;
+        for (const Placed &p : placed) {
+            if (p.rect.width() < MIN_SIDE || p.rect.height() < MIN_SIDE) continue;
+            int branch = cur.depth == 0 ? childIndex++ : cur.branch;
+            if (p.item.files) {
+                layout[index].children.push_back(layout.size());
+                layout.push_back({p.rect, p.item.node, cur.depth + 1, branch, true, {}});
+            } else {
+                stack.push_back({p.item.node, p.rect, cur.depth + 1, branch, index});
+            }
+        }
+    }
+
+    // Largest first (the root stays first); child indices follow the
+    // rectangles to their new places
+    std::vector<int> order(layout.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&layout](int a, int b) {
+        const QRectF &ra = layout[a].rect, &rb = layout[b].rect;
+        return ra.width() * ra.height() > rb.width() * rb.height();
+    });
+    std::vector<int> position(layout.size());
+    for (size_t i = 0; i < order.size(); ++i) position[order[i]] = int(i);
+
+    TreemapLayout sorted;
+    sorted.reserve(layout.size());
+    for (int i : order) {
+        sorted.push_back(layout[i]);
+        for (int &child : sorted.back().children) child = position[child];
+    }
+    return sorted;
+}
+
+// ===== Widget =====
+TreemapWidget::TreemapWidget(QWidget *parent)
+    : QWidget(parent), currentRoot(NO_NODE), pendingRoot(NO_NODE),
+      layoutRoot(NO_NODE), nextRect(0), hoverIndex(-1) {
+    setMouseTracking(true);
+    setMinimumSize(200, 150);
+
+    connect(&layoutWatcher, &QFutureWatcher<TreemapLayout>::finished, this, &TreemapWidget::onLayoutReady);
+
+    renderTimer.setSingleShot(true);
+    renderTimer.setInterval(0);
+    connect(&renderTimer, &QTimer::timeout, this, &TreemapWidget::renderStep);
+
+    resizeTimer.setSingleShot(true);
+    resizeTimer.setInterval(120);
+    connect(&resizeTimer, &QTimer::timeout, this, &TreemapWidget::requestLayout);
+}
+
+void TreemapWidget::setTree(DirTreePtr tree) {
+    dirTree = tree;
+    layoutCache.clear();
+    current.clear();
+    canvas = QImage();
+    nextRect = 0;
+    hoverIndex = -1;
+    currentRoot = NO_NODE;
+    pendingRoot = tree ? tree->root() : NO_NODE;
+    requestLayout();
+}
+
+void TreemapWidget::zoomTo(NodeId node) {
+    if (!dirTree || node == NO_NODE || node == currentRoot) return;
+    pendingRoot = node;
+    requestLayout();
+}
+
+void TreemapWidget::zoomOut() {
+    if (!dirTree || currentRoot == NO_NODE) return;
+    NodeId parent = dirTree->node(currentRoot).parent;
+    if (parent != NO_NODE) zoomTo(parent);
+}
+
+void TreemapWidget::requestLayout() {
+    if (!dirTree || pendingRoot == NO_NODE || size().isEmpty()) return;
+
+    if (size() != cachedSize) {
+        layoutCache.clear();
+        cachedSize = size();
+    }
+
+    // Zooming back to a level we've already laid out at this size is free
+    auto cached = layoutCache.constFind(pendingRoot);
+    if (cached != layoutCache.constEnd()) {
+        currentRoot = pendingRoot;
+        startRender(cached.value());
+        emit zoomChanged(QString::fromStdString(dirTree->path(currentRoot)), dirTree->node(currentRoot).bytes);
+        return;
+    }
+
+    // One layout at a time; onLayoutReady() picks up whatever was requested meanwhile
+    if (layoutWatcher.isRunning()) return;
+
+    layoutTree = dirTree;
+    layoutRoot = pendingRoot;
+    layoutSize = size();
+    layoutWatcher.setFuture(QtConcurrent::run(&TreemapWidget::computeLayout,
+                                              layoutTree, layoutRoot, QSizeF(layoutSize)));
+}
+
+void TreemapWidget::onLayoutReady() {
+    TreemapLayout layout = layoutWatcher.result();
+    if (layoutTree != dirTree) {
+        requestLayout();   // tree was replaced while we were busy
+        return;
+    }
+    if (layoutSize == cachedSize) layoutCache.insert(layoutRoot, layout);
+
+    if (layoutRoot == pendingRoot && layoutSize == size()) {
+        currentRoot = layoutRoot;
+        startRender(layout);
+        emit zoomChanged(QString::fromStdString(dirTree->path(currentRoot)), dirTree->node(currentRoot).bytes);
+    } else {
+        requestLayout();
+    }
+}
+
+void TreemapWidget::startRender(const TreemapLayout &layout) {
+    current = layout;
+    hoverIndex = -1;
+    nextRect = 0;
+    canvas = QImage(size(), QImage::Format_RGB32);
+    canvas.fill(palette().color(QPalette::Window));
+    renderTimer.start();
+}
+
+void TreemapWidget::renderStep() {
+    if (canvas.isNull()) return;
+
+    QElapsedTimer budget;
+    budget.start();
+
+    QPainter painter(&canvas);
+    QFont labelFont = font();
+    labelFont.setPointSize(8);
+    painter.setFont(labelFont);
+
+    // Largest rectangles first; stop when the frame budget is used up
+    while (nextRect < current.size()) {
+        const TreemapRect &item = current[nextRect++];
+        QColor color = colorFor(item);
+        painter.fillRect(item.rect, color);
+        if (item.rect.width() > 4 && item.rect.height() > 4) {
+            painter.setPen(color.darker(140));
+            painter.drawRect(item.rect);
+        }
+        if (!item.filesBlock && item.rect.width() > 60 && item.rect.height() > HEADER * 3) {
+            painter.setPen(Qt::white);
+            QRectF header(item.rect.left() + 3, item.rect.top() + 1, item.rect.width() - 6, HEADER);
+            QString label = QString("%1  %2")
+                .arg(QString::fromStdString(dirTree->name(item.node)))
+                .arg(QString::fromStdString(Utils::formatSize(dirTree->node(item.node).bytes)));
+            painter.drawText(header, Qt::AlignLeft | Qt::AlignVCenter,
+                             painter.fontMetrics().elidedText(label, Qt::ElideRight, int(header.width())));
+        }
+        if ((nextRect & 63) == 0 && budget.elapsed() >= FRAME_BUDGET_MS) break;
+    }
+    painter.end();
+    update();
+
+    if (nextRect < current.size()) renderTimer.start();   // refine in the next idle slot
+}
+
+QColor TreemapWidget::colorFor(const TreemapRect &item) const {
+    int hue = (item.branch * 47) % 360;
+    int value = std::max(90, 235 - item.depth * 18);
+    QColor color = QColor::fromHsv(hue, 150, value);
+    return item.filesBlock ? color.lighter(125) : color;
+}
+
+void TreemapWidget::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    if (canvas.isNull()) {
+        painter.fillRect(rect(), palette().color(QPalette::Window));
+        painter.drawText(rect(), Qt::AlignCenter,
+                         dirTree ? "Computing layout..." : "Scan a folder to see its treemap");
+        return;
+    }
+    painter.drawImage(0, 0, canvas);
+
+    if (hoverIndex >= 0 && hoverIndex < current.size()) {
+        painter.setPen(QPen(QColor("#facc15"), 2));
+        painter.drawRect(current[hoverIndex].rect.adjusted(1, 1, -1, -1));
+    }
+}
+
+void TreemapWidget::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    if (dirTree) {
+        if (currentRoot != NO_NODE && !layoutWatcher.isRunning()) pendingRoot = currentRoot;
+        resizeTimer.start();
+    }
+}
+
+int TreemapWidget::rectAt(const QPointF &pos) const {
+    // Descend from the root to the deepest rectangle under the cursor, so
+    // a hit costs the depth times the siblings per level, not the whole
+    // layout. Only rectangles that have actually been drawn can be hit.
+    if (nextRect == 0 || current.isEmpty() || !current[0].rect.contains(pos)) return -1;
+    int hit = 0;
+    while (true) {
+        int inner = -1;
+        for (int child : current[hit].children) {
+            if (child < nextRect && current[child].rect.contains(pos)) {
+                inner = child;
+                break;
+            }
+        }
+        if (inner < 0) return hit;
+        hit = inner;
+    }
+}
+
+void TreemapWidget::mousePressEvent(QMouseEvent *event) {
+    if (!dirTree) return;
+    if (event->button() == Qt::RightButton) {
+        zoomOut();
+        return;
+    }
+    int index = rectAt(event->pos());
+    if (index >= 0) zoomTo(current[index].node);
+}
+
+void TreemapWidget::mouseMoveEvent(QMouseEvent *event) {
+    if (!dirTree) return;
+    int index = rectAt(event->pos());
+    if (index == hoverIndex) return;
+    hoverIndex = index;
+    update();
+
+    if (index >= 0) {
+        const TreemapRect &item = current[index];
+        QString path = QString::fromStdString(dirTree->path(item.node));
+        qulonglong bytes = item.filesBlock ? dirTree->node(item.node).directBytes
+                                           : dirTree->node(item.node).bytes;
+        emit hoverChanged(item.filesBlock ? path + " (files)" : path, bytes);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef TREEMAP_WIDGET_H
+#define TREEMAP_WIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QTimer>
+#include <QHash>
+#include <QVector>
+#include <QFutureWatcher>
+#include "dir_tree_model.h"
+
+struct TreemapRect {
+    QRectF rect;
+    NodeId node;
+    int depth;
+    int branch;        // index of the top-level child it belongs to (for colouring)
+    bool filesBlock;   // the files stored directly in `node`, not a subdirectory
+    QVector<int> children;   // layout indices of the rectangles directly inside this one
+};
+
+// Rectangles sorted by area, largest first, so rendering can stop at any
+// point and still show the most important part of the picture. The root
+// comes first; hit-testing descends from it through `children`.
+using TreemapLayout = QVector<TreemapRect>;
+
+// Squarified treemap over a DirTree. Layouts are computed on a worker
+// thread and cached per zoom root; painting happens into an off-screen
+// image a few milliseconds at a time so the event loop stays responsive.
+class TreemapWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit TreemapWidget(QWidget *parent = nullptr);
+
+    void setTree(DirTreePtr tree);
+    void zoomTo(NodeId node);
+    void zoomOut();
+    NodeId zoomRoot() const { return currentRoot; }
+
+    static TreemapLayout computeLayout(DirTreePtr tree, NodeId root, QSizeF size);
+
+signals:
+    void zoomChanged(const QString &path, qulonglong bytes);
+    void hoverChanged(const QString &path, qulonglong bytes);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private slots:
+    void onLayoutReady();
+    void renderStep();
+
+private:
+    void requestLayout();
+    void startRender(const TreemapLayout &layout);
+    int rectAt(const QPointF &pos) const;
+    QColor colorFor(const TreemapRect &item) const;
+
+    DirTreePtr dirTree;
+    NodeId currentRoot;
+    NodeId pendingRoot;
+
+    QHash<NodeId, TreemapLayout> layoutCache;   // valid for cachedSize only
+    QSize cachedSize;
+    QFutureWatcher<TreemapLayout> layoutWatcher;
+    DirTreePtr layoutTree;      // inputs of the layout currently being computed
+    NodeId layoutRoot;
+    QSize layoutSize;
+    QTimer resizeTimer;
+
+    TreemapLayout current;
+    QImage canvas;
+    int nextRect;
+    QTimer renderTimer;
+    int hoverIndex;
+};
+
+#endif // TREEMAP_WIDGET_H
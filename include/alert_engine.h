@@ -0,0 +1,142 @@
+#ifndef ALERT_ENGINE_H
+#define ALERT_ENGINE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <ctime>
+
+struct DiskSample;
+
+enum class AlertMetric {
+    FreeBytes,          // available bytes
+    FreePercent,        // available / total
+    InodesFree,
+    InodesFreePercent,
+    Growth,             // bytes per second over `window`
+    TimeToFull          // seconds, from the monitor's forecast
+};
+
+enum class AlertSeverity { Info, Warning, Critical };
+
+struct AlertRule {
+    std::string name;
+    std::string path = "*";          // "*" matches every monitored path
+    AlertMetric metric = AlertMetric::FreePercent;
+    bool below = true;               // fire when the value drops below `threshold` (else rises above)
+    double threshold = 0;
+    double clear = 0;                // hysteresis: resolve only once the value is back past this
+    time_t window = 3600;            // Growth rules only
+    time_t cooldown = 900;           // minimum time between two notifications of the rule
+    AlertSeverity severity = AlertSeverity::Warning;
+};
+
+struct Alert {
+    std::string rule;
+    std::string path;
+    AlertSeverity severity;
+    double value;
+    double threshold;
+    time_t timestamp;
+    bool resolved;                   // the condition has cleared
+    std::string message;
+};
+
+class AlertSink {
+public:
+    virtual ~AlertSink() = default;
+    virtual void deliver(const Alert& alert) = 0;
+};
+
+class StdoutAlertSink : public AlertSink {
+public:
+    void deliver(const Alert& alert) override;
+};
+
+class LogFileAlertSink : public AlertSink {
+public:
+    explicit LogFileAlertSink(const std::string& file);
+    void deliver(const Alert& alert) override;
+private:
+    std::string logFile;
+};
+
+// One JSON datagram per alert; dropped if nobody is listening
+class UnixSocketAlertSink : public AlertSink {
+public:
+    explicit UnixSocketAlertSink(const std::string& socketPath);
+    ~UnixSocketAlertSink();
+    void deliver(const Alert& alert) override;
+private:
+    std::string socketPath;
+    int fd;
+};
+
+// Runs `/bin/sh -c command` detached, with the alert in SPACEMATE_ALERT_* variables
+class ExecAlertSink : public AlertSink {
+public:
+    explicit ExecAlertSink(const std::string& command);
+    void deliver(const Alert& alert) override;
+private:
+    std::string command;
+};
+
+class CallbackAlertSink : public AlertSink {
+public:
+    explicit CallbackAlertSink(std::function<void(const Alert&)> callback) : callback(std::move(callback)) {}
+    void deliver(const Alert& alert) override { callback(alert); }
+private:
+    std::function<void(const Alert&)> callback;
+};
+
+// Evaluates threshold rules against monitor samples. Rules are indexed by
+// path, so a sample only touches the rules for its own path plus the
+// wildcard ones. Configuration lives in ~/.spacemate/alerts.conf:
+//
+//   rule name=root-low path=/ metric=free_percent below=10 clear=12 cooldown=15m severity=critical
+//   rule name=fast-growth metric=growth above=5G/h window=30m
+//   sink stdout | sink log <file> | sink socket <path> | sink exec <command>
+class AlertEngine {
+public:
+    using GrowthProvider = std::function<double(const std::string& path, time_t window)>;
+
+    static std::string defaultConfigFile();
+    bool loadConfig(const std::string& file, std::string* error = nullptr);
+    void loadDefaults();   // the old 75% used warning plus low-space, low-inode and time-to-full rules
+
+    void addRule(const AlertRule& rule);
+    void clearRules();
+    std::vector<AlertRule> rules() const;
+
+    void addSink(std::shared_ptr<AlertSink> sink);
+    void removeSink(const std::shared_ptr<AlertSink>& sink);
+    void clearSinks();
+    size_t sinkCount() const;
+
+    // Returns the alerts raised or resolved by this sample (already delivered to the sinks)
+    std::vector<Alert> evaluate(const DiskSample& sample, const GrowthProvider& growth = nullptr);
+
+    static std::string metricName(AlertMetric metric);
+    static std::string severityName(AlertSeverity severity);
+    static std::string formatValue(AlertMetric metric, double value);
+
+private:
+    struct RuleState {
+        bool active = false;
+        time_t lastNotified = 0;
+    };
+
+    void indexRule(size_t index);
+
+    mutable std::mutex engineMutex;
+    std::vector<AlertRule> ruleList;
+    std::vector<std::unordered_map<std::string, RuleState>> states;   // per rule, per path
+    std::unordered_map<std::string, std::vector<size_t>> rulesByPath;
+    std::vector<size_t> wildcardRules;
+    std::vector<std::shared_ptr<AlertSink>> sinks;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef BACKUP_GC_H
+#define BACKUP_GC_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "backup_manager.h"
+
+// Which backups to keep; a zero field does not limit anything
+struct RetentionPolicy {
+    size_t keepLast = 0;               // newest sessions kept
+    int keepDays = 0;                  // sessions older than this are removed
+    unsigned long long maxBytes = 0;   // stored bytes of all backups
+
+    bool limited() const { return keepLast > 0 || keepDays > 0 || maxBytes > 0; }
+};
+
+// What a policy removes, worked out from the index alone
+struct GcPlan {
+    std::vector<uint64_t> evict;          // entry ids, oldest session first
+    std::vector<std::string> packs;       // packs holding evicted objects
+    size_t sessions = 0;
+    size_t evictedSessions = 0;
+    unsigned long long storedBytes = 0;   // in the store before collecting
+    unsigned long long freedBytes = 0;    // objects only evicted entries use
+};
+
+struct GcReport {
+    size_t entriesRemoved = 0;
+    size_t filesRemoved = 0;            // objects and packs, orphans included
+    size_t packsRewritten = 0;
+    unsigned long long bytesFreed = 0;
+    double seconds = 0;
+};
+
+// Enforces a RetentionPolicy on the backup store. Backups are kept or
+// removed a session at a time, oldest first. plan() reads only the
+// index: an object's space counts as freed once no kept entry refers
+// to it (reference counts per stored object).
+//
+// run() tombstones the planned entries in batches, deleting each
+// batch's unreferenced objects and packs as it goes. A pack that still
+// holds live objects is rewritten with just those once less than half
+// of it is live. Last, objects and packs no entry refers to (left by
+// interrupted sessions) are swept; only files untouched for a day.
+// Rewriting and sweeping hold the StoreLock exclusively, so they wait
+// for sessions that have not written their entries yet.
+class BackupGc {
+public:
+    explicit BackupGc(BackupManager& manager);
+
+    // [backup] keep_last, keep_days and max_size from ~/.spacematerc;
+    // [cleanup] backup_retention_days stands in for keep_days
+    static RetentionPolicy loadPolicy();
+
+    GcPlan plan(const RetentionPolicy& policy);
+    GcReport run(const GcPlan& plan, size_t batchSize = 512);
+
+private:
+    void rewritePacks(const std::vector<std::string>& packs, GcReport& report);
+    void sweep(GcReport& report);
+
+    BackupManager& backups;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef BACKUP_INDEX_H
+#define BACKUP_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include <ctime>
+#include <sys/types.h>
+
+struct BackupEntry {
+    uint64_t id = 0;    // assigned by BackupIndex::append
+    std::string originalPath;
+    std::string backupPath;
+    unsigned long long size = 0;
+    std::string timestamp;
+    std::string hash;   // object id in the store; empty for plain copies made before it
+    unsigned long long storedSize = 0;   // on disk; below `size` when compressed
+    std::string codec = "none";
+    // The original's metadata; identical files share one stored object,
+    // so restores take it from here. mode is st_mode; 0: not recorded
+    // (older entries)
+    uint32_t mode = 0;
+    uint32_t uid = 0;
+    uint32_t gid = 0;
+    struct timespec mtime = {0, 0};
+};
+
+// Backup history in backup/index.bin: a versioned header followed by an
+// append-only log of length-prefixed records: an entry, a tombstone
+// naming a removed entry's id, or a move of every entry stored in one
+// file to another (a rewritten pack). Strings are length-prefixed,
+// so any character may appear in a path.
+//
+// The file is memory-mapped and parsed once; later reads only parse
+// what was appended since (by this or another process), and a file
+// replaced by compaction is noticed by its inode and read again.
+// Lookups by id, original path and stored file are hash-map lookups.
+// Writers hold an flock on the file. Compaction rewrites only the live
+// entries once tombstoned ones outnumber them, after a record of the
+// next id so removed ids are not reused.
+class BackupIndex {
+public:
+    explicit BackupIndex(const std::string& file);
+    BackupIndex(const BackupIndex&) = delete;
+    BackupIndex& operator=(const BackupIndex&) = delete;
+
+    const std::string& file() const { return indexFile; }
+
+    std::vector<BackupEntry> entries();   // live entries, oldest first
+    bool find(uint64_t id, BackupEntry& entry);
+    std::vector<BackupEntry> forPath(const std::string& originalPath);
+    size_t references(const std::string& backupPath);   // live entries stored in this file
+    size_t size();
+
+    bool append(std::vector<BackupEntry>& added);   // sets their ids
+    bool remove(const std::vector<uint64_t>& ids);  // appends tombstones
+    bool relocate(const std::string& from, const std::string& to);   // synced before it returns
+    bool compact();
+
+private:
+    bool refresh();   // caller holds indexMutex
+    void apply(const char* record, uint8_t type, uint32_t length);
+    void reset();
+
+    std::string indexFile;
+    std::mutex indexMutex;
+    std::vector<BackupEntry> records;                  // in log order; removed ones stay until compaction
+    std::vector<bool> live;
+    std::unordered_map<uint64_t, size_t> byId;         // id -> slot in records
+    std::unordered_map<std::string, std::vector<size_t>> byPath;
+    std::unordered_map<std::string, size_t> referenceCount;   // backupPath -> live entries
+    size_t liveCount = 0;
+    uint64_t nextId = 1;
+    off_t parsedTo = 0;   // file offset up to which records are applied
+    ino_t parsedInode = 0;
+    uint32_t parsedGeneration = 0;
+};
+
+#endif
@@ -5,41 +5,102 @@
 #include <vector>
 #include <filesystem>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include "backup_index.h"
+#include "copy_engine.h"
+#include "compressor.h"
+#include "pack_store.h"
+#include "dir_sync.h"
 
 namespace fs = std::filesystem;
 
-struct BackupEntry {
-    std::string originalPath;
-    std::string backupPath;
-    unsigned long long size;
-    std::string timestamp;
+struct RestoreSelection;   // backup_restorer.h
+struct RestoreOptions;
+
+// What BackupManager::removeBackups deleted
+struct RemovalReport {
+    size_t entries = 0;
+    size_t files = 0;                 // stored files and packs no entry used any more
+    unsigned long long bytes = 0;
 };
 
 class BackupManager {
 public:
     // ===== Existing CLI method =====
+    // One file in a session of its own; use BackupSession for many files
     std::string createBackup(const std::string& filepath);
 
     // ===== New method for GUI =====
+    // Incremental: only changed files are copied and only deleted ones
+    // removed (DirSync); [backup] sync_compare_hashes in ~/.spacematerc
+    // also compares content
     std::string createBackup(const std::string& source, const std::string& dest);
 
     // Optional alias for GUI calls if needed
     std::string createBackupGUI(const std::string& source, const std::string& dest);
 
     void restoreFiles();
+    // Restores every backup the selection matches without asking
+    // (BackupRestorer), or lists what it would restore; false if
+    // nothing matched or any file failed
+    bool restoreBackups(const RestoreSelection& selection, const RestoreOptions& options, bool dryRun);
     void showBackups();
+    // Applies the retention policy in ~/.spacematerc (BackupGc) and
+    // prints what it removed, or would remove
+    void collectGarbage(bool dryRun);
+    // Rechecks stored objects against their checksums (BackupVerifier),
+    // continuing an unfinished pass unless `restart`; prints what is
+    // corrupt or missing. False if anything is.
+    bool verifyBackups(size_t threads, double timeLimit, bool restart);
+    // Copies an entry's content to `dest`, decompressing as it streams;
+    // packed entries are read back from their pack (through `pack` when
+    // given, open on entry.backupPath). Mode, owner and mtime come from
+    // the entry, not the shared object.
+    static CopyResult restoreEntry(const BackupEntry& entry, const std::string& dest, PackReader* pack = nullptr);
 
     // Public so GUI can access backup directory path
     std::string getBackupDir();
+    // Content-addressed ObjectStore that session backups go into
+    std::string getObjectDir();
+    // [backup] compression, compression_level and compression_threads
+    // from ~/.spacematerc; off unless configured
+    const CompressionSettings& getCompression();
+    // [backup] pack_small_files, pack_threshold_kb and pack_size_mb; off
+    // unless configured
+    const PackSettings& getPacking();
+
+    // backup/index.bin; an index.txt from older versions is migrated on first use
+    BackupIndex& getIndex();
 
     // Make loadBackupIndex public so GUI can access backup history
     std::vector<BackupEntry> loadBackupIndex();
     
     // Add backup entry to index
     void addBackupIndexEntry(const std::string& originalPath, const std::string& backupPath);
+    // Many entries in one write (BackupSession::commit); sets their ids
+    bool appendIndexEntries(std::vector<BackupEntry>& entries);
+    // Tombstones these entries and deletes the stored files no remaining
+    // entry refers to; returns the entries removed
+    size_t removeBackups(const std::vector<uint64_t>& ids);
+
+    // Bytes, time and mechanism of the last backup or restore copy
+    const CopyResult& lastCopy() const { return lastCopyResult; }
+    // What the last createBackup(source, dest) copied, kept and removed
+    const SyncReport& lastSync() const { return lastSyncReport; }
+    const RemovalReport& lastRemoval() const { return lastRemovalReport; }
 
 private:
-    bool copyFile(const std::string& source, const std::string& dest);
+    CopyResult lastCopyResult;
+    SyncReport lastSyncReport;
+    RemovalReport lastRemovalReport;
+    std::string backupDir;   // created once, on first use
+    CompressionSettings compression;
+    bool compressionLoaded = false;
+    PackSettings packing;
+    bool packingLoaded = false;
+    std::unique_ptr<BackupIndex> index;
+    std::mutex indexMutex;   // guards creating `index`
 };
 
 #endif
@@ -0,0 +1,81 @@
+#ifndef BACKUP_RESTORER_H
+#define BACKUP_RESTORER_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include <functional>
+#include "backup_manager.h"
+
+// What to do when a file is already where a backup would go
+enum class RestoreConflict { Skip, Overwrite, Rename };
+
+// Which backups to restore; empty fields select everything. Of several
+// matching backups of one file, the newest is restored.
+struct RestoreSelection {
+    std::string session;      // a session's timestamp, or "latest"
+    std::string pathPrefix;   // originals at or under this path
+    time_t before = 0;        // sessions started before this time
+};
+
+struct RestoreOptions {
+    std::string targetDir;    // original paths are recreated under it; empty = in place
+    RestoreConflict conflict = RestoreConflict::Skip;
+    size_t threads = 4;       // stored files restored at once
+};
+
+// One backup and where it goes
+struct RestoreItem {
+    BackupEntry entry;
+    std::string dest;
+    bool replaces = false;    // overwrites an existing file
+};
+
+// Worked out before anything is written, so it doubles as a dry run
+struct RestorePlan {
+    std::vector<RestoreItem> items;
+    size_t skipped = 0;       // destinations that exist, with Skip
+    size_t renamed = 0;       // restored next to the existing file
+    unsigned long long bytes = 0;
+};
+
+struct RestoreReport {
+    size_t restored = 0;
+    size_t skipped = 0;
+    size_t renamed = 0;
+    size_t failed = 0;
+    unsigned long long bytes = 0;
+    double seconds = 0;
+    std::vector<std::string> failures;   // "original: reason"
+
+    double bytesPerSecond() const { return seconds > 0 ? bytes / seconds : 0.0; }
+};
+
+// Restores many backups without asking. Entries are picked from the
+// index (select), resolved to destinations under the conflict policy
+// (plan), then restored on a TaskPool (run): each loose object is a
+// task of its own and goes through the same path as a single restore
+// (copy_file_range for plain objects), and each pack is one task that
+// reads its index once for all of its objects.
+//
+// Every file is written to a temporary name next to its destination
+// and renamed into place, so an interrupted restore never leaves a
+// partial file where the original belongs.
+class BackupRestorer {
+public:
+    using Progress = std::function<void(size_t done, size_t total)>;
+
+    explicit BackupRestorer(BackupManager& manager);
+
+    std::vector<BackupEntry> select(const RestoreSelection& selection);
+    static RestorePlan plan(const std::vector<BackupEntry>& entries, const RestoreOptions& options);
+    static RestoreReport run(const RestorePlan& plan, const RestoreOptions& options, Progress progress = nullptr);
+
+    // "skip", "overwrite" or "rename"
+    static bool parseConflict(const std::string& name, RestoreConflict& conflict);
+
+private:
+    BackupManager& backups;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef BACKUP_SESSION_H
+#define BACKUP_SESSION_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include "backup_manager.h"
+#include "object_store.h"
+#include "task_pool.h"
+
+struct SessionReport {
+    size_t files = 0;
+    size_t failed = 0;
+    size_t deduplicated = 0;            // files whose content was already stored
+    unsigned long long bytes = 0;
+    unsigned long long storedBytes = 0; // newly written to the store
+    double seconds = 0;
+    bool indexFailed = false;           // entries not written; every file counts as failed
+
+    double bytesPerSecond() const { return seconds > 0 ? bytes / seconds : 0.0; }
+};
+
+// Backs up many files as one unit: every file goes into the backup
+// dir's ObjectStore (content already stored is not copied again), the
+// work runs on a TaskPool (so at most a few files are in flight), and
+// all index entries, tagged with the session id, are appended in one
+// write at commit(). From the first add() until then the session holds
+// the store's StoreLock shared, so a concurrent gc cannot collect an
+// object it reused before its entry is written.
+class BackupSession {
+public:
+    explicit BackupSession(BackupManager& manager, size_t parallelism = TaskPool::defaultThreads());
+    ~BackupSession();   // commits if commit() was not called
+    BackupSession(const BackupSession&) = delete;
+    BackupSession& operator=(const BackupSession&) = delete;
+
+    bool isOpen() const { return opened; }
+    const std::string& id() const { return sessionId; }
+
+    // Queues a copy; blocks while too many are waiting
+    void add(const std::string& path);
+    // Waits for the copies and writes their index entries; false if any
+    // failed. If the index cannot be written, no file is backed up.
+    bool commit();
+
+    size_t completed() const { return done; }   // copies finished so far, for progress
+    const std::vector<BackupEntry>& entries() const { return backedUp; }   // after commit()
+    const std::vector<std::string>& failures() const { return failed; }
+    const SessionReport& report() const { return summary; }
+
+private:
+    void store(const std::string& path);
+
+    BackupManager& backups;
+    ObjectStore objects;
+    std::string sessionId;
+    bool opened = false;
+    std::unique_ptr<TaskPool> pool;
+    std::unique_ptr<StoreLock> storeLock;   // from the first add() through commit()
+    std::mutex sessionMutex;            // guards the containers below
+    std::vector<BackupEntry> backedUp;
+    std::vector<std::string> failed;
+    std::atomic<size_t> done{0};
+    SessionReport summary;
+    std::chrono::steady_clock::time_point started;
+    bool committed = false;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef BACKUP_VERIFIER_H
+#define BACKUP_VERIFIER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "backup_manager.h"
+
+struct VerifyOptions {
+    size_t threads = 2;      // stored files read at once; bounds the I/O
+    double timeLimit = 0;    // seconds, 0 = until done; stops at a checkpoint
+    bool restart = false;    // ignore the checkpoint of an unfinished pass
+};
+
+// A stored object that is gone or no longer matches its checksum
+struct VerifyProblem {
+    std::string path;
+    std::string hash;
+    bool missing = false;
+    std::vector<std::string> originals;   // backups that use it
+};
+
+struct VerifyReport {
+    size_t files = 0;        // stored files (objects and packs) in the index
+    size_t checked = 0;      // this run
+    size_t skipped = 0;      // done by an earlier run of this pass
+    size_t objects = 0;      // objects hashed this run; a pack holds many
+    size_t unchecked = 0;    // plain copies from before checksums were kept
+    unsigned long long bytes = 0;
+    double seconds = 0;
+    bool complete = false;   // the pass reached the end
+    std::vector<VerifyProblem> problems;
+
+    double bytesPerSecond() const { return seconds > 0 ? bytes / seconds : 0.0; }
+};
+
+// Rechecks the backup store against the SHA-256 every object was stored
+// under: loose objects are hashed (compressed ones as they decompress),
+// packs are read once each and every referenced object in them hashed.
+// Stored files are checked in path order on a TaskPool, a few at a time.
+//
+// A pass can be spread over several runs: backup/verify.checkpoint
+// holds the last stored file up to which everything was checked, and
+// the next run continues after it. The file is removed once a pass
+// completes.
+class BackupVerifier {
+public:
+    using Progress = std::function<void(size_t done, size_t total)>;
+
+    explicit BackupVerifier(BackupManager& manager);
+
+    VerifyReport run(const VerifyOptions& options, Progress progress = nullptr);
+    std::string checkpointFile();
+
+private:
+    BackupManager& backups;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "copy_engine.h"
+
+// zlib is always built in; zstd and LZ4 when the build found them
+// (SPACEMATE_WITH_ZSTD / SPACEMATE_WITH_LZ4)
+enum class Codec : uint8_t {
+    None = 0,
+    Zlib = 1,
+    Zstd = 2,
+    Lz4 = 3
+};
+
+struct CompressionSettings {
+    Codec codec = Codec::None;
+    int level = 0;                          // 0: the codec's default
+    size_t chunkSize = 1 << 20;
+    size_t threads = 1;                     // chunks compressed at once in large files
+    unsigned long long minimumSize = 4096;  // smaller files are stored as they are
+};
+
+// Streaming compression of backup objects. A compressed file is a
+// small header followed by independently compressed chunks, so large
+// files compress on several threads and decompress with one chunk in
+// memory. A chunk that does not shrink is stored raw.
+//
+//   header: "SMZ1", codec (1 byte), 3 reserved, chunk size (u32),
+//           original size (u64)
+//   chunk:  raw length (u32), stored length (u32), data
+//
+// Integers are little-endian. Mode and timestamps of the source are
+// kept on the compressed file and given back on decompression.
+class Compressor {
+public:
+    static bool available(Codec codec);
+    static const char* name(Codec codec);
+    static bool parse(const std::string& name, Codec& codec);
+
+    // False for already compressed formats (by extension) and for data
+    // whose sampled byte entropy is too high to gain anything
+    static bool worthCompressing(const std::string& path);
+
+    // `bytes` in the result is the size written; a digest is fed the
+    // original content as it is read
+    static CopyResult compressFile(const std::string& source, const std::string& dest,
+                                   const CompressionSettings& settings, Sha256* digest = nullptr);
+    // `bytes` in the result is the size restored
+    static CopyResult decompressFile(const std::string& source, const std::string& dest);
+    // SHA-256 of the original content, decompressed as it streams; empty
+    // if the file cannot be read or does not decompress
+    static std::string hashContent(const std::string& source);
+
+    // One block held in memory (small packed objects): the compressed
+    // form, or empty when it did not shrink; `raw` must be sized to the
+    // original length for decompression
+    static std::vector<char> compressBlock(Codec codec, int level, const std::vector<char>& raw);
+    static bool decompressBlock(Codec codec, const std::vector<char>& stored, std::vector<char>& raw);
+
+    // Codec and original size from a compressed file's header
+    static bool readHeader(const std::string& path, Codec& codec, unsigned long long& originalSize);
+};
+
+#endif
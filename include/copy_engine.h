@@ -0,0 +1,41 @@
+#ifndef COPY_ENGINE_H
+#define COPY_ENGINE_H
+
+#include <string>
+#include "sha256.h"
+
+// Outcome of one copy; `method` is the fastest mechanism that took part
+struct CopyResult {
+    bool ok = false;
+    unsigned long long bytes = 0;
+    unsigned long long files = 0;
+    double seconds = 0;
+    std::string method;
+    int error = 0;   // errno of the failure
+
+    double bytesPerSecond() const { return seconds > 0 ? bytes / seconds : 0.0; }
+};
+
+// File copies that stay in the kernel where possible. copy_file_range
+// comes first: same-filesystem copies may become reflinks or
+// server-side copies (NFS 4.2, SMB), and nothing passes through user
+// space. sendfile follows when the kernel refuses (older kernels,
+// cross-filesystem), then a read/write loop with a large buffer. Each
+// stage picks up at the offset the previous one reached.
+//
+// Mode and timestamps (and ownership, when permitted) are copied over.
+//
+// With a digest, the copy goes through the read/write loop instead and
+// hashes each buffer as it passes, so the checksum costs no extra read.
+class CopyEngine {
+public:
+    static CopyResult copyFile(const std::string& source, const std::string& dest, Sha256* digest = nullptr);
+    // Directories are created, regular files copied with copyFile and
+    // symlinks recreated. A file source is copied into `dest` when that
+    // is a directory.
+    static CopyResult copyTree(const std::string& source, const std::string& dest);
+
+    static const size_t BUFFER_SIZE = 1 << 20;   // read/write fallback
+};
+
+#endif
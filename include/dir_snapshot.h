@@ -0,0 +1,75 @@
+#ifndef DIR_SNAPSHOT_H
+#define DIR_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <ctime>
+#include <utility>
+
+// A directory that grew (or shrank) between two snapshots
+struct DirGrowth {
+    std::string path;
+    long long bytesDelta = 0;            // whole subtree
+    long long filesDelta = 0;            // whole subtree
+    unsigned long long bytes = 0;        // subtree size in the newer snapshot
+    unsigned long long files = 0;
+};
+
+struct SnapshotStats {
+    size_t directoriesRead = 0;      // mtime changed (or new): entries listed and stat'ed
+    size_t directoriesReused = 0;    // mtime unchanged: only the directory and its large files stat'ed
+    double elapsedSeconds = 0;
+};
+
+// Per-directory size aggregates of one filesystem subtree. A snapshot taken
+// against the previous one only lists directories whose mtime changed; for
+// the rest it reuses the previous listing and re-stats just the files of
+// LARGE_FILE bytes or more, so a growing log is still seen while a tree of
+// unchanged small files costs one stat per directory. (Small files that
+// grow in place without touching their directory are the blind spot.)
+// The walk stays on the filesystem of the root and does not follow symlinks.
+class DirSnapshot {
+public:
+    static const unsigned long long LARGE_FILE = 1024 * 1024;
+
+    static std::shared_ptr<DirSnapshot> take(const std::string& root,
+                                             const DirSnapshot* previous = nullptr,
+                                             SnapshotStats* stats = nullptr);
+
+    const std::string& rootPath() const { return rootDir; }
+    time_t takenAt() const { return timestamp; }
+    size_t directoryCount() const { return dirs.size(); }
+    unsigned long long bytes(const std::string& path) const;   // subtree, 0 if unknown
+    unsigned long long files(const std::string& path) const;
+
+    // Directories of `newer` that grew the most since `older`, by bytes or by
+    // file count. A directory whose growth is almost all inside one of its
+    // subdirectories is left out in favour of that subdirectory, so the list
+    // names the place the data actually went rather than all its ancestors.
+    static std::vector<DirGrowth> topGrowers(const DirSnapshot& older, const DirSnapshot& newer,
+                                             size_t limit, bool byFiles = false);
+
+private:
+    struct Dir {
+        time_t mtime = 0;
+        long mtimeNsec = 0;
+        time_t readAt = 0;                  // when the entries were last listed
+        unsigned long long smallBytes = 0;  // files under LARGE_FILE
+        unsigned long long directFiles = 0;
+        std::vector<std::pair<std::string, unsigned long long>> largeFiles;
+        std::vector<std::string> subdirs;
+        unsigned long long bytes = 0;       // whole subtree
+        unsigned long long files = 0;
+    };
+
+    explicit DirSnapshot(const std::string& root) : rootDir(root), timestamp(0) {}
+    static std::string parentOf(const std::string& path);
+
+    std::string rootDir;
+    time_t timestamp;
+    std::map<std::string, Dir> dirs;   // a parent always sorts before its children
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef DIR_SYNC_H
+#define DIR_SYNC_H
+
+#include <string>
+#include "task_pool.h"
+
+struct SyncOptions {
+    bool compareHashes = false;   // also compare SHA-256 when size and mtime match
+    bool removeDeleted = true;    // delete what is gone from the source
+    size_t threads = TaskPool::defaultThreads();
+};
+
+struct SyncReport {
+    unsigned long long files = 0;       // regular files in the source
+    unsigned long long copied = 0;
+    unsigned long long unchanged = 0;
+    unsigned long long removed = 0;     // entries deleted from the destination
+    unsigned long long failed = 0;
+    unsigned long long bytesCopied = 0;
+    double seconds = 0;
+    int error = 0;                      // errno of the first failure
+
+    bool ok() const { return failed == 0 && error == 0; }
+    double bytesPerSecond() const { return seconds > 0 ? bytesCopied / seconds : 0.0; }
+};
+
+// Makes `dest` a mirror of `source` doing only the work that changed.
+// Files are compared by size and modification time (CopyEngine keeps
+// both, so an unchanged file matches exactly), optionally also by
+// content hash; only differing files are copied, and only entries that
+// no longer exist in the source are removed. The comparisons and the
+// copies run on a TaskPool while the source tree is being walked.
+class DirSync {
+public:
+    static SyncReport sync(const std::string& source, const std::string& dest,
+                           const SyncOptions& options = SyncOptions());
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef DIR_TREE_H
+#define DIR_TREE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <ctime>
+
+using NodeId = uint32_t;
+const NodeId NO_NODE = UINT32_MAX;
+
+// One directory in the aggregated tree. Nodes live in a single contiguous
+// arena and refer to each other by index; children form a singly linked
+// list (firstChild -> nextSibling) so no per-node allocation is needed.
+struct DirNode {
+    NodeId parent = NO_NODE;
+    NodeId firstChild = NO_NODE;
+    NodeId nextSibling = NO_NODE;
+    uint32_t childCount = 0;          // direct subdirectories
+    uint32_t nameOffset = 0;          // into the name pool
+    uint32_t nameLength = 0;
+    unsigned long long directBytes = 0;
+    unsigned long long directFiles = 0;
+    unsigned long long directEntries = 0;  // every entry: files, subdirectories, symlinks, ...
+    unsigned long long bytes = 0;     // whole subtree, valid after finalize()
+    unsigned long long files = 0;     // whole subtree, valid after finalize()
+    unsigned long long entries = 0;   // whole subtree, i.e. the inodes it holds; valid after finalize()
+    time_t maxMtime = 0;              // newest file mtime in the subtree
+};
+
+class DirTree {
+public:
+    explicit DirTree(const std::string& rootPath);
+
+    // Walk a directory once (lstat, no symlink following) and aggregate it
+    static std::shared_ptr<DirTree> build(const std::string& path);
+
+    // ===== Builder interface (used by scanners that walk on their own) =====
+    NodeId addDirectory(NodeId parent, const std::string& name);
+    void addFile(NodeId parent, unsigned long long size, time_t mtime);
+    void addEntry(NodeId parent);   // anything that is neither a file nor a directory
+    void finalize();   // propagate subtree totals bottom-up
+
+    // ===== Queries =====
+    NodeId root() const { return 0; }
+    size_t size() const { return nodes.size(); }
+    const DirNode& node(NodeId id) const { return nodes[id]; }
+    std::string name(NodeId id) const;
+    std::string path(NodeId id) const;
+    const std::string& rootPath() const { return rootDir; }
+
+    // O(children); never touches the filesystem
+    std::vector<NodeId> children(NodeId id) const;
+    std::vector<NodeId> largestChildren(NodeId id, size_t limit) const;
+    // Directories anywhere in the tree ranked by entry count, direct or
+    // whole subtree (the root itself is left out of the subtree ranking)
+    std::vector<NodeId> busiestDirectories(size_t limit, bool subtree = false) const;
+
+private:
+    std::string rootDir;
+    std::vector<DirNode> nodes;   // arena; a child always has a larger index than its parent
+    std::vector<char> namePool;
+};
+
+#endif
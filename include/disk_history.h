@@ -0,0 +1,83 @@
+#ifndef DISK_HISTORY_H
+#define DISK_HISTORY_H
+
+#include <vector>
+#include <ctime>
+#include <cstddef>
+
+// Fixed-capacity circular buffer; the oldest element is overwritten
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity) : items(capacity), head(0), count(0) {}
+
+    void push(const T& item) {
+        items[head] = item;
+        head = (head + 1) % items.size();
+        if (count < items.size()) count++;
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return items.size(); }
+    bool empty() const { return count == 0; }
+
+    // 0 is the oldest element, size() - 1 the newest
+    const T& operator[](size_t i) const { return items[(head + items.size() - count + i) % items.size()]; }
+    const T& back() const { return (*this)[count - 1]; }
+
+private:
+    std::vector<T> items;
+    size_t head;
+    size_t count;
+};
+
+struct HistoryPoint {
+    time_t timestamp;
+    unsigned long long used;        // total - available, i.e. what counts towards "full"
+    unsigned long long available;
+    unsigned long long inodesFree;
+};
+
+struct Forecast {
+    double fillRate = 0;        // bytes per second, positive while filling
+    double secondsToFull = -1;  // -1 when the filesystem is not filling up
+    bool reliable = false;      // enough history behind the numbers
+};
+
+// Per-filesystem usage history in three resolutions: every sample, one per
+// minute, and one per hour, each in a fixed-size ring so memory does not
+// grow with uptime. A Holt (double exponential smoothing) model runs over
+// the minute series to estimate the fill rate and time until full.
+class UsageHistory {
+public:
+    enum Resolution { Seconds, Minutes, Hours };
+
+    UsageHistory(size_t secondSlots = 600, size_t minuteSlots = 1440, size_t hourSlots = 24 * 90);
+
+    void add(const HistoryPoint& point);
+    const RingBuffer<HistoryPoint>& series(Resolution resolution) const;
+    bool empty() const { return seconds.empty(); }
+    const HistoryPoint& latest() const { return seconds.back(); }
+
+    // Least-squares growth of used bytes over the last `window` seconds,
+    // taken from the finest series that still covers the window
+    double fillRate(time_t window) const;
+    // Change in used bytes per second between now and `window` ago; O(log n)
+    double growth(time_t window) const;
+    Forecast forecast() const;
+
+private:
+    void updateModel(const HistoryPoint& point);
+
+    RingBuffer<HistoryPoint> seconds;
+    RingBuffer<HistoryPoint> minutes;
+    RingBuffer<HistoryPoint> hours;
+
+    // Holt state over the minute series
+    double level;
+    double trend;      // bytes per second
+    time_t modelTime;
+    size_t modelUpdates;
+};
+
+#endif
@@ -7,33 +7,162 @@
 #include <utility> // for std::pair
 #include <thread>  // for optional background monitoring
 #include <atomic>  // for thread-safe monitoring flag
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <map>
+#include <ctime>
+#include <cstdint>
+#include <memory>
+#include "disk_history.h"
+#include "history_store.h"
+#include "alert_engine.h"
+#include "dir_snapshot.h"
+#include "folder_stats.h"
+
+class DirTree;
+
+// One statvfs reading of a monitored filesystem
+struct DiskSample {
+    std::string path;
+    time_t timestamp = 0;
+    unsigned long long total = 0;
+    unsigned long long free = 0;        // includes root-reserved blocks
+    unsigned long long available = 0;   // usable by unprivileged users
+    unsigned long long inodesTotal = 0;
+    unsigned long long inodesFree = 0;
+    double fillRate = 0;                // bytes/s from the path's history
+    double secondsToFull = -1;          // -1 when not filling up
+
+    unsigned long long used() const { return total - free; }
+    double usedPercent() const { return total ? (total - available) * 100.0 / total : 0.0; }
+    double inodesUsedPercent() const { return inodesTotal ? (inodesTotal - inodesFree) * 100.0 / inodesTotal : 0.0; }
+};
 
 class DiskMonitor {
 public:
+    using SubscriptionId = uint64_t;
+    using SampleCallback = std::function<void(const DiskSample&)>;
+    using GrowthCallback = std::function<void(const std::string& path,
+                                              const std::vector<DirGrowth>& byBytes,
+                                              const std::vector<DirGrowth>& byFiles)>;
+    using FolderStatsCallback = std::function<void(const FolderStats&)>;
+
+    DiskMonitor() = default;
+    // Stops monitoring and the folder-stats job. Never destroy the monitor
+    // from one of its own callbacks: the threads that run them are joined
+    // here, and a thread cannot join itself (asserted for the monitor thread).
+    ~DiskMonitor();
+    DiskMonitor(const DiskMonitor&) = delete;
+    DiskMonitor& operator=(const DiskMonitor&) = delete;
+
     // ===== Existing CLI methods =====
     void scanPath(const std::string& path, bool verbose = false);
     void showDiskUsage(const std::string& path);
     void showLargestDirectories(const std::string& path, int limit = 5);
+    void estimatePath(const std::string& path, double seconds = 10.0, int limit = 5);
+    void monitorPath(const std::string& path, double intervalSeconds = 1.0, double durationSeconds = 0,
+                     double growthSeconds = 60);
+    void watchPath(const std::string& path, double durationSeconds = 0);   // live index driven by fs events
+    void showHistory(const std::string& path, time_t from, time_t to, bool json = false);  // empty path lists mounts
+    void compactHistory();
 
     // ===== GUI-friendly methods =====
     std::vector<std::pair<std::string, long long>> getLargestDirectories(const std::string& path, int limit = 5);
     std::vector<std::pair<std::string, long long>> getDiskInfo(const std::string& path);
+    static bool takeSample(const std::string& path, DiskSample& sample);
+
+    // ===== Monitoring service =====
+    // Subscribers are called on the monitor thread, only when a sample
+    // differs from the last one delivered for that path. Once unsubscribe()
+    // returns the callback is not running and will not be called again.
+    SubscriptionId subscribe(SampleCallback callback);
+    void unsubscribe(SubscriptionId id);
+    // Called after each directory snapshot that found growth (see setGrowthTracking)
+    SubscriptionId subscribeGrowth(GrowthCallback callback);
+    // Called on the folder-stats thread whenever startFolderStats' folder changed
+    SubscriptionId subscribeFolderStats(FolderStatsCallback callback);
+
+    void setInterval(std::chrono::milliseconds interval);
+    void setChangeThreshold(unsigned long long bytes);  // ignore smaller changes in free space
+    // Every `interval` the monitor thread snapshots each monitored tree and
+    // diffs it against the previous snapshot; only directories whose mtime
+    // changed are listed again. Off (0) by default since the first snapshot
+    // is a full walk and delays sampling while it runs.
+    void setGrowthTracking(std::chrono::seconds interval);
 
-    // Optional monitoring GUI features
     void startMonitoring(const std::string& path = "/"); // monitor a specific path
-    void stopMonitoring();
+    void addPath(const std::string& path);               // monitor another path on the running service
+    void stopMonitoring();                               // wakes and joins the monitor thread (only signals from a callback)
     bool isMonitoring() const { return monitoring; }
+    bool lastSample(const std::string& path, DiskSample& sample) const;
+
+    // File, duplicate, old and temp-file counts of one folder, computed in
+    // the background and kept current from filesystem events (FolderStatsJob)
+    void startFolderStats(const std::string& path);
+    void stopFolderStats();   // also saves the hash cache
+    bool lastFolderStats(FolderStats& stats) const;
+
+    // Samples are persisted to the history store (on by default) and a
+    // restarted service reloads the last 90 days of a path's history
+    void setPersistence(bool enabled, const std::string& file = HistoryStore::defaultFile());
+
+    // Every sample (changed or not) is kept in a per-path UsageHistory
+    Forecast forecast(const std::string& path) const;
+    double fillRate(const std::string& path, time_t window) const;
+    double growth(const std::string& path, time_t window) const;
+    // Directories that grew the most between the last two snapshots of `path`
+    std::vector<DirGrowth> topGrowers(const std::string& path, size_t limit = 5, bool byFiles = false) const;
+
+    // Rules are evaluated against every sample, changed or not
+    AlertEngine& alertEngine() { return alerts; }
+    std::vector<HistoryPoint> history(const std::string& path, UsageHistory::Resolution resolution) const;
 
 private:
+    // scanPath walks the tree once and feeds both reports from it
+    void showLargestDirectories(const DirTree& tree, int limit);
+    void showEntryHotspots(const DirTree& tree, int limit);
     void printProgressBar(double percentage);
     std::string formatSize(unsigned long long bytes);
 
-    // Internal GUI flags
-    std::atomic<bool> monitoring{false};   // atomic for thread safety
-    std::thread monitorThread;             // optional background thread
-    std::string monitoredPath;             // path currently being monitored
+    bool hasChanged(const DiskSample& previous, const DiskSample& current) const;
+    void publish(const DiskSample& sample);
+    void trackGrowth(const std::vector<std::string>& paths);
+
+    struct GrowthState {
+        std::shared_ptr<DirSnapshot> previous;
+        std::shared_ptr<DirSnapshot> current;
+        std::chrono::steady_clock::time_point due;
+    };
+
+    std::atomic<bool> monitoring{false};
+    std::thread monitorThread;
+    mutable std::mutex monitorMutex;       // guards everything below
+    std::condition_variable wakeup;
+    std::recursive_mutex publishMutex;     // held while callbacks run
+    std::vector<std::string> monitoredPaths;
+    std::map<std::string, DiskSample> lastSamples;
+    std::map<std::string, UsageHistory> histories;
+    bool persist = true;
+    std::string historyFile = HistoryStore::defaultFile();
+    std::unique_ptr<HistoryStore> store;
+    AlertEngine alerts;
+    std::map<SubscriptionId, SampleCallback> subscribers;
+    std::map<SubscriptionId, GrowthCallback> growthSubscribers;
+    std::map<SubscriptionId, FolderStatsCallback> folderStatsSubscribers;
+    std::unique_ptr<FolderStatsJob> folderJob;   // owned by the caller's thread, not guarded
+    HashCache hashCache;
+    bool hashCacheLoaded = false;
+    FolderStats folderStats;
+    bool haveFolderStats = false;
+    std::map<std::string, GrowthState> growthStates;
+    std::chrono::seconds growthInterval{0};
+    SubscriptionId nextSubscription = 1;
+    std::chrono::milliseconds interval{5000};
+    unsigned long long changeThreshold = 0;   // bytes; inode changes use the same fraction of inodesTotal
 
-    void monitorLoop();                    // function for periodic updates
+    void monitorLoop();
 };
 
 #endif
@@ -4,6 +4,9 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <sys/types.h>
+#include "file_types.h"
+#include "owner_stats.h"
 
 struct FileInfo {
     std::string path;
@@ -11,6 +14,13 @@ struct FileInfo {
     time_t modTime;
     std::string hash;
     std::string extension;
+    TypeId typeId = 0;       // interned extension, see ExtensionTable
+    uid_t uid = 0;
+    gid_t gid = 0;
+    unsigned long long allocated = 0;  // st_blocks * 512
+    dev_t device = 0;
+    ino_t inode = 0;
+    nlink_t links = 1;                 // hard links; counted once by owner accounting
 };
 
 class FileAnalyzer {
@@ -31,10 +41,22 @@ public:
     int countTempFiles(const std::string& path);
     int countOldFiles(const std::string& path, int days = 90);
 
+    // Bytes and counts per extension and per broad category
+    TypeBreakdown getTypeBreakdown(const std::string& path);
+    static TypeBreakdown aggregateTypes(const std::vector<FileInfo>& files);
+    void showTypeBreakdown(const std::string& path, bool json = false);
+
+    // Per-user / per-group usage; fresh reports are saved to the UsageIndex
+    OwnerReport getOwnerReport(const std::string& path);
+    void showOwnerReport(const std::string& path, bool cached = false, bool json = false);
+    void showOwnerQuery(const std::string& name, bool isGroup);
+
 private:
     std::vector<FileInfo> scanDirectory(const std::string& path);
     std::string calculateHash(const std::string& filepath);
     bool isTempFile(const std::string& filename);
+    void printTypeBreakdown(const TypeBreakdown& breakdown, const std::string& path, bool json);
+    void printOwnerReport(const OwnerReport& report, bool json);
 };
 
 #endif
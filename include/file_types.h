@@ -0,0 +1,82 @@
+#ifndef FILE_TYPES_H
+#define FILE_TYPES_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+// Compact ID for an interned extension (".mp4", ".o", ...). 0 is "no extension".
+using TypeId = uint32_t;
+
+enum class FileCategory {
+    Media,
+    Archive,
+    Build,
+    Log,
+    Temporary,
+    Document,
+    Other
+};
+
+const char* categoryName(FileCategory category);
+
+struct TypeStat {
+    TypeId id;
+    std::string extension;
+    FileCategory category;
+    unsigned long long bytes;
+    unsigned long long count;
+};
+
+struct CategoryStat {
+    FileCategory category;
+    unsigned long long bytes;
+    unsigned long long count;
+};
+
+struct TypeBreakdown {
+    std::vector<TypeStat> extensions;     // sorted by bytes, largest first
+    std::vector<CategoryStat> categories; // sorted by bytes, largest first
+    unsigned long long totalBytes = 0;
+    unsigned long long totalFiles = 0;
+};
+
+// Process-wide extension intern table. Extensions are lower-cased once on
+// insert so that every later comparison is an integer compare.
+class ExtensionTable {
+public:
+    static ExtensionTable& instance();
+
+    TypeId intern(const std::string& extension);
+    std::string name(TypeId id) const;
+    FileCategory category(TypeId id) const;
+    // What cleanup deletes; compared as written, so ".LOG" is kept
+    static bool isTemporary(const std::string& extension);
+
+private:
+    ExtensionTable();
+
+    mutable std::mutex tableMutex;
+    std::unordered_map<std::string, TypeId> ids;
+    std::vector<std::string> names;
+    std::vector<FileCategory> categories;
+};
+
+// Per-thread accumulator; each worker owns one and they are merged at the end.
+class TypeAggregator {
+public:
+    void add(TypeId id, unsigned long long bytes);
+    void merge(const TypeAggregator& other);
+    TypeBreakdown finish() const;
+
+private:
+    struct Totals {
+        unsigned long long bytes = 0;
+        unsigned long long count = 0;
+    };
+    std::unordered_map<TypeId, Totals> totals;
+};
+
+#endif
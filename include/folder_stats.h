@@ -0,0 +1,72 @@
+#ifndef FOLDER_STATS_H
+#define FOLDER_STATS_H
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <ctime>
+#include "live_index.h"
+#include "fs_watcher.h"
+#include "hash_cache.h"
+
+// Summary of one folder, small enough to hand to the UI by value
+struct FolderStats {
+    std::string path;
+    unsigned long long bytes = 0;
+    size_t files = 0;
+    size_t folders = 0;
+    size_t duplicateFiles = 0;            // copies beyond the first of each content
+    unsigned long long duplicateBytes = 0;
+    size_t oldFiles = 0;                  // not modified for OLD_FILE_DAYS
+    size_t tempFiles = 0;
+    size_t hashedFiles = 0;               // read this round (hash cache misses)
+    std::string backend;                  // event source keeping the index current
+    time_t computedAt = 0;
+    double elapsedSeconds = 0;
+    std::string error;                    // set, with no counts, when the folder could not be indexed
+};
+
+// Background job behind the GUI monitor view: indexes a folder once,
+// keeps the index current from filesystem events, and recomputes the
+// stats on its own thread whenever the index changed (at most every
+// MIN_INTERVAL). Only files that share a size with another file are
+// hashed for duplicates, and hashes come from the HashCache.
+class FolderStatsJob {
+public:
+    using Callback = std::function<void(const FolderStats&)>;
+
+    static const int OLD_FILE_DAYS = 45;
+    static constexpr std::chrono::seconds MIN_INTERVAL{2};
+
+    FolderStatsJob(const std::string& path, HashCache& cache, Callback callback);
+    ~FolderStatsJob();
+    FolderStatsJob(const FolderStatsJob&) = delete;
+    FolderStatsJob& operator=(const FolderStatsJob&) = delete;
+
+    void start();
+    void stop();      // waits for an index build or a round in progress to notice
+    void refresh();   // recompute soon, e.g. after the index changed
+
+    static bool isTempPath(const std::string& path);
+
+private:
+    void run();
+    bool compute(FolderStats& stats);   // false if stopped part-way
+
+    LiveIndex index;
+    FsWatcher watcher;
+    HashCache& hashes;
+    Callback onStats;
+
+    std::thread worker;
+    std::mutex jobMutex;
+    std::condition_variable wakeup;
+    bool dirty = true;
+    std::atomic<bool> stopping{false};   // also cancels an index build in progress
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef FS_WATCHER_H
+#define FS_WATCHER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+// Turns filesystem change notifications under a root into batches of
+// changed paths. fanotify with FAN_MARK_FILESYSTEM is used where the
+// process may (CAP_SYS_ADMIN, Linux 5.9+): one mark covers the whole
+// filesystem. Otherwise every directory gets an inotify watch.
+//
+// Events are coalesced for `coalesce` so a file written in many small
+// chunks is reported once. When the kernel queue overflows, or too many
+// paths pile up, the batch asks for the affected tree to be rescanned
+// instead of listing paths.
+class FsWatcher {
+public:
+    enum class Backend { None, Fanotify, Inotify };
+
+    // changed: paths to re-stat; rescan: directories to walk again
+    using Callback = std::function<void(const std::vector<std::string>& changed,
+                                        const std::vector<std::string>& rescan)>;
+
+    FsWatcher() = default;
+    ~FsWatcher();
+    FsWatcher(const FsWatcher&) = delete;
+    FsWatcher& operator=(const FsWatcher&) = delete;
+
+    bool start(const std::string& root, Callback callback,
+               std::chrono::milliseconds coalesce = std::chrono::milliseconds(500),
+               bool allowFanotify = true);
+    void stop();   // not from inside the callback
+
+    bool isRunning() const { return running; }
+    Backend backend() const { return activeBackend; }
+    static std::string backendName(Backend backend);
+    size_t watchCount() const { return watchedDirs; }    // inotify watches in place
+    size_t failedWatches() const { return watchFailures; } // e.g. fs.inotify.max_user_watches reached
+    size_t overflowCount() const { return overflows; }
+
+private:
+    bool startFanotify();
+    bool startInotify();
+    void addWatches(const std::string& dir);   // dir and everything below it
+    void removeWatches(const std::string& dir);
+    void readFanotify();
+    void readInotify();
+    bool underRoot(const std::string& path) const;
+    void changed(const std::string& path);
+    void rescan(const std::string& dir);
+    void run();
+
+    std::string rootDir;
+    Callback onChange;
+    std::chrono::milliseconds coalesceDelay{500};
+    Backend activeBackend = Backend::None;
+    int eventFd = -1;      // fanotify or inotify descriptor
+    int stopFd = -1;       // eventfd that wakes the thread for stop()
+    int mountFd = -1;      // any directory on the watched filesystem, for open_by_handle_at
+    std::thread watchThread;
+    std::mutex lifecycleMutex;   // start() and stop() may come from different threads
+    std::atomic<bool> running{false};
+    std::atomic<size_t> watchedDirs{0};
+    std::atomic<size_t> watchFailures{0};
+    std::atomic<size_t> overflows{0};
+
+    // Watcher thread only
+    std::map<int, std::string> watchPaths;       // inotify wd -> directory
+    std::map<std::string, int> watchDescriptors;
+    std::unordered_map<std::string, std::string> handleCache;   // fanotify directory handle -> path;
+                                                                // dropped whenever a directory moves
+    std::set<std::string> pendingChanged;
+    std::set<std::string> pendingRescan;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef HASH_CACHE_H
+#define HASH_CACHE_H
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <ctime>
+
+// SHA-256 content hashes keyed by path and validated by size and mtime,
+// so a file is only read again after it changed. Kept in
+// ~/.spacemate/hash_cache.txt as `size|mtime|hash|path` lines.
+class HashCache {
+public:
+    explicit HashCache(const std::string& file = defaultFile());
+    static std::string defaultFile();
+
+    bool load();
+    bool save();   // also forgets files that no longer exist once the cache is large
+
+    // Cached hash, or the file is read and hashed (outside the lock);
+    // empty if it cannot be read
+    std::string hash(const std::string& path, unsigned long long size, time_t mtime);
+
+    size_t size() const;
+    size_t hits() const;
+    size_t misses() const;
+
+private:
+    struct Entry {
+        unsigned long long size;
+        time_t mtime;
+        std::string hash;
+    };
+
+    std::string cacheFile;
+    mutable std::mutex cacheMutex;
+    std::unordered_map<std::string, Entry> entries;
+    bool dirty = false;
+    size_t hitCount = 0;
+    size_t missCount = 0;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <cstdint>
+#include <ctime>
+#include <sys/types.h>
+#include "disk_history.h"
+
+// On-disk record: 20 bytes, fixed size so a reader can walk a mapped file
+// without parsing. Most samples are stored as deltas against the previous
+// sample of the same mount; a KeyLow/KeyHigh pair carries full 64-bit
+// values at the start of each flushed batch and whenever a delta would
+// overflow.
+struct HistoryRecord {
+    uint32_t timestamp;
+    uint16_t mount;
+    uint8_t kind;
+    uint8_t reserved;
+    int32_t used;
+    int32_t available;
+    int32_t inodesFree;
+};
+static_assert(sizeof(HistoryRecord) == 20, "history records must stay 20 bytes");
+
+struct HistoryMountInfo {
+    std::string path;
+    time_t first = 0;
+    time_t last = 0;
+    size_t samples = 0;
+};
+
+// Append-only monitoring history in ~/.spacemate/history.bin, with mount
+// paths in history_mounts.txt. Appends are buffered and written in batches;
+// reads mmap the file. Compaction thins old data (one sample per minute
+// after a day, one per hour after a month) and drops it after a year.
+class HistoryStore {
+public:
+    enum Kind : uint8_t { KeyLow = 1, KeyHigh = 2, Delta = 3 };
+
+    explicit HistoryStore(const std::string& file = defaultFile());
+    ~HistoryStore();
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+
+    static std::string defaultFile();
+
+    // Unchanged samples are only written once a minute as a heartbeat; a
+    // path whose id cannot be saved to the mounts file is not recorded
+    void append(const std::string& path, const HistoryPoint& point);
+    bool flush();
+    bool compact(time_t now = time(nullptr));
+
+    std::vector<HistoryMountInfo> mounts() const;
+    std::vector<HistoryPoint> read(const std::string& path, time_t from, time_t to) const;
+    void forEach(time_t from, time_t to,
+                 const std::function<void(const std::string&, const HistoryPoint&)>& visit) const;
+
+private:
+    struct Pending {
+        uint16_t mount;
+        HistoryPoint point;
+    };
+
+    bool mountId(const std::string& path, uint16_t& id);   // false if a new id could not be saved
+    std::map<uint16_t, std::string> loadMounts() const;      // skips lines that do not parse
+    bool writeRecords(int fd, const std::vector<Pending>& samples) const;
+
+    std::string historyFile;
+    std::string mountsFile;
+    std::map<std::string, uint16_t> mountIds;
+    std::map<uint16_t, HistoryPoint> lastWritten;   // per mount, for heartbeat suppression
+    std::vector<Pending> pending;
+    time_t lastFlush;
+    off_t compactedSize;
+};
+
+#endif
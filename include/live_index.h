@@ -0,0 +1,63 @@
+#ifndef LIVE_INDEX_H
+#define LIVE_INDEX_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <ctime>
+
+struct IndexedFile {
+    unsigned long long size = 0;
+    time_t mtime = 0;
+};
+
+// In-memory index of every regular file under a root, kept current by
+// applying change notifications (see FsWatcher) instead of rescanning.
+// Paths are kept sorted so everything under a directory is one range.
+class LiveIndex {
+public:
+    explicit LiveIndex(const std::string& root);
+
+    // Full walk; false if the root is not a readable directory or `cancel`
+    // was set part-way (it is checked once per directory)
+    bool build(const std::atomic<bool>* cancel = nullptr);
+
+    // Re-stat each changed path (a file, or a directory that appeared or
+    // vanished) and walk each rescan directory again from scratch
+    void apply(const std::vector<std::string>& changed, const std::vector<std::string>& rescanDirs);
+    void rescan(const std::string& dir);
+
+    const std::string& rootPath() const { return rootDir; }
+    unsigned long long totalBytes() const;
+    size_t fileCount() const;
+    size_t directoryCount() const;
+    size_t updateCount() const;   // paths applied since build()
+
+    // Runs under the index lock; keep the callback short
+    void forEachFile(const std::function<void(const std::string& path, const IndexedFile& file)>& visit) const;
+
+private:
+    struct Listing {
+        std::map<std::string, IndexedFile> files;
+        std::set<std::string> dirs;
+    };
+
+    bool contains(const std::string& path) const;
+    static bool walk(const std::string& dir, Listing& out, const std::atomic<bool>* cancel = nullptr);   // false if cancelled
+    void removeUnder(const std::string& dir);    // the directory and everything below; lock held
+    void merge(Listing& listing);                // lock held
+    void update(const std::string& path);        // lock held
+
+    std::string rootDir;
+    mutable std::mutex indexMutex;
+    std::map<std::string, IndexedFile> files;
+    std::set<std::string> dirs;
+    unsigned long long bytes = 0;
+    size_t updates = 0;
+};
+
+#endif
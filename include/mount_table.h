@@ -0,0 +1,83 @@
+#ifndef MOUNT_TABLE_H
+#define MOUNT_TABLE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+
+// One line of /proc/self/mountinfo
+struct MountInfo {
+    int id = 0;
+    std::string deviceNumber;  // major:minor, shared by bind mounts of one filesystem
+    std::string mountPoint;
+    std::string device;        // mount source, e.g. /dev/sda1 or tmpfs
+    std::string fsType;
+    std::string options;       // per-mount options (rw, noatime, ...)
+    bool readOnly = false;
+
+    bool isPseudo() const;     // proc, sysfs, cgroup and friends: no disk behind them
+};
+
+// statvfs of a mount, in bytes and inodes
+struct VolumeStats {
+    MountInfo mount;
+    unsigned long long total = 0;
+    unsigned long long free = 0;        // includes root-reserved blocks
+    unsigned long long available = 0;   // usable by unprivileged users
+    unsigned long long inodesTotal = 0;
+    unsigned long long inodesFree = 0;
+
+    unsigned long long used() const { return total - free; }
+    double usedPercent() const { return total ? (total - available) * 100.0 / total : 0.0; }
+};
+
+// The system's mounts, parsed from /proc/self/mountinfo once and parsed
+// again only when the kernel reports a change: the file stays open and a
+// zero-timeout poll() for POLLPRI tells whether anything was mounted or
+// unmounted since. statvfs results are cached per mount for `ttl`, so
+// asking about a volume repeatedly (dashboard refreshes, scans) costs a
+// poll and a map lookup.
+class MountTable {
+public:
+    explicit MountTable(const std::string& file = "/proc/self/mountinfo");
+    ~MountTable();
+    MountTable(const MountTable&) = delete;
+    MountTable& operator=(const MountTable&) = delete;
+
+    static MountTable& instance();   // shared by the CLI and the GUI
+
+    std::vector<MountInfo> mounts();
+    // The mount holding `path` (longest mount point prefix after resolving symlinks)
+    bool mountFor(const std::string& path, MountInfo& mount);
+    // Usage of the volume holding `path`; statvfs runs at most once per ttl per mount
+    bool stats(const std::string& path, VolumeStats& result);
+    // Every real (non-pseudo) volume with a non-zero size, one entry per device
+    std::vector<VolumeStats> volumes();
+
+    void setTtl(std::chrono::milliseconds value);
+    size_t reloadCount() const { return reloads; }
+
+private:
+    struct CachedStats {
+        VolumeStats stats;
+        std::chrono::steady_clock::time_point takenAt;
+    };
+
+    void refreshIfChanged();   // callers hold tableMutex
+    bool load();
+    bool statMount(const MountInfo& mount, VolumeStats& result);
+    const MountInfo* findMount(const std::string& path) const;
+
+    std::string sourceFile;
+    int fd = -1;
+    bool loaded = false;
+    size_t reloads = 0;
+    std::mutex tableMutex;
+    std::vector<MountInfo> table;   // file order: later entries shadow earlier ones
+    std::map<std::string, CachedStats> cache;   // by mount point
+    std::chrono::milliseconds ttl{2000};
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef OBJECT_STORE_H
+#define OBJECT_STORE_H
+
+#include <string>
+#include <memory>
+#include <sys/stat.h>
+#include "copy_engine.h"
+#include "compressor.h"
+#include "pack_store.h"
+
+// Outcome of ObjectStore::put
+struct StoredObject {
+    bool ok = false;
+    std::string hash;
+    std::string path;                   // where the content lives in the store (a pack for small files)
+    unsigned long long size = 0;
+    unsigned long long storedSize = 0;  // on disk; smaller than size when compressed
+    Codec codec = Codec::None;
+    bool deduplicated = false;          // content was already stored; nothing copied
+    CopyResult copy;                    // the copy, when one was needed
+    struct stat source = {};            // the file as backed up; a shared object keeps only its first
+};
+
+// Content-addressed file store: every object is named by the SHA-256
+// of its content and lives at <root>/<first two hex digits>/<hash>, so
+// identical files are stored once no matter how often, or under which
+// names, they are backed up. The hash is computed while the file is
+// copied to a temporary name, which is then renamed into place (or
+// dropped when the content was already stored), so a crash never
+// leaves a partial object under a valid hash. The name doubles as the
+// checksum `spacemate verify` checks objects against.
+//
+// With a codec set, objects that are worth it are stored compressed
+// as <hash>.smz (see Compressor); the name tells restores how to read
+// an object back.
+//
+// With packing enabled, files below the pack threshold are read once
+// into memory and appended to a PackStore under <root>/packs instead
+// of getting a file each; call flush() before indexing them.
+class ObjectStore {
+public:
+    explicit ObjectStore(const std::string& root, const CompressionSettings& compression = CompressionSettings(),
+                         const PackSettings& packing = PackSettings());
+
+    bool open();   // creates the root directory; false if it cannot be
+    const std::string& root() const { return storeRoot; }
+
+    StoredObject put(const std::string& source);
+    bool flush();   // writes out buffered pack data
+    bool contains(const std::string& hash) const;
+    bool remove(const std::string& hash);
+
+    std::string pathFor(const std::string& hash) const;   // uncompressed form
+    std::string find(const std::string& hash) const;      // the stored form, or ""
+    // Hash of an object path inside this store, or "" for any other path
+    std::string hashOf(const std::string& path) const;
+
+    static bool isCompressed(const std::string& path);
+    static const char* COMPRESSED_SUFFIX;
+
+private:
+    StoredObject putPacked(const std::string& source, const struct stat& before);
+    bool reuse(StoredObject& object) const;   // fills in an existing object for object.hash
+
+    std::string storeRoot;
+    CompressionSettings compression;
+    PackSettings packing;
+    std::unique_ptr<PackStore> packs;   // only when packing is enabled
+};
+
+
+// A flock on <root>/.lock that keeps garbage collection away from
+// objects not yet indexed. A BackupSession holds it shared from its
+// first put() (which may reuse an object no entry refers to yet) until
+// its entries are written; removing backups, rewriting packs and the
+// orphan sweep hold it exclusively.
+class StoreLock {
+public:
+    StoreLock(const std::string& root, bool exclusive);
+    ~StoreLock();
+    StoreLock(const StoreLock&) = delete;
+    StoreLock& operator=(const StoreLock&) = delete;
+
+    bool held() const { return lockFd >= 0; }
+    void release();
+
+private:
+    int lockFd = -1;
+};
+
+#endif
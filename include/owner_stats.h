@@ -0,0 +1,74 @@
+#ifndef OWNER_STATS_H
+#define OWNER_STATS_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <ctime>
+#include <sys/types.h>
+
+struct OwnerUsage {
+    unsigned int id;
+    std::string name;
+    unsigned long long apparentBytes;   // sum of st_size
+    unsigned long long allocatedBytes;  // sum of st_blocks * 512
+    unsigned long long files;
+};
+
+struct OwnerReport {
+    std::string root;
+    time_t generated = 0;
+    std::vector<OwnerUsage> users;   // sorted by allocated bytes, largest first
+    std::vector<OwnerUsage> groups;  // sorted by allocated bytes, largest first
+};
+
+// Accumulates per-uid / per-gid totals while a tree is being walked.
+// Files with several hard links are counted once, by (device, inode);
+// they are held back until finish() so merged accumulators that both
+// saw one still count it once. The report's root is the canonical path.
+class OwnerAccounting {
+public:
+    void add(uid_t uid, gid_t gid, unsigned long long apparent, unsigned long long allocated,
+             dev_t device = 0, ino_t inode = 0, nlink_t links = 1);
+    void merge(const OwnerAccounting& other);
+    OwnerReport finish(const std::string& root) const;
+
+private:
+    struct Totals {
+        unsigned long long apparent = 0;
+        unsigned long long allocated = 0;
+        unsigned long long files = 0;
+    };
+    struct LinkedFile {
+        uid_t uid;
+        gid_t gid;
+        unsigned long long apparent;
+        unsigned long long allocated;
+    };
+    void count(uid_t uid, gid_t gid, unsigned long long apparent, unsigned long long allocated);
+
+    std::unordered_map<uid_t, Totals> users;
+    std::unordered_map<gid_t, Totals> groups;
+    std::map<std::pair<dev_t, ino_t>, LinkedFile> linked;
+};
+
+// Persistent owner index in ~/.spacemate/usage_index.txt. Each scanned root
+// keeps its latest report so "who uses the space" can be answered later
+// without walking the tree again.
+class UsageIndex {
+public:
+    void store(const OwnerReport& report);
+    bool load(const std::string& root, OwnerReport& report);
+    std::vector<std::string> roots();
+
+    // All indexed roots where the given user (or group, if isGroup) owns data
+    std::vector<std::pair<std::string, OwnerUsage>> query(const std::string& name, bool isGroup);
+
+private:
+    std::string indexFile();
+    std::vector<OwnerReport> loadAll();
+    void saveAll(const std::vector<OwnerReport>& reports);
+};
+
+#endif
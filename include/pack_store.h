@@ -0,0 +1,130 @@
+#ifndef PACK_STORE_H
+#define PACK_STORE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <cstdint>
+#include <ctime>
+#include "compressor.h"
+
+struct PackSettings {
+    bool enabled = false;
+    unsigned long long threshold = 64 * 1024;     // files below this go into packs
+    unsigned long long packSize = 256ULL << 20;   // a new pack is started beyond this
+    size_t flushBytes = 8 << 20;                  // objects buffered per write
+};
+
+// Where one packed object lives
+struct PackLocation {
+    std::string pack;
+    uint64_t offset = 0;
+    uint64_t storedSize = 0;
+    uint64_t size = 0;
+    Codec codec = Codec::None;
+    uint32_t mode = 0644;
+    struct timespec mtime = {0, 0};
+};
+
+// Reads objects back from one pack. The offset index is read once and
+// the pack kept open for the reader's lifetime, so many objects (a batch
+// restore, a verify pass) cost one index read.
+class PackReader {
+public:
+    explicit PackReader(const std::string& pack);
+    ~PackReader();
+    PackReader(const PackReader&) = delete;
+    PackReader& operator=(const PackReader&) = delete;
+
+    bool isOpen() const { return packFd >= 0; }
+    int error() const { return openError; }
+    size_t size() const { return objects.size(); }
+
+    // The original content of an object, decompressed; false if the pack
+    // does not hold it or it cannot be read back
+    bool read(const std::string& hash, std::vector<char>& raw, PackLocation& location);
+
+private:
+    std::string packPath;
+    int indexFd = -1;
+    int packFd = -1;
+    int openError = 0;
+    std::unordered_map<std::string, PackLocation> objects;
+};
+
+// Small objects batched into a few large append-only files, so a
+// cleanup of many small files creates a handful of files instead of an
+// inode per object. <dir>/pack-NNNNNN.pack holds the object data,
+// buffered and written in large sequential appends; pack-NNNNNN.idx
+// holds a fixed 80-byte record per object (SHA-256, offset, stored and
+// original size, mode, mtime, codec). Objects are read back with pread.
+//
+// A writer holds an exclusive flock on the pack it appends to (the
+// newest one, while it is below the size limit), so concurrent writers
+// never share a pack. A failed write cuts both files back to the last
+// good flush and closes the pack. A rewrite never changes a pack: it
+// copies the live objects to a new pack and index under the next free
+// number, and the old pair is deleted once the backup index points at
+// the new one. A pack is deleted as a whole once no backup refers to
+// it, and neither deleted nor rewritten while a writer holds it.
+class PackStore {
+public:
+    explicit PackStore(const std::string& dir, const PackSettings& settings = PackSettings());
+    ~PackStore();   // flushes
+    PackStore(const PackStore&) = delete;
+    PackStore& operator=(const PackStore&) = delete;
+
+    // Queues an object; `location` tells where it will be once flushed
+    bool add(const std::string& hash, const std::vector<char>& data, uint64_t size, Codec codec,
+             uint32_t mode, const struct timespec& mtime, PackLocation& location);
+    bool find(const std::string& hash, PackLocation& location);
+    // Writes what is buffered; false if this or any earlier write failed,
+    // so call it before indexing the objects
+    bool flush();
+
+    static bool isPack(const std::string& path);
+    // Looks the object up in that pack's offset index and restores it to
+    // `dest`, with the mode and mtime it was backed up with
+    static CopyResult restore(const std::string& pack, const std::string& hash, const std::string& dest);
+    static CopyResult restore(PackReader& reader, const std::string& hash, const std::string& dest);
+    // Deletes a pack and its offset index unless a writer still holds it
+    static bool removePack(const std::string& pack);
+    // Copies only the `live` objects of a pack to a new pack (synced) and
+    // returns its path, or "" if it could not or a writer holds the pack.
+    // The old pack is left in place for the caller to delete once nothing
+    // refers to it; `saved` is what that deletion will give back.
+    static std::string rewritePack(const std::string& pack, const std::unordered_set<std::string>& live,
+                                   unsigned long long& saved);
+
+private:
+    struct Pending {
+        std::string hash;
+        PackLocation location;
+    };
+
+    bool load();   // caller holds packMutex
+    bool openPack();
+    void closePack();
+    bool flushLocked();
+    std::string packPath(uint32_t number) const;
+
+    std::string packDir;
+    PackSettings settings;
+    std::mutex packMutex;
+    bool loaded = false;
+    std::unordered_map<std::string, PackLocation> objects;   // hash -> location, pending ones included
+    uint32_t newestPack = 0;
+    int packFd = -1;
+    int indexFd = -1;
+    std::string currentPath;
+    uint64_t currentSize = 0;   // of the current pack, buffered data included
+    uint64_t packWritten = 0;   // sizes after the last good flush
+    uint64_t indexWritten = 0;
+    std::string buffer;
+    std::vector<Pending> pending;
+    bool writeFailed = false;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <string>
+#include <map>
+
+// ~/.spacematerc: `[section]` headers followed by `key = value` lines;
+// `#` and `;` start comments. Missing files and keys fall back to the
+// defaults the callers pass in.
+class Settings {
+public:
+    explicit Settings(const std::string& file = defaultFile());
+    static std::string defaultFile();
+
+    bool load();   // false if the file cannot be read
+
+    std::string get(const std::string& section, const std::string& key, const std::string& fallback = "") const;
+    long long getInt(const std::string& section, const std::string& key, long long fallback) const;
+    bool getBool(const std::string& section, const std::string& key, bool fallback) const;
+
+private:
+    std::string settingsFile;
+    std::map<std::string, std::string> values;   // "section.key" -> value
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Self-contained SHA-256 (FIPS 180-4), so content hashing needs no
+// crypto library
+class Sha256 {
+public:
+    Sha256();
+
+    void update(const void* data, size_t length);
+    std::string hexDigest();   // finishes the hash; call once
+
+    static std::string hashFile(const std::string& path);   // empty if the file cannot be read
+
+private:
+    void transform(const uint8_t* block);
+
+    uint32_t state[8];
+    uint64_t totalBytes;
+    uint8_t buffer[64];
+    size_t bufferLength;
+};
+
+#endif
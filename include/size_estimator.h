@@ -0,0 +1,77 @@
+#ifndef SIZE_ESTIMATOR_H
+#define SIZE_ESTIMATOR_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <random>
+
+struct EstimatedChild {
+    std::string name;
+    double bytes;         // estimated subtree bytes
+    double bytesMargin;   // 95% confidence half-width
+    double files;
+    unsigned long long probes;
+};
+
+struct SizeEstimate {
+    double bytes = 0, bytesLow = 0, bytesHigh = 0;
+    double files = 0, filesLow = 0, filesHigh = 0;
+    unsigned long long probes = 0;
+    size_t directoriesRead = 0;
+    double elapsedSeconds = 0;
+    std::vector<EstimatedChild> children;   // top-level directories, largest first
+
+    double relativeError() const { return bytes > 0 ? (bytesHigh - bytes) / bytes : 0.0; }
+};
+
+// Knuth-style tree size estimation. Each probe walks one random path down
+// the tree, listing directories it has not seen yet; siblings are taken in
+// a random order, so every partially listed directory is a simple random
+// sample of its subdirectories and is extrapolated (two-stage cluster
+// sampling) from the ones already seen. Probes that reach a fully listed
+// directory descend in proportion to the estimated number of directories
+// still unlisted below each child, so coverage grows evenly, the interval
+// keeps tightening the longer it runs, and the answer becomes exact once
+// the whole tree has been listed.
+class SizeEstimator {
+public:
+    explicit SizeEstimator(const std::string& root, unsigned int seed = std::random_device{}());
+
+    void probe();
+    bool complete() const;
+    SizeEstimate current() const;
+
+    // Probe until `seconds` elapse or the 95% interval is within
+    // `targetRelativeError`. `progress` is called a few times per second
+    // and may return false to stop early.
+    SizeEstimate run(double seconds, double targetRelativeError = 0.05,
+                     const std::function<bool(const SizeEstimate&)>& progress = nullptr);
+
+private:
+    struct Node {
+        uint32_t parent;
+        std::string name;
+        std::vector<std::string> subdirs;   // shuffled; the first children.size() are listed
+        std::vector<uint32_t> children;
+        double directBytes = 0, directFiles = 0;
+        double bytes = 0, bytesVar = 0;     // subtree estimate and its variance
+        double files = 0, filesVar = 0;
+        double dirs = 1;                    // estimated directories in the subtree
+        double listed = 1;                  // directories actually listed
+        unsigned long long probes = 0;
+        bool complete = false;              // every directory below has been listed
+    };
+
+    uint32_t listDirectory(uint32_t parent, const std::string& path, const std::string& name);
+    void recompute(uint32_t id);
+
+    std::vector<Node> nodes;
+    std::string rootPath;
+    std::mt19937_64 rng;
+    unsigned long long totalProbes = 0;
+    double elapsed = 0;
+};
+
+#endif
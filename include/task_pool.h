@@ -0,0 +1,41 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads with a bounded queue: submit() blocks once
+// `maxQueued` tasks are waiting, so a producer walking a huge tree never
+// gets far ahead of the I/O and memory stays flat.
+class TaskPool {
+public:
+    explicit TaskPool(size_t threads = defaultThreads(), size_t maxQueued = 0);   // 0: 2 per thread
+    ~TaskPool();   // runs what is queued, then joins
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void wait();   // until every submitted task has finished
+
+    size_t threadCount() const { return workers.size(); }
+    static size_t defaultThreads();   // hardware threads, within 2..8: I/O bound work
+
+private:
+    void run();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex poolMutex;
+    std::condition_variable available;   // queue gained a task or stopping
+    std::condition_variable space;       // queue has room
+    std::condition_variable idle;        // nothing queued or running
+    size_t capacity;
+    size_t running = 0;
+    bool stopping = false;
+};
+
+#endif
@@ -3,10 +3,18 @@
 
 #include <string>
 #include <ctime>
+#include <sys/types.h>
 
 namespace Utils {
     std::string formatSize(unsigned long long bytes);
+    std::string formatDuration(double seconds);   // "3h 12m", "2d 4h", "never" if negative
     std::string getCurrentTimestamp();
+    // Back from getCurrentTimestamp's format; a trailing "_N" suffix is ignored
+    bool parseTimestamp(const std::string& stamp, time_t& result);
+    // "now", relative ("-2h", "-3d", "-1w"), epoch seconds or "YYYY-MM-DD[ HH:MM[:SS]]"
+    bool parseTime(const std::string& spec, time_t& result);
+    bool parseDuration(const std::string& spec, time_t& seconds);       // "30s", "15m", "2h", "1d", "1w"
+    bool parseSize(const std::string& spec, unsigned long long& bytes); // "512", "500M", "5G", "1T"
     bool fileExists(const std::string& path);
     bool isDirectory(const std::string& path);
     unsigned long long getFileSize(const std::string& path);
@@ -15,6 +23,11 @@ namespace Utils {
     std::string getHomeDir();
     std::string getTempDir();
     std::string getCacheDir();
+    std::string jsonEscape(const std::string& text);
+
+    // Cached getpwuid/getgrgid lookups; fall back to the numeric ID
+    std::string userName(uid_t uid);
+    std::string groupName(gid_t gid);
 }
 
 #endif
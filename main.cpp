@@ -8,11 +8,14 @@
 #include "include/file_analyzer.h"
 #include "include/cleanup_manager.h"
 #include "include/backup_manager.h"
+#include "include/backup_restorer.h"
 #include "include/utils.h"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
 
 using namespace std;
 
@@ -38,23 +41,60 @@ void printHelp() {
     cout << BOLD << "Usage:" << RESET << " ./spacemate <command> <path> [options]\n\n";
     cout << BOLD << "Commands:\n" << RESET;
     cout << "  scan <path>       - Scan disk usage and show statistics\n";
+    cout << "  monitor <path>    - Watch free space, fill rate and time until full\n";
+    cout << "  watch <path>      - Keep a live file index current from filesystem events\n";
+    cout << "  history [path]    - List recorded paths, or dump a path's samples\n";
     cout << "  analyze <path>    - Analyze files (duplicates, temp files, old files)\n";
+    cout << "  types <path>      - Show space used per extension and file category\n";
+    cout << "  owners <path>     - Show space used per user and group\n";
+    cout << "  owners --user <name> | --group <name>\n";
+    cout << "                    - Query the owner index for one user or group\n";
     cout << "  clean <path>      - Clean up unnecessary files\n";
-    cout << "  restore           - Restore backed up files\n";
+    cout << "  backup <path> <dest>\n";
+    cout << "                    - Mirror a folder to dest, copying only what changed\n";
+    cout << "  restore           - Restore backed up files (all that match, with the options below)\n";
+    cout << "  gc                - Remove backups beyond the retention policy\n";
+    cout << "  verify            - Check stored backups against their checksums\n";
     cout << "  help              - Show this help message\n\n";
     cout << BOLD << "Options:\n" << RESET;
-    cout << "  --dry-run         - Preview cleanup without making changes\n";
+    cout << "  --dry-run         - Preview cleanup, gc or restore without making changes\n";
     cout << "  --verbose         - Show detailed output\n";
-    cout << "  --force           - Skip confirmations (use with caution)\n\n";
+    cout << "  --force           - Skip confirmations (use with caution)\n";
+    cout << "  --json            - Machine-readable output (types, owners)\n";
+    cout << "  --cached          - Answer from the owner index instead of rescanning\n";
+    cout << "  --estimate        - Sample the tree instead of walking it (scan)\n";
+    cout << "  --time <sec>      - Time budget for scan --estimate (default 10), monitor, watch or verify\n";
+    cout << "  --interval <sec>  - Sampling interval for monitor (default 1)\n";
+    cout << "  --growth <sec>    - How often monitor compares directory sizes (default 60, 0 = off)\n";
+    cout << "  --from/--to <t>   - History range: -2h, -3d, YYYY-MM-DD[ HH:MM] or epoch\n";
+    cout << "  --compact         - Thin out old history samples now\n";
+    cout << "  --threads <n>     - Stored files verify (default 2) or restore (default 4) reads at once\n";
+    cout << "  --restart         - Start a new verify pass instead of continuing\n";
+    cout << "  --session <id>    - Restore one session (its timestamp, or 'latest')\n";
+    cout << "  --path-prefix <p> - Restore backups of files under this path\n";
+    cout << "  --before <t>      - Restore the newest backups made before this time\n";
+    cout << "  --to <dir>        - Restore under this directory instead of in place\n";
+    cout << "  --conflict <c>    - When a restored file exists: skip (default), overwrite or rename\n\n";
     cout << BOLD << "Examples:\n" << RESET;
     cout << "  ./spacemate scan ~/Downloads\n";
+    cout << "  ./spacemate scan / --estimate --time 5\n";
+    cout << "  ./spacemate monitor /var --interval 5\n";
+    cout << "  ./spacemate history /var --from -1d\n";
     cout << "  ./spacemate analyze ~/Documents --verbose\n";
+    cout << "  ./spacemate types ~/Projects --json\n";
     cout << "  ./spacemate clean ~/temp --dry-run\n";
-    cout << "  ./spacemate restore\n\n";
+    cout << "  ./spacemate restore\n";
+    cout << "  ./spacemate restore --session latest --path-prefix ~/Downloads --conflict rename\n";
+    cout << "  ./spacemate gc --dry-run\n";
+    cout << "  ./spacemate verify --time 3600\n\n";
 }
 
 int main(int argc, char* argv[]) {
-    printBanner();
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--json") quiet = true;
+    }
+    if (!quiet) printBanner();
     
     if (argc < 2) {
         printHelp();
@@ -66,13 +106,62 @@ int main(int argc, char* argv[]) {
     bool dryRun = false;
     bool verbose = false;
     bool force = false;
+    bool json = false;
+    bool cached = false;
+    bool estimate = false;
+    bool timeGiven = false;
+    double timeLimit = 10.0;
+    double interval = 1.0;
+    double growthInterval = 60.0;
+    bool compact = false;
+    bool restart = false;
+    size_t threads = 0;   // the command's default
+    bool restoreSelected = false;
+    RestoreSelection selection;
+    RestoreOptions restoreOptions;
+    time_t from = 0;
+    time_t to = time(nullptr);
     
-    // Parse options
-    for (int i = 3; i < argc; i++) {
+    // Parse options (commands whose path is optional may start with one)
+    int firstOption = (argc > 2 && string(argv[2]).rfind("--", 0) == 0) ? 2 : 3;
+    for (int i = firstOption; i < argc; i++) {
         string arg = argv[i];
         if (arg == "--dry-run") dryRun = true;
         else if (arg == "--verbose") verbose = true;
         else if (arg == "--force") force = true;
+        else if (arg == "--json") json = true;
+        else if (arg == "--cached") cached = true;
+        else if (arg == "--estimate") estimate = true;
+        else if (arg == "--time" && i + 1 < argc) { timeLimit = atof(argv[++i]); timeGiven = true; }
+        else if (arg == "--interval" && i + 1 < argc) interval = atof(argv[++i]);
+        else if (arg == "--growth" && i + 1 < argc) growthInterval = atof(argv[++i]);
+        else if (arg == "--compact") compact = true;
+        else if (arg == "--restart") restart = true;
+        else if (arg == "--threads" && i + 1 < argc) threads = max(1, atoi(argv[++i]));
+        else if (arg == "--session" && i + 1 < argc) { selection.session = argv[++i]; restoreSelected = true; }
+        else if (arg == "--path-prefix" && i + 1 < argc) { selection.pathPrefix = argv[++i]; restoreSelected = true; }
+        else if (arg == "--before" && i + 1 < argc) {
+            if (!Utils::parseTime(argv[++i], selection.before)) {
+                cout << RED << "Error: Cannot parse time '" << argv[i] << "'\n" << RESET;
+                return 1;
+            }
+            restoreSelected = true;
+        }
+        else if (arg == "--to" && command == "restore" && i + 1 < argc) { restoreOptions.targetDir = argv[++i]; restoreSelected = true; }
+        else if (arg == "--conflict" && i + 1 < argc) {
+            if (!BackupRestorer::parseConflict(argv[++i], restoreOptions.conflict)) {
+                cout << RED << "Error: --conflict takes skip, overwrite or rename\n" << RESET;
+                return 1;
+            }
+            restoreSelected = true;
+        }
+        else if ((arg == "--from" || arg == "--to") && i + 1 < argc) {
+            time_t& target = arg == "--from" ? from : to;
+            if (!Utils::parseTime(argv[++i], target)) {
+                cout << RED << "Error: Cannot parse time '" << argv[i] << "'\n" << RESET;
+                return 1;
+            }
+        }
     }
     
     try {
@@ -82,13 +171,51 @@ int main(int argc, char* argv[]) {
         else if (command == "scan") {
             cout << BLUE << "📊 Scanning: " << RESET << path << "\n\n";
             DiskMonitor monitor;
-            monitor.scanPath(path, verbose);
+            if (estimate) monitor.estimatePath(path, timeLimit);
+            else monitor.scanPath(path, verbose);
+        }
+        else if (command == "monitor") {
+            cout << BLUE << "📈 Monitoring: " << RESET << path << "\n\n";
+            DiskMonitor monitor;
+            monitor.monitorPath(path, interval, timeGiven ? timeLimit : 0, growthInterval);
+        }
+        else if (command == "watch") {
+            cout << BLUE << "👁️  Watching: " << RESET << path << "\n\n";
+            DiskMonitor monitor;
+            monitor.watchPath(path, timeGiven ? timeLimit : 0);
+        }
+        else if (command == "history") {
+            DiskMonitor monitor;
+            if (compact) {
+                monitor.compactHistory();
+            } else {
+                string target = (argc > 2 && string(argv[2]).rfind("--", 0) != 0) ? path : "";
+                if (!json) cout << BLUE << "🕘 Monitoring history" << (target.empty() ? "" : ": " + target) << RESET << "\n\n";
+                monitor.showHistory(target, from, to, json);
+                if (json) return 0;
+            }
         }
         else if (command == "analyze") {
             cout << BLUE << "🔍 Analyzing: " << RESET << path << "\n\n";
             FileAnalyzer analyzer;
             analyzer.analyzePath(path, verbose);
         }
+        else if (command == "types") {
+            FileAnalyzer analyzer;
+            if (!json) cout << BLUE << "📁 File types: " << RESET << path << "\n\n";
+            analyzer.showTypeBreakdown(path, json);
+            if (json) return 0;
+        }
+        else if (command == "owners") {
+            FileAnalyzer analyzer;
+            if ((path == "--user" || path == "--group") && argc > 3) {
+                analyzer.showOwnerQuery(argv[3], path == "--group");
+            } else {
+                if (!json) cout << BLUE << "👤 Owners: " << RESET << path << "\n\n";
+                analyzer.showOwnerReport(path, cached, json);
+                if (json) return 0;
+            }
+        }
         else if (command == "clean") {
             if (dryRun) {
                 cout << YELLOW << "🔍 DRY RUN MODE - No files will be deleted\n" << RESET;
@@ -98,11 +225,40 @@ int main(int argc, char* argv[]) {
             CleanupManager cleaner;
             cleaner.cleanPath(path, dryRun, force, verbose);
         }
+        else if (command == "backup") {
+            if (argc < 4 || string(argv[3]).rfind("--", 0) == 0) {
+                cout << RED << "Error: backup needs a source and a destination\n" << RESET;
+                return 1;
+            }
+            cout << BLUE << "🗂️  Backing up: " << RESET << path << " -> " << argv[3] << "\n\n";
+            BackupManager backup;
+            if (backup.createBackup(path, argv[3]).empty()) return 1;
+            const SyncReport& sync = backup.lastSync();
+            cout << GREEN << "✓ " << sync.copied << " copied, " << sync.unchanged << " unchanged, " << sync.removed
+                 << " removed (" << Utils::formatSize(sync.bytesCopied) << " at "
+                 << Utils::formatSize((unsigned long long)sync.bytesPerSecond()) << "/s)\n" << RESET;
+        }
         else if (command == "restore") {
             cout << BLUE << "📦 Restore Manager\n" << RESET << "\n";
             BackupManager backup;
-            backup.showBackups();
-            backup.restoreFiles();
+            if (restoreSelected) {
+                if (threads > 0) restoreOptions.threads = threads;
+                if (!backup.restoreBackups(selection, restoreOptions, dryRun)) return 1;
+            } else {
+                backup.showBackups();
+                backup.restoreFiles();
+            }
+        }
+        else if (command == "gc") {
+            if (dryRun) cout << YELLOW << "🔍 DRY RUN MODE - No backups will be removed\n" << RESET;
+            cout << BLUE << "♻️  Backup garbage collection\n" << RESET << "\n";
+            BackupManager backup;
+            backup.collectGarbage(dryRun);
+        }
+        else if (command == "verify") {
+            cout << BLUE << "🔎 Verifying backups\n" << RESET << "\n";
+            BackupManager backup;
+            if (!backup.verifyBackups(threads > 0 ? threads : 2, timeGiven ? timeLimit : 0, restart)) return 1;
         }
         else {
             cout << RED << "Error: Unknown command '" << command << "'\n" << RESET;
@@ -165,6 +165,290 @@ else
     ((PASSED++))
 fi
 
+# Test 11: File Type Breakdown
+echo -e "\n${CYAN}[Test 11] Testing file type breakdown...${RESET}"
+if $TEST_DIR/../bin/spacemate types "$TEST_DIR" --json > /tmp/types_output.txt 2>&1; then
+    if grep -q '"extension": ".tmp"' /tmp/types_output.txt && grep -q '"totalFiles"' /tmp/types_output.txt; then
+        echo -e "${GREEN}✓ PASS: Type breakdown reports extensions${RESET}"
+        ((PASSED++))
+    else
+        echo -e "${RED}✗ FAIL: Type breakdown output incomplete${RESET}"
+        ((FAILED++))
+    fi
+else
+    echo -e "${RED}✗ FAIL: Types command failed${RESET}"
+    ((FAILED++))
+fi
+
+# Test 12: Owner Accounting
+echo -e "\n${CYAN}[Test 12] Testing owner accounting and index...${RESET}"
+mkdir -p "$TEST_DIR/owned"
+head -c 100000 /dev/urandom > "$TEST_DIR/owned/data.bin"
+ln "$TEST_DIR/owned/data.bin" "$TEST_DIR/owned/link.bin"
+SCANNED=$($TEST_DIR/../bin/spacemate owners "$TEST_DIR/owned/" --json 2>/dev/null | grep -m1 -o '"apparentBytes": [0-9]*' | grep -o '[0-9]*$')
+CACHED=$(cd "$TEST_DIR/owned" && $TEST_DIR/../bin/spacemate owners . --cached --json 2>/dev/null | grep -m1 -o '"apparentBytes": [0-9]*' | grep -o '[0-9]*$')
+if [ "$SCANNED" = "100000" ] && [ "$CACHED" = "100000" ]; then
+    echo -e "${GREEN}✓ PASS: Hard link counted once, cached report found by another spelling${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Owner bytes scanned '$SCANNED', cached '$CACHED' (expected 100000)${RESET}"
+    ((FAILED++))
+fi
+rm -rf "$TEST_DIR/owned"
+
+# Test 13: Sampled Size Estimate
+echo -e "\n${CYAN}[Test 13] Testing sampled size estimate...${RESET}"
+if $TEST_DIR/../bin/spacemate scan "$TEST_DIR" --estimate --time 2 > /tmp/estimate_output.txt 2>&1; then
+    if grep -q "ESTIMATED TREE SIZE" /tmp/estimate_output.txt && grep -q "Files:" /tmp/estimate_output.txt; then
+        echo -e "${GREEN}✓ PASS: Estimate reports size and file count${RESET}"
+        ((PASSED++))
+    else
+        echo -e "${RED}✗ FAIL: Estimate output incomplete${RESET}"
+        ((FAILED++))
+    fi
+else
+    echo -e "${RED}✗ FAIL: Estimate command failed${RESET}"
+    ((FAILED++))
+fi
+
+# Test 14: Entry Count Hotspots
+echo -e "\n${CYAN}[Test 14] Testing entry count hotspots...${RESET}"
+mkdir -p "$TEST_DIR/many_entries"
+for i in $(seq 1 200); do touch "$TEST_DIR/many_entries/entry_$i"; done
+$TEST_DIR/../bin/spacemate scan "$TEST_DIR" > /tmp/hotspot_output.txt 2>&1
+if grep -A1 "Directories by Entry Count" /tmp/hotspot_output.txt | grep -q "many_entries/.*200 entries"; then
+    echo -e "${GREEN}✓ PASS: Busiest directory ranked first${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Entry count hotspot missing${RESET}"
+    ((FAILED++))
+fi
+rm -rf "$TEST_DIR/many_entries"
+
+# Test 15: Directory Growth
+echo -e "\n${CYAN}[Test 15] Testing directory growth report...${RESET}"
+mkdir -p "$TEST_DIR/growing"
+( sleep 2; dd if=/dev/zero of="$TEST_DIR/growing/blob" bs=1M count=2 2>/dev/null ) &
+$TEST_DIR/../bin/spacemate monitor "$TEST_DIR" --interval 0.5 --time 5 --growth 1 > /tmp/growth_output.txt 2>&1
+wait
+if grep -A1 "Grew the most" /tmp/growth_output.txt | grep -q "growing"; then
+    echo -e "${GREEN}✓ PASS: Growing directory reported${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Growing directory not reported${RESET}"
+    ((FAILED++))
+fi
+rm -rf "$TEST_DIR/growing"
+
+# Test 16: Live Index
+echo -e "\n${CYAN}[Test 16] Testing event-driven live index...${RESET}"
+mkdir -p "$TEST_DIR/watched"
+( sleep 1; dd if=/dev/zero of="$TEST_DIR/watched/new_file" bs=1k count=64 2>/dev/null ) &
+$TEST_DIR/../bin/spacemate watch "$TEST_DIR/watched" --time 3 > /tmp/watch_output.txt 2>&1
+wait
+if grep -q "Watching with" /tmp/watch_output.txt && grep -q "^Index: .*1 files" /tmp/watch_output.txt; then
+    echo -e "${GREEN}✓ PASS: New file picked up without a rescan${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Live index missed the new file${RESET}"
+    ((FAILED++))
+fi
+rm -rf "$TEST_DIR/watched"
+
+# Test 17: Mount Table
+echo -e "\n${CYAN}[Test 17] Testing mount table lookup...${RESET}"
+$TEST_DIR/../bin/spacemate scan "$TEST_DIR" > /tmp/mount_output.txt 2>&1
+if [ ! -r /proc/self/mountinfo ] || grep -q "Mounted On: .*(" /tmp/mount_output.txt; then
+    echo -e "${GREEN}✓ PASS: Scan reports the volume's mount${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Mount of the scanned path not found${RESET}"
+    ((FAILED++))
+fi
+
+# The backup tests keep their store and ~/.spacematerc in a home of their own
+export HOME="$TEST_DIR/home"
+mkdir -p "$HOME"
+
+# Test 18: Backup Copy Preserves Metadata
+echo -e "\n${CYAN}[Test 18] Testing backup copy metadata...${RESET}"
+mkdir -p "$TEST_DIR/backed_up"
+echo "keep me" > "$TEST_DIR/backed_up/stale.tmp"
+touch -d "2021-05-06 07:08:09" "$TEST_DIR/backed_up/stale.tmp"
+echo y | $TEST_DIR/../bin/spacemate clean "$TEST_DIR/backed_up" > /dev/null 2>&1
+BACKUP_COPY=$(echo 0 | $TEST_DIR/../bin/spacemate restore 2>/dev/null | grep -A1 "Original: $TEST_DIR/backed_up/stale.tmp$" | grep "Stored: " | tail -1 | sed 's/.*Stored: //')
+if [ -n "$BACKUP_COPY" ] && [ "$(cat "$BACKUP_COPY")" = "keep me" ] && \
+   [ "$(date -r "$BACKUP_COPY" +%Y-%m-%d)" = "2021-05-06" ]; then
+    echo -e "${GREEN}✓ PASS: Backup keeps content and modification time${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Backup copy missing or metadata lost${RESET}"
+    ((FAILED++))
+fi
+rm -rf "$TEST_DIR/backed_up"
+
+# Test 19: Identical Content Is Stored Once
+echo -e "\n${CYAN}[Test 19] Testing backup deduplication...${RESET}"
+mkdir -p "$TEST_DIR/dedup"
+for name in a b c; do echo "same bytes" > "$TEST_DIR/dedup/$name.tmp"; done
+chmod 755 "$TEST_DIR/dedup/a.tmp"
+chmod 600 "$TEST_DIR/dedup/b.tmp"
+echo y | $TEST_DIR/../bin/spacemate clean "$TEST_DIR/dedup" > /dev/null 2>&1
+DEDUP_LISTING=$(echo 0 | $TEST_DIR/../bin/spacemate restore 2>/dev/null | grep -A1 "Original: $TEST_DIR/dedup/")
+DEDUP_OBJECTS=$(echo "$DEDUP_LISTING" | grep "Stored: " | sort -u | wc -l)
+DEDUP_ENTRIES=$(echo "$DEDUP_LISTING" | grep -c "Original: ")
+# Each restored file gets its own mode back, not the shared object's
+for name in a b; do
+    DEDUP_NUMBER=$(echo 0 | $TEST_DIR/../bin/spacemate restore 2>/dev/null | grep -B1 "Original: $TEST_DIR/dedup/$name.tmp$" | head -1 | sed 's/^\[\([0-9]*\)\].*/\1/')
+    printf '%s\n' "$DEDUP_NUMBER" | $TEST_DIR/../bin/spacemate restore > /dev/null 2>&1
+done
+DEDUP_MODES="$(stat -c %a "$TEST_DIR/dedup/a.tmp" 2>/dev/null) $(stat -c %a "$TEST_DIR/dedup/b.tmp" 2>/dev/null)"
+if [ "$DEDUP_ENTRIES" = "3" ] && [ "$DEDUP_OBJECTS" = "1" ] && [ "$DEDUP_MODES" = "755 600" ]; then
+    echo -e "${GREEN}✓ PASS: Three backups share one stored object and restore their own modes${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Expected 3 entries, 1 object and modes 755 600, got $DEDUP_ENTRIES, $DEDUP_OBJECTS and $DEDUP_MODES${RESET}"
+    ((FAILED++))
+fi
+rm -rf "$TEST_DIR/dedup"
+
+# Test 20: Compressed Backup Round Trip
+echo -e "\n${CYAN}[Test 20] Testing compressed backup and restore...${RESET}"
+printf '[backup]\ncompression = zlib\n' > "$HOME/.spacematerc"
+mkdir -p "$TEST_DIR/packed"
+seq 1 200000 | sed 's/^/repeated log line /' > "$TEST_DIR/packed/big.log"
+cp "$TEST_DIR/packed/big.log" "$TEST_DIR/packed.expected"
+echo y | $TEST_DIR/../bin/spacemate clean "$TEST_DIR/packed" > /dev/null 2>&1
+PACKED_ENTRY=$(echo 0 | $TEST_DIR/../bin/spacemate restore 2>/dev/null | grep -B1 -A2 "Original: $TEST_DIR/packed/big.log$" | tail -4)
+PACKED_NUMBER=$(echo "$PACKED_ENTRY" | head -1 | sed 's/^\[\([0-9]*\)\].*/\1/')
+printf '%s\n' "$PACKED_NUMBER" | $TEST_DIR/../bin/spacemate restore > /dev/null 2>&1
+if echo "$PACKED_ENTRY" | grep -q "stored, zlib)" && \
+   cmp -s "$TEST_DIR/packed/big.log" "$TEST_DIR/packed.expected"; then
+    echo -e "${GREEN}✓ PASS: Backup stored compressed and restored intact${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Compressed backup or restore failed${RESET}"
+    ((FAILED++))
+fi
+rm -f "$HOME/.spacematerc"
+rm -rf "$TEST_DIR/packed" "$TEST_DIR/packed.expected"
+
+# Test 21: Incremental Folder Backup
+echo -e "\n${CYAN}[Test 21] Testing incremental folder backup...${RESET}"
+mkdir -p "$TEST_DIR/mirror/src/sub" "$TEST_DIR/mirror/src/locked"
+echo "changes" > "$TEST_DIR/mirror/src/changed.txt"
+echo "goes away" > "$TEST_DIR/mirror/src/deleted.txt"
+echo "stays" > "$TEST_DIR/mirror/src/sub/same.txt"
+echo "hidden later" > "$TEST_DIR/mirror/src/locked/kept.txt"
+FIRST=$($TEST_DIR/../bin/spacemate backup "$TEST_DIR/mirror/src" "$TEST_DIR/mirror/dest" 2>&1 | grep -o "[0-9]* copied")
+echo "changed content" >> "$TEST_DIR/mirror/src/changed.txt"
+rm "$TEST_DIR/mirror/src/deleted.txt"
+chmod 000 "$TEST_DIR/mirror/src/locked"
+SECOND=$($TEST_DIR/../bin/spacemate backup "$TEST_DIR/mirror/src" "$TEST_DIR/mirror/dest" 2>&1 | grep -o "[0-9]* copied, [0-9]* unchanged, [0-9]* removed")
+chmod 755 "$TEST_DIR/mirror/src/locked"
+# root still reads the locked directory, so its file counts as unchanged
+if [ "$(id -u)" = "0" ]; then EXPECTED="1 copied, 2 unchanged, 1 removed"; else EXPECTED="1 copied, 1 unchanged, 1 removed"; fi
+if [ "$FIRST" = "4 copied" ] && [ "$SECOND" = "$EXPECTED" ] && \
+   [ ! -e "$TEST_DIR/mirror/dest/deleted.txt" ] && [ -f "$TEST_DIR/mirror/dest/locked/kept.txt" ] && \
+   cmp -s "$TEST_DIR/mirror/src/changed.txt" "$TEST_DIR/mirror/dest/changed.txt"; then
+    echo -e "${GREEN}✓ PASS: Only changes copied, deleted file removed, unreadable folder kept${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: First sync '$FIRST', second '$SECOND' (expected '$EXPECTED')${RESET}"
+    ((FAILED++))
+fi
+rm -rf "$TEST_DIR/mirror"
+
+# Test 22: Small Files Packed Together
+echo -e "\n${CYAN}[Test 22] Testing packed small-file backups...${RESET}"
+printf '[backup]\npack_small_files = true\n' > "$HOME/.spacematerc"
+mkdir -p "$TEST_DIR/small"
+for i in $(seq 1 40); do echo "small file $i" > "$TEST_DIR/small/note$i.log"; done
+chmod 600 "$TEST_DIR/small/note7.log"
+cp "$TEST_DIR/small/note7.log" "$TEST_DIR/small.expected"
+echo y | $TEST_DIR/../bin/spacemate clean "$TEST_DIR/small" > /dev/null 2>&1
+SMALL_ENTRY=$(echo 0 | $TEST_DIR/../bin/spacemate restore 2>/dev/null | grep -B1 -A2 "Original: $TEST_DIR/small/note7.log$" | tail -4)
+SMALL_NUMBER=$(echo "$SMALL_ENTRY" | head -1 | sed 's/^\[\([0-9]*\)\].*/\1/')
+printf '%s\n' "$SMALL_NUMBER" | $TEST_DIR/../bin/spacemate restore > /dev/null 2>&1
+if echo "$SMALL_ENTRY" | grep -q "Stored: .*/packs/pack-[0-9]*\.pack" && \
+   cmp -s "$TEST_DIR/small/note7.log" "$TEST_DIR/small.expected" && \
+   [ "$(stat -c %a "$TEST_DIR/small/note7.log")" = "600" ]; then
+    echo -e "${GREEN}✓ PASS: Small files packed and restored intact${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Packed backup or restore failed${RESET}"
+    ((FAILED++))
+fi
+rm -f "$HOME/.spacematerc"
+rm -rf "$TEST_DIR/small" "$TEST_DIR/small.expected"
+
+# Test 23: Retention Policy
+echo -e "\n${CYAN}[Test 23] Testing backup retention...${RESET}"
+mkdir -p "$TEST_DIR/kept"
+for run in 1 2 3; do
+    echo "run $run" > "$TEST_DIR/kept/run.log"
+    echo y | $TEST_DIR/../bin/spacemate clean "$TEST_DIR/kept" > /dev/null 2>&1
+    sleep 1   # one session per second
+done
+printf '[backup]\nkeep_last = 1\n' > "$HOME/.spacematerc"
+$TEST_DIR/../bin/spacemate gc --dry-run > /dev/null 2>&1
+BEFORE=$(echo 0 | $TEST_DIR/../bin/spacemate restore 2>/dev/null | grep -c "Original: $TEST_DIR/kept/run.log$")
+$TEST_DIR/../bin/spacemate gc > /dev/null 2>&1
+AFTER=$(echo 0 | $TEST_DIR/../bin/spacemate restore 2>/dev/null | grep -c "Original: $TEST_DIR/kept/run.log$")
+if [ "$BEFORE" -ge 3 ] && [ "$AFTER" -eq 1 ]; then
+    echo -e "${GREEN}✓ PASS: Only the newest session kept${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Retention kept $AFTER of $BEFORE backups${RESET}"
+    ((FAILED++))
+fi
+rm -f "$HOME/.spacematerc"
+rm -rf "$TEST_DIR/kept"
+
+# Test 24: Backup Verification
+echo -e "\n${CYAN}[Test 24] Testing backup verification...${RESET}"
+mkdir -p "$TEST_DIR/verified"
+echo "verify me $$" > "$TEST_DIR/verified/verify.log"
+echo y | $TEST_DIR/../bin/spacemate clean "$TEST_DIR/verified" > /dev/null 2>&1
+STORED=$(echo 0 | $TEST_DIR/../bin/spacemate restore 2>/dev/null | grep -A2 "Original: $TEST_DIR/verified/verify.log$" | grep "Stored:" | tail -1 | sed 's/.*Stored: //')
+if [ -n "$STORED" ] && $TEST_DIR/../bin/spacemate verify --restart > /dev/null 2>&1; then
+    cp -p "$STORED" "$TEST_DIR/verified/object"
+    chmod u+w "$STORED"
+    echo "not what was backed up" > "$STORED"
+    if ! $TEST_DIR/../bin/spacemate verify --restart 2>/dev/null | grep -q "Corrupt: .*$STORED"; then
+        echo -e "${RED}✗ FAIL: Corrupted backup not reported${RESET}"
+        ((FAILED++))
+    else
+        echo -e "${GREEN}✓ PASS: Corrupted backup reported${RESET}"
+        ((PASSED++))
+    fi
+    cp -p "$TEST_DIR/verified/object" "$STORED"   # put the good object back
+else
+    echo -e "${RED}✗ FAIL: Backup missing or store not clean before corrupting it${RESET}"
+    ((FAILED++))
+fi
+rm -rf "$TEST_DIR/verified"
+
+# Test 25: Batch Restore
+echo -e "\n${CYAN}[Test 25] Testing batch restore...${RESET}"
+mkdir -p "$TEST_DIR/batch/nested"
+for i in 1 2 3; do echo "batch $i $$" > "$TEST_DIR/batch/nested/file$i.log"; done
+echo "kept $$" > "$TEST_DIR/batch/kept.log"
+echo y | $TEST_DIR/../bin/spacemate clean "$TEST_DIR/batch" > /dev/null 2>&1
+echo "newer" > "$TEST_DIR/batch/kept.log"
+$TEST_DIR/../bin/spacemate restore --path-prefix "$TEST_DIR/batch" --conflict skip > /dev/null 2>&1
+$TEST_DIR/../bin/spacemate restore --path-prefix "$TEST_DIR/batch/nested" --to "$TEST_DIR/batch/copy" > /dev/null 2>&1
+if [ "$(cat "$TEST_DIR/batch/nested/file2.log" 2>/dev/null)" = "batch 2 $$" ] && \
+   [ "$(cat "$TEST_DIR/batch/kept.log")" = "newer" ] && \
+   [ -f "$TEST_DIR/batch/copy$TEST_DIR/batch/nested/file3.log" ]; then
+    echo -e "${GREEN}✓ PASS: Files restored in place and under --to, existing file kept${RESET}"
+    ((PASSED++))
+else
+    echo -e "${RED}✗ FAIL: Batch restore did not restore the selected files${RESET}"
+    ((FAILED++))
+fi
+rm -rf "$TEST_DIR/batch"
+
 # Summary
 echo -e "\n${BOLD}════════════════════════════════════════${RESET}"
 echo -e "${BOLD}Test Summary${RESET}"
@@ -175,7 +459,7 @@ echo -e "Total:  $((PASSED + FAILED))"
 echo -e "${BOLD}════════════════════════════════════════${RESET}\n"
 
 # Cleanup temp files
-rm -f /tmp/analyze_output.txt /tmp/help_output.txt
+rm -f /tmp/analyze_output.txt /tmp/help_output.txt /tmp/types_output.txt /tmp/estimate_output.txt /tmp/hotspot_output.txt /tmp/growth_output.txt /tmp/watch_output.txt /tmp/mount_output.txt
 
 if [ $FAILED -eq 0 ]; then
     echo -e "${GREEN}${BOLD}✓ All tests passed!${RESET}\n"